@@ -40,6 +40,7 @@
 #include "bfd_event.h"
 #include "pidfile.h"
 #include "logger.h"
+#include "event_log.h"
 #include "signals.h"
 #include "main.h"
 #include "parser.h"
@@ -90,6 +91,8 @@ stop_bfd(int status)
 	free_bfd_data(&bfd_data);
 	free_bfd_buffer();
 	thread_destroy_master(master);
+	close_log_queue();
+	log_event(EVENT_PROCESS_STOP, 0, 0, "%s", "BFD");
 	free_parent_mallocs_exit();
 
 	/*
@@ -142,6 +145,8 @@ open_bfd_pipes(void)
 static void
 start_bfd(__attribute__((unused)) data_t *prev_global_data)
 {
+	log_event(EVENT_PROCESS_START, reload, 0, "%s", "BFD");
+
 	srandom(time(NULL));
 
 	if (reload)
@@ -201,6 +206,14 @@ start_bfd(__attribute__((unused)) data_t *prev_global_data)
 
 	/* Set the process cpu affinity if configured */
 	set_process_cpu_affinity(&global_data->bfd_cpu_mask, "bfd");
+
+	/* Limit the bulk fd threads run per wakeup if configured */
+	thread_set_budgets(master, global_data->bfd_read_budget, global_data->bfd_write_budget);
+	thread_set_slab_high_water(master, global_data->scheduler_slab_high_water);
+	thread_set_timer_slack(master, global_data->scheduler_timer_slack);
+
+	/* Queue log messages to be written when the process is idle if configured */
+	open_log_queue(global_data->log_queue_size);
 }
 
 void
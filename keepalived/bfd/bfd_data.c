@@ -30,6 +30,7 @@
 #include "memory.h"
 #include "utils.h"
 #include "main.h"
+#include "scheduler.h"
 #include "assert_debug.h"
 
 /* Global vars */
@@ -305,6 +306,7 @@ bfd_print_data(void)
 		return;
 
 	dump_bfd_data(fp, bfd_data);
+	dump_scheduler_data(master, fp);
 
 	fclose(fp);
 }
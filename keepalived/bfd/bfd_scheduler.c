@@ -36,6 +36,7 @@
 #include "bfd_event.h"
 #include "parser.h"
 #include "logger.h"
+#include "event_log.h"
 #include "memory.h"
 #include "main.h"
 #include "bitops.h"
@@ -485,6 +486,8 @@ bfd_state_fall(bfd_t *bfd, bool send_event)
 	 */
 	bfd_idle_local_tx_intv(bfd);
 
+	log_event(EVENT_BFD_STATE, bfd->local_state, bfd->local_diag, "%s", bfd->iname);
+
 	if (bfd_expire_scheduled(bfd))
 		bfd_expire_cancel(bfd);
 
@@ -548,6 +551,8 @@ bfd_state_rise(bfd_t *bfd)
 	/* RFC5880 doesn't state if this must be done or not */
 	bfd->local_diag = BFD_DIAG_NO_DIAG;
 
+	log_event(EVENT_BFD_STATE, bfd->local_state, bfd->local_diag, "%s", bfd->iname);
+
 	if (bfd->local_state == BFD_STATE_UP ||
 	    __test_bit(LOG_EXTRA_DETAIL_BIT, &debug))
 		log_message(LOG_INFO, "(%s) Entering %s state",
@@ -949,7 +954,7 @@ bfd_receiver_thread(thread_ref_t thread)
 
 	data->thread_in =
 	    thread_add_read(thread->master, bfd_receiver_thread, data,
-			    fd, TIMER_NEVER, 0);
+			    fd, TIMER_NEVER, THREAD_PRIORITY);
 }
 
 /*
@@ -1232,10 +1237,10 @@ bfd_register_workers(bfd_data_t *data)
 	/* Set timeout to not expire */
 	if (data->fd_in != -1)
 		data->thread_in = thread_add_read(master, bfd_receiver_thread,
-						  data, data->fd_in, TIMER_NEVER, 0);
+						  data, data->fd_in, TIMER_NEVER, THREAD_PRIORITY);
 	if (data->multihop_fd_in != -1)
 		data->thread_in = thread_add_read(master, bfd_receiver_thread,
-						  data, data->multihop_fd_in, TIMER_NEVER, 0);
+						  data, data->multihop_fd_in, TIMER_NEVER, THREAD_PRIORITY);
 
 	/* Resume or schedule threads */
 	list_for_each_entry(bfd, &data->bfd, e_list) {
@@ -53,6 +53,10 @@
 #endif
 #include "track_file.h"
 #include "check_parser.h"
+#include "smtp.h"
+#ifdef _WITH_CHECKER_WORKERS_
+#include "check_worker.h"
+#endif
 
 
 /* Global vars */
@@ -150,6 +154,7 @@ queue_checker(const checker_funcs_t *funcs
 	checker->delay_before_retry = ULONG_MAX;
 	checker->retry_it = 0;
 	checker->is_up = true;
+	checker->run_is_up = true;
 	checker->default_delay_before_retry = 1 * TIMER_HZ;
 	checker->default_retry = 1 ;
 
@@ -473,6 +478,106 @@ free_rs_checkers(const real_server_t *rs)
 		free_checker(checker);
 }
 
+/* Apply a change of state found by a checker, sending an smtp alert
+ * with the alert message if the state of the checker has changed. */
+void
+apply_checker_state(checker_t *checker, bool alive, const char *alert)
+{
+	bool checker_was_up = checker->is_up;
+	bool rs_was_alive = checker->rs->alive;
+
+	update_svr_checker_state(alive, checker);
+
+	if (checker->rs->smtp_alert && checker_was_up != alive &&
+	    (rs_was_alive != checker->rs->alive || !global_data->no_checker_emails))
+		smtp_alert(SMTP_MSG_RS, checker, NULL, alert);
+}
+
+/* If the checker is running in a worker thread, the change is applied
+ * later by the main thread, which owns is_up and has_run. The checker
+ * itself uses run_is_up and run_has_run, so that it doesn't report the
+ * same change again before it has been applied. */
+void
+checker_set_state(checker_t *checker, bool alive, const char *alert)
+{
+	checker->run_is_up = alive;
+	checker->run_has_run = true;
+
+#ifdef _WITH_CHECKER_WORKERS_
+	if (checker_worker_queue_state(checker, alive, alert))
+		return;
+#endif
+
+	apply_checker_state(checker, alive, alert);
+}
+
+/* Record that a checker has completed a run without changing state */
+void
+checker_set_has_run(checker_t *checker)
+{
+	if (checker->run_has_run)
+		return;
+
+	checker->run_has_run = true;
+
+#ifdef _WITH_CHECKER_WORKERS_
+	if (checker_worker_queue_has_run(checker))
+		return;
+#endif
+
+	checker->has_run = true;
+}
+
+/* Schedule the next run of a checker delay_loop after the current run
+ * was due, rather than after it completed, so that checks don't drift */
+thread_ref_t
+checker_add_timer(thread_master_t *m, thread_func_t func, checker_t *checker)
+{
+	return thread_add_timer_periodic(m, func, checker, &checker->sands, checker->delay_loop, TIMER_CATCHUP_SKIP);
+}
+
+/* A retry is run delay after the failed run completed, and the runs
+ * following it keep to its phase */
+thread_ref_t
+checker_add_retry_timer(thread_master_t *m, thread_func_t func, checker_t *checker, unsigned long delay)
+{
+	set_time_now();
+	checker->sands = timer_add_long(time_now, delay);
+
+	return thread_add_timer_sands(m, func, checker, &checker->sands);
+}
+
+/* A run is a single attempt, so a retry is counted as a run of its own */
+void
+checker_run_start(checker_t *checker)
+{
+	checker->run_start = time_now;
+}
+
+/* Only the thread running the checker writes the stats, but the main
+ * thread may read them at any time */
+void
+checker_run_end(checker_t *checker, bool success)
+{
+	checker_run_stats_t *stats = &checker->run_stats;
+
+	if (success)
+		__atomic_store_n(&stats->success, stats->success + 1, __ATOMIC_RELAXED);
+	else
+		__atomic_store_n(&stats->failure, stats->failure + 1, __ATOMIC_RELAXED);
+
+	if (timercmp(&time_now, &checker->run_start, >))
+		__atomic_store_n(&stats->duration_total, stats->duration_total + timer_long(time_now) - timer_long(checker->run_start), __ATOMIC_RELAXED);
+}
+
+void
+checker_get_run_stats(const checker_t *checker, checker_run_stats_t *stats)
+{
+	stats->success = __atomic_load_n(&checker->run_stats.success, __ATOMIC_RELAXED);
+	stats->failure = __atomic_load_n(&checker->run_stats.failure, __ATOMIC_RELAXED);
+	stats->duration_total = __atomic_load_n(&checker->run_stats.duration_total, __ATOMIC_RELAXED);
+}
+
 /* register checkers to the global I/O scheduler */
 void
 register_checkers_thread(void)
@@ -482,6 +587,8 @@ register_checkers_thread(void)
 	checker_t *checker;
 	unsigned long warmup;
 
+	set_time_now();
+
 	list_for_each_entry(vs, &check_data->vs, e_list) {
 		list_for_each_entry(rs, &vs->rs, e_list) {
 			list_for_each_entry(checker, &rs->checkers_list, rs_list) {
@@ -504,8 +611,14 @@ register_checkers_thread(void)
 						/* coverity[dont_call] */
 						warmup = warmup * (unsigned)random() / RAND_MAX;
 					}
-					thread_add_timer(master, checker->launch, checker,
-							 BOOTSTRAP_DELAY + warmup);
+					checker->sands = timer_add_long(time_now, BOOTSTRAP_DELAY + warmup);
+					checker->run_is_up = checker->is_up;
+					checker->run_has_run = checker->has_run;
+#ifdef _WITH_CHECKER_WORKERS_
+					thread_add_timer_sands(checker_worker_master(checker), checker->launch, checker, &checker->sands);
+#else
+					thread_add_timer_sands(master, checker->launch, checker, &checker->sands);
+#endif
 				}
 			}
 		}
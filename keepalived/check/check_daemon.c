@@ -58,11 +58,15 @@
 #include "process.h"
 #include "memory.h"
 #include "logger.h"
+#include "event_log.h"
 #include "main.h"
 #include "parser.h"
 #include "bitops.h"
 #include "keepalived_netlink.h"
 #include "check_print.h"
+#ifdef _WITH_CHECKER_WORKERS_
+#include "check_worker.h"
+#endif
 #ifdef _WITH_SNMP_CHECKER_
   #include "check_snmp.h"
 #endif
@@ -98,6 +102,8 @@ static unsigned check_next_restart_delay;
 static void
 set_checker_max_fds(void)
 {
+	unsigned max_fds;
+
 	/* Allow for:
 	 *   0	stdin
 	 *   1	stdout
@@ -120,7 +126,9 @@ set_checker_max_fds(void)
 	 *   One per SMTP alert
 	 *   qty 10 spare
 	 */
-	set_max_file_limit(17 + check_data->num_checker_fd_required + check_data->num_smtp_alert + 10);
+	max_fds = 17 + check_data->num_checker_fd_required + check_data->num_smtp_alert + 10;
+	set_max_file_limit(max_fds);
+	thread_set_max_fds(master, max_fds);
 }
 
 static void
@@ -164,8 +172,12 @@ checker_terminate_phase2(void)
 
 	/* Destroy master thread */
 	checker_dispatcher_release();
+	check_stats_socket_close();
+	check_metrics_socket_close();
 	thread_destroy_master(master);
 	master = NULL;
+	close_log_queue();
+	log_event(EVENT_PROCESS_STOP, 0, 0, "%s", "Checker");
 	free_ssl();
 	set_ping_group_range(false);
 
@@ -241,6 +253,11 @@ checker_terminate_phase1(bool schedule_next_thread)
 	if (using_ha_suspend || __test_bit(LOG_ADDRESS_CHANGES, &debug))
 		kernel_netlink_close();
 
+#ifdef _WITH_CHECKER_WORKERS_
+	/* The checkers must no longer be running when the services are cleared */
+	checker_workers_stop();
+#endif
+
 	if (check_data) {
 		/* Terminate all script processes */
 		if (master->child.rb_root.rb_node)
@@ -315,6 +332,8 @@ set_effective_weights(void)
 static void
 start_check(data_t *prev_global_data)
 {
+	log_event(EVENT_PROCESS_START, reload, 0, "%s", "Checker");
+
 	/* Parse configuration file */
 	if (reload)
 		global_data = alloc_global_data();
@@ -455,7 +474,13 @@ start_check(data_t *prev_global_data)
 		dump_data_check(NULL);
 
 	/* Register checkers thread */
+#ifdef _WITH_CHECKER_WORKERS_
+	checker_workers_init(global_data->checker_worker_threads);
+#endif
 	register_checkers_thread();
+#ifdef _WITH_CHECKER_WORKERS_
+	checker_workers_start();
+#endif
 
 	/* Set the process priority and non swappable if configured */
 	if (reload)
@@ -467,6 +492,19 @@ start_check(data_t *prev_global_data)
 
 	/* Set the process cpu affinity if configured */
 	set_process_cpu_affinity(&global_data->checker_cpu_mask, "checker");
+
+	/* Limit the bulk fd threads run per wakeup if configured */
+	thread_set_budgets(master, global_data->checker_read_budget, global_data->checker_write_budget);
+	thread_set_slab_high_water(master, global_data->scheduler_slab_high_water);
+	thread_set_timer_slack(master, global_data->scheduler_timer_slack);
+
+	/* Queue log messages to be written when the process is idle if configured */
+	open_log_queue(global_data->log_queue_size);
+
+	if (global_data->stats_socket)
+		check_stats_socket_open();
+	if (global_data->metrics_socket || global_data->metrics_port)
+		check_metrics_socket_open();
 }
 
 void
@@ -511,7 +549,12 @@ reload_check_thread(__attribute__((unused)) thread_ref_t thread)
 #endif
 
 	/* Destroy master thread */
+#ifdef _WITH_CHECKER_WORKERS_
+	checker_workers_stop();
+#endif
 	checker_dispatcher_release();
+	check_stats_socket_close();
+	check_metrics_socket_close();
 	thread_cleanup_master(master, true);
 	thread_add_base_threads(master, with_snmp);
 
@@ -641,6 +684,9 @@ register_check_thread_addresses(void)
 	register_check_smtp_addresses();
 	register_check_ssl_addresses();
 	register_check_tcp_addresses();
+#ifdef _WITH_CHECKER_WORKERS_
+	register_check_worker_addresses();
+#endif
 	register_check_ping_addresses();
 	register_check_udp_addresses();
 	register_check_file_addresses();
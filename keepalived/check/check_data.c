@@ -639,6 +639,7 @@ free_vs(virtual_server_t *vs)
 	free_rs_list(&vs->rs);
 	free_notify_script(&vs->notify_quorum_up);
 	free_notify_script(&vs->notify_quorum_down);
+	free_query_track(&vs->query_track);
 	FREE(vs);
 }
 
@@ -989,7 +990,7 @@ const char *
 format_vs(const virtual_server_t *vs)
 {
 	/* alloc large buffer because of unknown length of vs->vsgname */
-	static char ret[512];
+	static __thread char ret[512];
 
 	if (vs->vsgname)
 		snprintf (ret, sizeof (ret) - 1, "[%s]:%d"
@@ -1028,7 +1029,7 @@ format_vsge(const virtual_server_group_entry_t *vsge)
 const char *
 format_rs(const real_server_t *rs, const virtual_server_t *vs)
 {
-	static char buf[SOCKADDRTRIO_STR_LEN];
+	static __thread char buf[SOCKADDRTRIO_STR_LEN];
 
 	inet_sockaddrtotrio_r(&rs->addr, vs->service_type, buf);
 
@@ -1172,9 +1173,7 @@ validate_check_config(void)
 				if (rs_iseq(rs, rs1)) {
 					report_config_error(CONFIG_GENERAL_ERROR, "VS %s: real server %s is duplicated - removing second rs", FMT_VS(vs), FMT_RS(rs, vs));
 					free_rs(rs);
-#ifdef _WITH_SNMP_CHECKER_
 					vs->rs_cnt--;
-#endif
 					rs_removed = true;
 					break;
 				}
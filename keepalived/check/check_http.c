@@ -332,6 +332,23 @@ free_http_check(checker_t *checker)
 	FREE(checker);
 }
 
+/* The regex match data and JIT stack are shared by all checkers */
+bool
+http_check_uses_regex(__attribute__((unused)) const checker_t *checker)
+{
+#ifdef _WITH_REGEX_CHECK_
+	const http_checker_t *http_get_chk = checker->data;
+	const url_t *url;
+
+	list_for_each_entry(url, &http_get_chk->url, e_list) {
+		if (url->regex)
+			return true;
+	}
+#endif
+
+	return false;
+}
+
 static void
 dump_http_check(FILE *fp, const checker_t *checker)
 {
@@ -1056,8 +1073,9 @@ epilog(thread_ref_t thread, register_checker_t method)
 	http_checker_t *http_get_check = CHECKER_ARG(checker);
 	request_t *req = http_get_check->req;
 	unsigned long delay = 0;
-	bool checker_was_up;
-	bool rs_was_alive;
+
+	/* Each URL is a run of its own */
+	checker_run_end(checker, method == REGISTER_CHECKER_NEW);
 
 	if (method == REGISTER_CHECKER_NEW) {
 		if (list_is_last(&http_get_check->url_it->e_list, &http_get_check->url))
@@ -1072,19 +1090,13 @@ epilog(thread_ref_t thread, register_checker_t method)
 		/* Check completed. All the url have been successfully checked.
 		 * check if server is currently alive.
 		 */
-		if (!checker->is_up || !checker->has_run) {
+		if (!checker->run_is_up || !checker->run_has_run) {
 			log_message(LOG_INFO, "Remote Web server %s succeed on service."
 					    , FMT_CHK(checker));
-			checker_was_up = checker->is_up;
-			rs_was_alive = checker->rs->alive;
-			update_svr_checker_state(UP, checker);
-			if (!checker_was_up && checker->rs->smtp_alert &&
-			    (rs_was_alive != checker->rs->alive || !global_data->no_checker_emails))
-				smtp_alert(SMTP_MSG_RS, checker, NULL,
-					   "=> CHECK succeed on service <=");
+			checker_set_state(checker, UP, "=> CHECK succeed on service <=");
 
 			/* We have done all the checks, so mark as has run */
-			checker->has_run = true;
+			checker_set_has_run(checker);
 		}
 
 		/* Reset it counters */
@@ -1098,8 +1110,8 @@ epilog(thread_ref_t thread, register_checker_t method)
 	 * servers.
 	 */
 	else if (method == REGISTER_CHECKER_RETRY && checker->retry_it > checker->retry) {
-		if (checker->is_up || !checker->has_run) {
-			if (checker->has_run && checker->retry)
+		if (checker->run_is_up || !checker->run_has_run) {
+			if (checker->run_has_run && checker->retry)
 				log_message(LOG_INFO
 				   , "%s_CHECK on service %s failed after %u retries."
 				   , (http_get_check->proto == PROTO_SSL) ? "SSL" : "HTTP"
@@ -1110,14 +1122,8 @@ epilog(thread_ref_t thread, register_checker_t method)
 				   , "%s_CHECK on service %s failed."
 				   , (http_get_check->proto == PROTO_SSL) ? "SSL" : "HTTP"
 				   , FMT_CHK(checker));
-			checker_was_up = checker->is_up;
-			rs_was_alive = checker->rs->alive;
-			update_svr_checker_state(DOWN, checker);
-			if (checker_was_up && checker->rs->smtp_alert &&
-			    (rs_was_alive != checker->rs->alive || !global_data->no_checker_emails))
-				smtp_alert(SMTP_MSG_RS, checker, NULL,
-					   "=> CHECK failed on service"
-					   " : HTTP/SSL request failed <=");
+			checker_set_state(checker, DOWN, "=> CHECK failed on service"
+							 " : HTTP/SSL request failed <=");
 		}
 
 		/* Mark we have a failed URL */
@@ -1132,8 +1138,7 @@ epilog(thread_ref_t thread, register_checker_t method)
 
 	/* register next timer thread */
 	if (method == REGISTER_CHECKER_NEW) {
-		delay = checker->delay_loop;
-		if (!checker->has_run)
+		if (!checker->run_has_run)
 			checker->retry_it = checker->retry;
 	}
 	else if (http_get_check->failed_url)
@@ -1152,11 +1157,13 @@ epilog(thread_ref_t thread, register_checker_t method)
 	 * If the checker is not up, but we are not aware of any failure,
 	 * don't delay the checks if fast_recovery option specified. */
 	if (http_get_check->fast_recovery &&
-	    (!checker->has_run ||
-	     (!checker->is_up && !http_get_check->failed_url)))
+	    (!checker->run_has_run ||
+	     (!checker->run_is_up && !http_get_check->failed_url)))
 		thread_add_event(thread->master, http_connect_thread, checker, 0);
+	else if (method == REGISTER_CHECKER_NEW)
+		checker_add_timer(thread->master, http_connect_thread, checker);
 	else
-		thread_add_timer(thread->master, http_connect_thread, checker, delay);
+		checker_add_retry_timer(thread->master, http_connect_thread, checker, delay);
 
 	return;
 }
@@ -1167,7 +1174,7 @@ timeout_epilog(thread_ref_t thread, const char *debug_msg)
 	checker_t *checker = THREAD_ARG(thread);
 
 	/* check if server is currently alive */
-	if (checker->is_up || !checker->has_run) {
+	if (checker->run_is_up || !checker->run_has_run) {
 		if (((http_checker_t *)checker->data)->genhash_flags & GENHASH) {
 			printf("%s\n", debug_msg);
 			thread_add_terminate_event(thread->master);
@@ -1177,7 +1184,7 @@ timeout_epilog(thread_ref_t thread, const char *debug_msg)
 			log_message(LOG_INFO, "%s server %s."
 					    , debug_msg
 					    , FMT_CHK(checker));
-		checker->has_run = true;
+		checker_set_has_run(checker);
 		epilog(thread, REGISTER_CHECKER_RETRY);
 		return;
 	}
@@ -1456,7 +1463,7 @@ http_handle_response(thread_ref_t thread, unsigned char digest[MD5_DIGEST_LENGTH
 	}
 #endif
 
-	if (!checker->is_up) {
+	if (!checker->run_is_up) {
 		log_message(LOG_INFO,
 			"%s success to %s url(%s)", msg
 			, FMT_CHK(checker)
@@ -1834,6 +1841,8 @@ http_connect_thread(thread_ref_t thread)
 		return;
 	}
 
+	checker_run_start(checker);
+
 	/* if there are no URLs in list, enable server w/o checking */
 	fetched_url = fetch_next_url(http_get_check);
 	if (!fetched_url) {
@@ -289,6 +289,8 @@ misc_check_thread(thread_ref_t thread)
 		return;
 	}
 
+	checker_run_start(checker);
+
 	/* Execute the script in a child process. Parent returns, child doesn't */
 	ret = system_call_script(thread->master, misc_check_child_thread,
 				  checker, (misck_checker->timeout) ? misck_checker->timeout : checker->vs->delay_loop,
@@ -366,6 +368,11 @@ misc_check_child_thread(thread_ref_t thread)
 
 	wait_status = THREAD_CHILD_STATUS(thread);
 
+	/* This is the same test of the exit status as below */
+	checker_run_end(checker, WIFEXITED(wait_status) &&
+				 (!WEXITSTATUS(wait_status) ||
+				  (misck_checker->dynamic && WEXITSTATUS(wait_status) >= 2)));
+
 	if (WIFEXITED(wait_status)) {
 		unsigned status = WEXITSTATUS(wait_status);
 		int64_t effective_weight;
@@ -298,11 +298,14 @@ icmp_epilog(thread_ref_t thread, bool is_success)
 {
 	checker_t *checker;
 	unsigned long delay;
+	bool retry = false;
 	bool checker_was_up;
 	bool rs_was_alive;
 
 	checker = THREAD_ARG(thread);
 
+	checker_run_end(checker, is_success);
+
 	delay = checker->delay_loop;
 	if (is_success || ((checker->is_up || !checker->has_run) && checker->retry_it >= checker->retry)) {
 		checker->retry_it = 0;
@@ -338,6 +341,7 @@ icmp_epilog(thread_ref_t thread, bool is_success)
 		}
 	} else if (checker->is_up) {
 		delay = checker->delay_before_retry;
+		retry = true;
 		++checker->retry_it;
 	}
 
@@ -347,7 +351,10 @@ icmp_epilog(thread_ref_t thread, bool is_success)
 		thread_add_read(thread->master, icmp_ping_thread, checker, thread->u.f.fd, delay, THREAD_DESTROY_CLOSE_FD);
 	else {
 		thread_close_fd(thread);
-		thread_add_timer(thread->master, icmp_connect_thread, checker, delay);
+		if (retry)
+			checker_add_retry_timer(thread->master, icmp_connect_thread, checker, delay);
+		else
+			checker_add_timer(thread->master, icmp_connect_thread, checker);
 	}
 }
 
@@ -392,6 +399,7 @@ icmp_ping_thread(thread_ref_t thread)
 
 	if (thread->type == THREAD_READ_TIMEOUT) {
 		/* Send next ICMP echo request */
+		checker_run_start(checker);
 		if (co->dst.ss_family == AF_INET)
 			status = ping_it(thread->u.f.fd, checker, co);
 		else
@@ -435,6 +443,8 @@ icmp_connect_thread(thread_ref_t thread)
 		return;
 	}
 
+	checker_run_start(checker);
+
 	/*
 	 * If we config a real server in several virtual server, the icmp_ratelimit should be cancelled.
 	 * echo 0 > /proc/sys/net/ipv4/icmp_ratelimit
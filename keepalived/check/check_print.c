@@ -23,6 +23,7 @@
 
 #include "config.h"
 
+#include <stddef.h>
 #include <string.h>
 
 #include "logger.h"
@@ -31,6 +32,14 @@
 #include "check_print.h"
 #include "check_data.h"
 #include "utils.h"
+#include "scheduler.h"
+#include "query_socket.h"
+#include "metrics.h"
+#include "check_api.h"
+#include "ipvswrapper.h"
+#ifdef _WITH_CHECKER_WORKERS_
+#include "check_worker.h"
+#endif
 
 
 void
@@ -44,6 +53,300 @@ check_print_data(void)
 		return;
 
 	dump_data_check(fp);
+	dump_scheduler_data(master, fp);
+#ifdef _WITH_CHECKER_WORKERS_
+	dump_checker_workers(fp);
+#endif
 
 	fclose(fp);
 }
+
+static query_socket_t *stats_socket;
+
+static void
+check_query_vs(query_buf_t *b, virtual_server_t *vs)
+{
+	real_server_t *rs;
+
+	query_printf(b, "virtual_server %s\n", FMT_VS(vs));
+	query_printf(b, "alive %d\n", vs->alive);
+	query_printf(b, "quorum %u\n", vs->quorum);
+	query_printf(b, "quorum_up %d\n", vs->quorum_state_up);
+
+	/* One line per value, so that changes only report what has changed */
+	list_for_each_entry(rs, &vs->rs, e_list) {
+		query_printf(b, "real_server %s alive %d\n", FMT_RS(rs, vs), rs->alive);
+		query_printf(b, "real_server %s weight %d\n", FMT_RS(rs, vs), real_weight(rs->effective_weight));
+		query_printf(b, "real_server %s failed_checkers %u\n", FMT_RS(rs, vs), rs->num_failed_checkers);
+	}
+	if (vs->s_svr)
+		query_printf(b, "sorry_server %s alive %d\n", FMT_RS(vs->s_svr, vs), vs->s_svr->alive);
+}
+
+static void
+check_stats_query(query_buf_t *b, const query_req_t *req)
+{
+	virtual_server_t *vs;
+	size_t start;
+
+	list_for_each_entry(vs, &check_data->vs, e_list) {
+		if (!query_match(req, FMT_VS(vs)))
+			continue;
+
+		if (req->cmd == QUERY_LIST) {
+			query_printf(b, "%s\n", FMT_VS(vs));
+			continue;
+		}
+
+		start = b->len;
+		check_query_vs(b, vs);
+		query_object_end(b, start, &vs->query_track, req);
+	}
+}
+
+void
+check_stats_socket_open(void)
+{
+	const char *path;
+
+	path = make_file_name(global_data->stats_socket, "checker",
+			      global_data->network_namespace, global_data->instance_name);
+	stats_socket = open_query_socket(path, check_stats_query, QUERY_REQUEST);
+	FREE_CONST(path);
+}
+
+void
+check_stats_socket_close(void)
+{
+	close_query_socket(&stats_socket);
+}
+
+static query_socket_t *metrics_socket;
+static query_socket_t *metrics_port_socket;
+
+/* Indexed by checker_type_t */
+static const char * const checker_type_names[] = {
+	"misc", "tcp", "udp", "dns", "http", "ssl", "smtp", "bfd", "ping", "file"
+};
+
+#ifdef _WITH_LVS_64BIT_STATS_
+typedef struct ip_vs_stats64 check_ipvs_stats_t;
+#else
+typedef struct ip_vs_stats_user check_ipvs_stats_t;
+#endif
+
+typedef struct _ipvs_stat_metric {
+	const char	*name;
+	const char	*help;
+	const char	*direction;
+	size_t		offset;
+	bool		is_64;
+} ipvs_stat_metric_t;
+
+#define IPVS_STAT_METRIC(name, direction, field, help) \
+	{ name, help, direction, offsetof(check_ipvs_stats_t, field), sizeof(((check_ipvs_stats_t *)NULL)->field) == sizeof(uint64_t) }
+
+/* The entries of a family must be consecutive */
+static const ipvs_stat_metric_t ipvs_stat_metrics[] = {
+	IPVS_STAT_METRIC("connections", NULL, conns, "Connections scheduled"),
+	IPVS_STAT_METRIC("packets", "in", inpkts, "Packets"),
+	IPVS_STAT_METRIC("packets", "out", outpkts, "Packets"),
+	IPVS_STAT_METRIC("bytes", "in", inbytes, "Bytes"),
+	IPVS_STAT_METRIC("bytes", "out", outbytes, "Bytes"),
+};
+
+static uint64_t
+ipvs_stat_value(const check_ipvs_stats_t *stats, const ipvs_stat_metric_t *stat)
+{
+	const char *counters = PTR_CAST_CONST(char, stats);
+
+	return stat->is_64 ? *PTR_CAST_CONST(uint64_t, counters + stat->offset)
+			   : *PTR_CAST_CONST(uint32_t, counters + stat->offset);
+}
+
+/* The IPVS counters are read from the kernel at most every
+ * snmp_vs_stats_update_interval and snmp_rs_stats_update_interval */
+static void
+check_metrics_ipvs(query_buf_t *b)
+{
+	const ipvs_stat_metric_t *stat;
+	const char *vs_labels[] = { "virtual_server", NULL, NULL, NULL, NULL };
+	const char *rs_labels[] = { "virtual_server", NULL, "real_server", NULL, NULL, NULL, NULL };
+	char name[64];
+	virtual_server_t *vs;
+	real_server_t *rs;
+
+	list_for_each_entry(vs, &check_data->vs, e_list) {
+		ipvs_vs_update_stats(vs);
+		ipvs_rs_update_stats(vs);
+	}
+
+	for (stat = ipvs_stat_metrics; stat < ipvs_stat_metrics + sizeof(ipvs_stat_metrics) / sizeof(ipvs_stat_metrics[0]); stat++) {
+		snprintf(name, sizeof(name), "keepalived_ipvs_virtual_server_%s", stat->name);
+		if (stat == ipvs_stat_metrics || strcmp(stat->name, stat[-1].name))
+			metrics_family(b, name, METRICS_COUNTER, stat->help);
+		strcat(name, "_total");
+		vs_labels[2] = stat->direction ? "direction" : NULL;
+		vs_labels[3] = stat->direction;
+		list_for_each_entry(vs, &check_data->vs, e_list) {
+			vs_labels[1] = FMT_VS(vs);
+			metrics_uint(b, name, vs_labels, ipvs_stat_value(&vs->stats, stat));
+		}
+	}
+
+	for (stat = ipvs_stat_metrics; stat < ipvs_stat_metrics + sizeof(ipvs_stat_metrics) / sizeof(ipvs_stat_metrics[0]); stat++) {
+		snprintf(name, sizeof(name), "keepalived_ipvs_real_server_%s", stat->name);
+		if (stat == ipvs_stat_metrics || strcmp(stat->name, stat[-1].name))
+			metrics_family(b, name, METRICS_COUNTER, stat->help);
+		strcat(name, "_total");
+		rs_labels[4] = stat->direction ? "direction" : NULL;
+		rs_labels[5] = stat->direction;
+		list_for_each_entry(vs, &check_data->vs, e_list) {
+			rs_labels[1] = FMT_VS(vs);
+			list_for_each_entry(rs, &vs->rs, e_list) {
+				rs_labels[3] = FMT_RS(rs, vs);
+				metrics_uint(b, name, rs_labels, ipvs_stat_value(&rs->stats, stat));
+			}
+		}
+	}
+	rs_labels[4] = NULL;
+
+	metrics_family(b, "keepalived_ipvs_real_server_active_connections", METRICS_GAUGE, "Active connections");
+	list_for_each_entry(vs, &check_data->vs, e_list) {
+		rs_labels[1] = FMT_VS(vs);
+		list_for_each_entry(rs, &vs->rs, e_list) {
+			rs_labels[3] = FMT_RS(rs, vs);
+			metrics_uint(b, "keepalived_ipvs_real_server_active_connections", rs_labels, rs->activeconns);
+		}
+	}
+
+	metrics_family(b, "keepalived_ipvs_real_server_inactive_connections", METRICS_GAUGE, "Inactive connections");
+	list_for_each_entry(vs, &check_data->vs, e_list) {
+		rs_labels[1] = FMT_VS(vs);
+		list_for_each_entry(rs, &vs->rs, e_list) {
+			rs_labels[3] = FMT_RS(rs, vs);
+			metrics_uint(b, "keepalived_ipvs_real_server_inactive_connections", rs_labels, rs->inactconns);
+		}
+	}
+}
+
+static void
+check_metrics_checkers(query_buf_t *b)
+{
+	const char *labels[] = { "virtual_server", NULL, "real_server", NULL, "type", NULL, "id", NULL, NULL, NULL, NULL };
+	virtual_server_t *vs;
+	real_server_t *rs;
+	checker_t *checker;
+	checker_run_stats_t stats;
+	char id[12];
+	unsigned i;
+	int pass;
+
+	/* Each family is a pass over all the checkers */
+	metrics_family(b, "keepalived_checker_up", METRICS_GAUGE, "Checker result");
+	for (pass = 0; pass < 3; pass++) {
+		if (pass == 1)
+			metrics_family(b, "keepalived_checker_runs", METRICS_COUNTER, "Completed checker runs");
+		else if (pass == 2)
+			metrics_family(b, "keepalived_checker_run_seconds", METRICS_SUMMARY, "Duration of checker runs");
+
+		list_for_each_entry(vs, &check_data->vs, e_list) {
+			labels[1] = FMT_VS(vs);
+			list_for_each_entry(rs, &vs->rs, e_list) {
+				labels[3] = FMT_RS(rs, vs);
+				i = 0;
+				list_for_each_entry(checker, &rs->checkers_list, rs_list) {
+					labels[5] = checker->checker_funcs->type < sizeof(checker_type_names) / sizeof(checker_type_names[0])
+							? checker_type_names[checker->checker_funcs->type] : "unknown";
+					snprintf(id, sizeof(id), "%u", i++);
+					labels[7] = id;
+
+					if (pass == 0)
+						metrics_uint(b, "keepalived_checker_up", labels, checker->is_up);
+					else if (pass == 1) {
+						checker_get_run_stats(checker, &stats);
+						labels[8] = "result";
+						labels[9] = "success";
+						metrics_uint(b, "keepalived_checker_runs_total", labels, stats.success);
+						labels[9] = "failure";
+						metrics_uint(b, "keepalived_checker_runs_total", labels, stats.failure);
+						labels[8] = NULL;
+					} else {
+						checker_get_run_stats(checker, &stats);
+						metrics_uint(b, "keepalived_checker_run_seconds_count", labels,
+							     stats.success + stats.failure);
+						metrics_usecs(b, "keepalived_checker_run_seconds_sum", labels, stats.duration_total);
+					}
+				}
+			}
+		}
+	}
+}
+
+static void
+check_metrics(query_buf_t *b, __attribute__((unused)) const query_req_t *req)
+{
+	const char *vs_labels[] = { "virtual_server", NULL, NULL };
+	const char *rs_labels[] = { "virtual_server", NULL, "real_server", NULL, NULL };
+	virtual_server_t *vs;
+	real_server_t *rs;
+
+	metrics_family(b, "keepalived_virtual_server_alive", METRICS_GAUGE, "Virtual server is in service");
+	list_for_each_entry(vs, &check_data->vs, e_list) {
+		vs_labels[1] = FMT_VS(vs);
+		metrics_uint(b, "keepalived_virtual_server_alive", vs_labels, vs->alive);
+	}
+
+	metrics_family(b, "keepalived_virtual_server_quorum_up", METRICS_GAUGE, "Virtual server quorum is met");
+	list_for_each_entry(vs, &check_data->vs, e_list) {
+		vs_labels[1] = FMT_VS(vs);
+		metrics_uint(b, "keepalived_virtual_server_quorum_up", vs_labels, vs->quorum_state_up);
+	}
+
+	metrics_family(b, "keepalived_real_server_alive", METRICS_GAUGE, "Real server is in service");
+	list_for_each_entry(vs, &check_data->vs, e_list) {
+		rs_labels[1] = FMT_VS(vs);
+		list_for_each_entry(rs, &vs->rs, e_list) {
+			rs_labels[3] = FMT_RS(rs, vs);
+			metrics_uint(b, "keepalived_real_server_alive", rs_labels, rs->alive);
+		}
+	}
+
+	metrics_family(b, "keepalived_real_server_weight", METRICS_GAUGE, "Real server weight");
+	list_for_each_entry(vs, &check_data->vs, e_list) {
+		rs_labels[1] = FMT_VS(vs);
+		list_for_each_entry(rs, &vs->rs, e_list) {
+			rs_labels[3] = FMT_RS(rs, vs);
+			metrics_int(b, "keepalived_real_server_weight", rs_labels, real_weight(rs->effective_weight));
+		}
+	}
+
+	check_metrics_checkers(b);
+	check_metrics_ipvs(b);
+
+	dump_scheduler_metrics(master, b);
+	metrics_eof(b);
+}
+
+void
+check_metrics_socket_open(void)
+{
+	const char *path;
+
+	if (global_data->metrics_socket) {
+		path = make_file_name(global_data->metrics_socket, "checker",
+				      global_data->network_namespace, global_data->instance_name);
+		metrics_socket = open_query_socket(path, check_metrics, QUERY_HTTP);
+		FREE_CONST(path);
+	}
+
+	if (global_data->metrics_port)
+		metrics_port_socket = open_query_socket_port(global_data->metrics_port + 1, check_metrics, QUERY_HTTP);
+}
+
+void
+check_metrics_socket_close(void)
+{
+	close_query_socket(&metrics_socket);
+	close_query_socket(&metrics_port_socket);
+}
@@ -333,6 +333,8 @@ smtp_final(thread_ref_t thread, const char *format, ...)
 	bool checker_was_up;
 	bool rs_was_alive;
 
+	checker_run_end(checker, !format);
+
 	/* Error or no error we should always have to close the socket */
 	if (thread->type != THREAD_READY_TIMER)
 		thread_close_fd(thread);
@@ -800,6 +802,8 @@ smtp_connect_thread(thread_ref_t thread)
 		return;
 	}
 
+	checker_run_start(checker);
+
 	smtp_host = checker->co;
 
 	/* Create the socket, failing here should be an oddity */
@@ -96,29 +96,22 @@ static void
 tcp_epilog(thread_ref_t thread, bool is_success)
 {
 	checker_t *checker;
-	unsigned long delay;
-	bool checker_was_up;
-	bool rs_was_alive;
+	bool retry = false;
 
 	checker = THREAD_ARG(thread);
 
-	delay = checker->delay_loop;
-	if (is_success || ((checker->is_up || !checker->has_run) && checker->retry_it >= checker->retry)) {
+	checker_run_end(checker, is_success);
+
+	if (is_success || ((checker->run_is_up || !checker->run_has_run) && checker->retry_it >= checker->retry)) {
 		checker->retry_it = 0;
 
-		if (is_success && (!checker->is_up || !checker->has_run)) {
+		if (is_success && (!checker->run_is_up || !checker->run_has_run)) {
 			log_message(LOG_INFO, "TCP connection to %s success."
 					, FMT_CHK(checker));
-			checker_was_up = checker->is_up;
-			rs_was_alive = checker->rs->alive;
-			update_svr_checker_state(UP, checker);
-			if (checker->rs->smtp_alert && !checker_was_up &&
-			    (rs_was_alive != checker->rs->alive || !global_data->no_checker_emails))
-				smtp_alert(SMTP_MSG_RS, checker, NULL,
-					   "=> TCP CHECK succeed on service <=");
+			checker_set_state(checker, UP, "=> TCP CHECK succeed on service <=");
 		} else if (!is_success &&
-			   (checker->is_up || !checker->has_run)) {
-			if (checker->retry && checker->has_run)
+			   (checker->run_is_up || !checker->run_has_run)) {
+			if (checker->retry && checker->run_has_run)
 				log_message(LOG_INFO
 				    , "TCP_CHECK on service %s failed after %u retries."
 				    , FMT_CHK(checker)
@@ -127,23 +120,20 @@ tcp_epilog(thread_ref_t thread, bool is_success)
 				log_message(LOG_INFO
 				    , "TCP_CHECK on service %s failed."
 				    , FMT_CHK(checker));
-			checker_was_up = checker->is_up;
-			rs_was_alive = checker->rs->alive;
-			update_svr_checker_state(DOWN, checker);
-			if (checker->rs->smtp_alert && checker_was_up &&
-			    (rs_was_alive != checker->rs->alive || !global_data->no_checker_emails))
-				smtp_alert(SMTP_MSG_RS, checker, NULL,
-					   "=> TCP CHECK failed on service <=");
+			checker_set_state(checker, DOWN, "=> TCP CHECK failed on service <=");
 		}
-	} else if (checker->is_up) {
-		delay = checker->delay_before_retry;
+	} else if (checker->run_is_up) {
+		retry = true;
 		++checker->retry_it;
 	}
 
-	checker->has_run = true;
+	checker_set_has_run(checker);
 
 	/* Register next timer checker */
-	thread_add_timer(thread->master, tcp_connect_thread, checker, delay);
+	if (retry)
+		checker_add_retry_timer(thread->master, tcp_connect_thread, checker, checker->delay_before_retry);
+	else
+		checker_add_timer(thread->master, tcp_connect_thread, checker);
 }
 
 static void
@@ -166,14 +156,14 @@ tcp_check_thread(thread_ref_t thread)
 		tcp_epilog(thread, true);
 		break;
 	case connect_timeout:
-		if (checker->is_up &&
+		if (checker->run_is_up &&
 		    (global_data->checker_log_all_failures || checker->log_all_failures))
 			log_message(LOG_INFO, "TCP connection to %s timeout."
 					, FMT_CHK(checker));
 		tcp_epilog(thread, false);
 		break;
 	default:
-		if (checker->is_up &&
+		if (checker->run_is_up &&
 		    (global_data->checker_log_all_failures || checker->log_all_failures))
 			log_message(LOG_INFO, "TCP connection to %s failed."
 					, FMT_CHK(checker));
@@ -199,6 +189,8 @@ tcp_connect_thread(thread_ref_t thread)
 		return;
 	}
 
+	checker_run_start(checker);
+
 	if ((fd = socket(co->dst.ss_family, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, IPPROTO_TCP)) == -1) {
 		log_message(LOG_INFO, "TCP connect fail to create socket. Rescheduling.");
 		thread_add_timer(thread->master, tcp_connect_thread, checker,
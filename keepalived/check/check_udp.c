@@ -202,13 +202,14 @@ static void
 udp_epilog(thread_ref_t thread, bool is_success)
 {
 	checker_t *checker;
-	unsigned long delay;
+	bool retry = false;
 	bool checker_was_up;
 	bool rs_was_alive;
 
 	checker = THREAD_ARG(thread);
 
-	delay = checker->delay_loop;
+	checker_run_end(checker, is_success);
+
 	if (is_success || ((checker->is_up || !checker->has_run) && checker->retry_it >= checker->retry)) {
 		checker->retry_it = 0;
 
@@ -242,13 +243,16 @@ udp_epilog(thread_ref_t thread, bool is_success)
 					   "=> UDP CHECK failed on service <=");
 		}
 	} else if (checker->is_up) {
-		delay = checker->delay_before_retry;
+		retry = true;
 		++checker->retry_it;
 	}
 
 	checker->has_run = true;
 
-	thread_add_timer(thread->master, udp_connect_thread, checker, delay);
+	if (retry)
+		checker_add_retry_timer(thread->master, udp_connect_thread, checker, checker->delay_before_retry);
+	else
+		checker_add_timer(thread->master, udp_connect_thread, checker);
 }
 
 static bool
@@ -336,6 +340,8 @@ udp_connect_thread(thread_ref_t thread)
 		return;
 	}
 
+	checker_run_start(checker);
+
 	if ((fd = socket(co->dst.ss_family, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, IPPROTO_UDP)) == -1) {
 		log_message(LOG_INFO, "UDP connect fail to create socket. Rescheduling.");
 		thread_add_timer(thread->master, udp_connect_thread, checker,
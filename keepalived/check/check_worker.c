@@ -0,0 +1,317 @@
+/*
+ * Soft:        Keepalived is a failover program for the LVS project
+ *              <www.linuxvirtualserver.org>. It monitor & manipulate
+ *              a loadbalanced server pool using multi-layer checks.
+ *
+ * Part:        Checker worker threads. Checkers that only use their own
+ *              sockets can be sharded across worker threads, each running
+ *              its own scheduler, so that busy HTTP/SSL checks are not
+ *              limited to one core. Changes of checker state are passed
+ *              back to the main thread, which does all IPVS updates.
+ *
+ * Author:      Alexandre Cassen, <acassen@linux-vs.org>
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *              See the GNU General Public License for more details.
+ *
+ *              This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU General Public License
+ *              as published by the Free Software Foundation; either version
+ *              2 of the License, or (at your option) any later version.
+ *
+ * Copyright (C) 2026 Alexandre Cassen, <acassen@gmail.com>
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include "check_worker.h"
+#include "check_http.h"
+#include "global_data.h"
+#include "logger.h"
+#include "memory.h"
+#include "utils.h"
+
+
+typedef struct _checker_worker {
+	pthread_t		thread;
+	thread_master_t		*master;
+	int			stop_fd;	/* eventfd, written to stop the worker */
+	unsigned		num_checkers;
+	bool			running;
+} checker_worker_t;
+
+/* A change of checker state found by a worker */
+typedef struct _checker_result {
+	checker_t		*checker;
+	bool			set_state;	/* else only has_run is to be set */
+	bool			alive;
+	const char		*alert;
+	struct _checker_result	*next;
+} checker_result_t;
+
+/* Local variables */
+static checker_worker_t *workers;
+static unsigned num_workers;
+static unsigned next_worker;
+static int result_fd = -1;
+static thread_ref_t result_thread;
+static _Atomic(checker_result_t *) results;	/* pushed by the workers, newest first */
+static __thread bool in_worker;
+
+static bool
+checker_worker_eligible(const checker_t *checker)
+{
+	/* The checkers must not fork, use the netlink or inotify fds
+	 * of the main thread, or share state with other checkers. */
+	switch (checker->checker_funcs->type) {
+	case CHECKER_TCP:
+		return true;
+	case CHECKER_HTTP:
+	case CHECKER_SSL:
+		return !http_check_uses_regex(checker);
+	default:
+		return false;
+	}
+}
+
+thread_master_t *
+checker_worker_master(const checker_t *checker)
+{
+	checker_worker_t *worker;
+
+	if (!num_workers || !checker_worker_eligible(checker))
+		return master;
+
+	worker = &workers[next_worker++ % num_workers];
+	worker->num_checkers++;
+
+	return worker->master;
+}
+
+/* Called on a worker thread. The list is lock free, the main thread
+ * taking the whole list each time it is woken. */
+static bool
+checker_worker_queue(checker_t *checker, bool set_state, bool alive, const char *alert)
+{
+	checker_result_t *res, *head;
+	uint64_t one = 1;
+
+	if (!in_worker)
+		return false;
+
+	PMALLOC(res);
+	res->checker = checker;
+	res->set_state = set_state;
+	res->alive = alive;
+	res->alert = alert;
+
+	head = atomic_load_explicit(&results, memory_order_relaxed);
+	do {
+		res->next = head;
+	} while (!atomic_compare_exchange_weak_explicit(&results, &head, res, memory_order_release, memory_order_relaxed));
+
+	/* If the list wasn't empty, the main thread has already been woken */
+	if (!head && write(result_fd, &one, sizeof(one)) != sizeof(one))
+		log_message(LOG_INFO, "Checker worker unable to wake main thread (%m)");
+
+	return true;
+}
+
+bool
+checker_worker_queue_state(checker_t *checker, bool alive, const char *alert)
+{
+	return checker_worker_queue(checker, true, alive, alert);
+}
+
+bool
+checker_worker_queue_has_run(checker_t *checker)
+{
+	return checker_worker_queue(checker, false, false, NULL);
+}
+
+static void
+checker_results_process(void)
+{
+	checker_result_t *res, *next, *list = NULL;
+
+	res = atomic_exchange_explicit(&results, NULL, memory_order_acquire);
+
+	/* Restore the order the results were queued in */
+	for (; res; res = next) {
+		next = res->next;
+		res->next = list;
+		list = res;
+	}
+
+	for (res = list; res; res = next) {
+		next = res->next;
+		if (res->set_state)
+			apply_checker_state(res->checker, res->alive, res->alert);
+		else
+			res->checker->has_run = true;
+		FREE(res);
+	}
+}
+
+static void
+checker_results_thread(thread_ref_t thread)
+{
+	uint64_t count;
+
+	if (read(result_fd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+		log_message(LOG_INFO, "Error reading checker worker results fd (%m)");
+
+	checker_results_process();
+
+	result_thread = thread_add_read(thread->master, checker_results_thread, NULL, result_fd, TIMER_NEVER, THREAD_PRIORITY);
+}
+
+static void
+checker_worker_stop_thread(thread_ref_t thread)
+{
+	thread_add_terminate_event(thread->master);
+}
+
+static void *
+checker_worker_run(void *arg)
+{
+	checker_worker_t *worker = arg;
+	sigset_t sigs;
+
+	/* All signals are handled by the main thread */
+	sigfillset(&sigs);
+	pthread_sigmask(SIG_BLOCK, &sigs, NULL);
+
+	in_worker = true;
+	master = worker->master;
+	set_time_now();
+
+	process_threads(master);
+
+	return NULL;
+}
+
+void
+checker_workers_init(unsigned num)
+{
+	unsigned i;
+
+	if (!num)
+		return;
+
+#ifdef _MEM_CHECK_
+	log_message(LOG_INFO, "checker_worker_threads is not supported with memory checking - running checkers in one thread");
+	return;
+#endif
+
+	if ((result_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1) {
+		log_message(LOG_INFO, "Unable to create checker worker eventfd (%m) - running checkers in one thread");
+		return;
+	}
+
+	workers = MALLOC(num * sizeof(*workers));
+	for (i = 0; i < num; i++) {
+		if (!(workers[i].master = thread_make_worker_master()))
+			break;
+		if ((workers[i].stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1) {
+			thread_destroy_master(workers[i].master);
+			break;
+		}
+		thread_set_slab_high_water(workers[i].master, global_data->scheduler_slab_high_water);
+		thread_set_timer_slack(workers[i].master, global_data->scheduler_timer_slack);
+		thread_add_read(workers[i].master, checker_worker_stop_thread, NULL, workers[i].stop_fd, TIMER_NEVER, 0);
+	}
+
+	if (i < num)
+		log_message(LOG_INFO, "Unable to create checker worker %u (%m) - using %u worker%s", i, i, i == 1 ? "" : "s");
+
+	num_workers = i;
+	next_worker = 0;
+
+	result_thread = thread_add_read(master, checker_results_thread, NULL, result_fd, TIMER_NEVER, THREAD_PRIORITY);
+}
+
+void
+checker_workers_start(void)
+{
+	checker_worker_t *worker;
+	int ret;
+
+	for (worker = workers; worker < workers + num_workers; worker++) {
+		if ((ret = pthread_create(&worker->thread, NULL, checker_worker_run, worker))) {
+			/* The checkers will not run, but the process can carry on */
+			log_message(LOG_ERR, "Unable to start checker worker thread - %d (%s)", ret, strerror(ret));
+			continue;
+		}
+		worker->running = true;
+	}
+}
+
+/* Stop the workers and apply any results they have queued. This must
+ * be done before the checkers are changed or freed. */
+void
+checker_workers_stop(void)
+{
+	checker_worker_t *worker;
+	uint64_t one = 1;
+
+	if (!workers)
+		return;
+
+	for (worker = workers; worker < workers + num_workers; worker++) {
+		if (worker->running) {
+			if (write(worker->stop_fd, &one, sizeof(one)) != sizeof(one))
+				log_message(LOG_INFO, "Unable to stop checker worker (%m)");
+			else
+				pthread_join(worker->thread, NULL);
+		}
+
+		thread_destroy_master(worker->master);
+		close(worker->stop_fd);
+	}
+
+	FREE(workers);
+	num_workers = 0;
+
+	checker_results_process();
+
+	if (result_thread) {
+		thread_cancel(result_thread);
+		result_thread = NULL;
+	}
+	close(result_fd);
+	result_fd = -1;
+}
+
+void
+dump_checker_workers(FILE *fp)
+{
+	unsigned i;
+
+	if (!num_workers)
+		return;
+
+	conf_write(fp, "------< Checker workers >------");
+	for (i = 0; i < num_workers; i++)
+		conf_write(fp, " Worker %u: %u checkers%s", i, workers[i].num_checkers, workers[i].running ? "" : " (not running)");
+}
+
+#ifdef THREAD_DUMP
+void
+register_check_worker_addresses(void)
+{
+	register_thread_address("checker_results_thread", checker_results_thread);
+	register_thread_address("checker_worker_stop_thread", checker_worker_stop_thread);
+}
+#endif
@@ -808,7 +808,6 @@ add_fwmark_vs(virtual_server_t *vs, int family)
 }
 #endif
 
-#ifdef _WITH_SNMP_CHECKER_
 static inline bool
 vsd_equal(real_server_t *rs, struct ip_vs_dest_entry_app *entry)
 {
@@ -922,6 +921,9 @@ ipvs_vs_update_stats(virtual_server_t *vs)
 	struct timespec cur_time;
 	uint16_t af;
 
+	if (no_ipvs)
+		return;
+
 	clock_gettime(CLOCK_MONOTONIC, &cur_time);
 	if ((unsigned long)((cur_time.tv_sec - vs->vs_stats_last_updated.tv_sec) * TIMER_HZ +
 	    cur_time.tv_nsec / (NSEC_PER_SEC / TIMER_HZ) - vs->vs_stats_last_updated.tv_nsec / (NSEC_PER_SEC / TIMER_HZ)) < global_data->snmp_vs_stats_update_interval)
@@ -990,6 +992,9 @@ ipvs_rs_update_stats(virtual_server_t *vs)
 	struct timespec cur_time;
 	uint16_t af;
 
+	if (no_ipvs)
+		return;
+
 	clock_gettime(CLOCK_MONOTONIC, &cur_time);
 	if ((unsigned long)((cur_time.tv_sec - vs->rs_stats_last_updated.tv_sec) * TIMER_HZ +
 	    cur_time.tv_nsec / (NSEC_PER_SEC / TIMER_HZ) - vs->rs_stats_last_updated.tv_nsec / (NSEC_PER_SEC / TIMER_HZ)) < global_data->snmp_rs_stats_update_interval)
@@ -1052,7 +1057,6 @@ ipvs_rs_update_stats(virtual_server_t *vs)
 		ipvs_update_rs_stats(vs, vs->af, 0, &nfaddr, inet_sockaddrport(&vs->addr));
 	}
 }
-#endif /* _WITH_SNMP_CHECKER_ */
 
 bool
 ipvs_syncd_changed(const struct lvs_syncd_config *old, const struct lvs_syncd_config *new)
@@ -28,6 +28,7 @@
 #include "ipwrapper.h"
 #include "check_api.h"
 #include "logger.h"
+#include "event_log.h"
 #include "utils.h"
 #include "main.h"
 #ifdef _WITH_SNMP_CHECKER_
@@ -544,6 +545,9 @@ update_quorum_state(virtual_server_t * vs, bool init)
 			perform_quorum_state(vs, true);
 		}
 
+		if (event_log)
+			log_event(EVENT_VS_QUORUM, true, (uint32_t)weight_sum, "%s", FMT_VS(vs));
+
 		do_vs_notifies(vs, init, threshold, weight_sum, false);
 
 		return;
@@ -580,6 +584,9 @@ update_quorum_state(virtual_server_t * vs, bool init)
 			vs->s_svr->alive = true;
 		}
 
+		if (event_log)
+			log_event(EVENT_VS_QUORUM, false, (uint32_t)weight_sum, "%s", FMT_VS(vs));
+
 		do_vs_notifies(vs, init, threshold, weight_sum, false);
 	}
 }
@@ -617,6 +624,9 @@ perform_svr_state(bool alive, checker_t *checker)
 	rs->alive = alive;
 	do_rs_notifies(vs, rs, false);
 
+	if (event_log)
+		log_event(EVENT_RS_STATE, alive, (uint32_t)rs->effective_weight, "%s %s", FMT_VS(vs), FMT_RS(rs, vs));
+
 	/* We may have changed quorum state. If the quorum wasn't up
 	 * but is now up, this is where the rs is added. */
 	update_quorum_state(vs, false);
@@ -752,6 +762,9 @@ update_svr_checker_state(bool alive, checker_t *checker)
 
 	checker->has_run = true;
 
+	if (event_log)
+		log_event(EVENT_CHECKER_STATE, alive, checker->checker_funcs->type, "%s %s", FMT_VS(checker->vs), FMT_RS(checker->rs, checker->vs));
+
 	if (alive) {
 		/* call the UP handler unless any more failed checks found */
 		if (checker->rs->num_failed_checkers <= 1) {
@@ -912,13 +925,137 @@ clear_diff_vsg(virtual_server_t *old_vs, virtual_server_t *new_vs)
 	clear_diff_vsge(&old->vfwmark, &new->vfwmark, old_vs);
 }
 
+/* Index of the new virtual servers, or of the real servers of a new
+ * virtual server, used to find the entries matching the old ones on a
+ * reload. The slots are hashed by the identity compared by vs_iseq() or
+ * rs_iseq(), with linear probing, and are at most half full. Entries
+ * are added in list order, so the first match is found, as with a search
+ * of the list. */
+typedef struct _diff_index {
+	unsigned	mask;
+	void		*slot[];
+} diff_index_t;
+
+/* Below this number of real servers a search of the list is quicker */
+#define RS_INDEX_MIN	8
+
+static inline uint32_t
+diff_hash_mix(uint32_t hash, uint32_t val)
+{
+	hash = (hash ^ val) * 0x9e3779b1U;
+
+	return hash ^ (hash >> 15);
+}
+
+static uint32_t __attribute__ ((pure))
+sockaddr_hash(const sockaddr_t *addr)
+{
+	uint32_t hash = addr->ss_family;
+	const struct sockaddr_in6 *addr6;
+	const struct sockaddr_in *addr4;
+	unsigned i;
+
+	if (addr->ss_family == AF_INET6) {
+		addr6 = PTR_CAST_CONST(struct sockaddr_in6, addr);
+		for (i = 0; i < 4; i++)
+			hash = diff_hash_mix(hash, addr6->sin6_addr.s6_addr32[i]);
+		hash = diff_hash_mix(hash, addr6->sin6_port);
+	} else if (addr->ss_family == AF_INET) {
+		addr4 = PTR_CAST_CONST(struct sockaddr_in, addr);
+		hash = diff_hash_mix(hash, addr4->sin_addr.s_addr);
+		hash = diff_hash_mix(hash, addr4->sin_port);
+	}
+
+	return hash;
+}
+
+static uint32_t __attribute__ ((pure))
+vs_hash(const virtual_server_t *vs)
+{
+	uint32_t hash;
+	const char *p;
+
+	if (vs->vsgname) {
+		hash = inet_sockaddrport(&vs->addr);
+		for (p = vs->vsgname; *p; p++)
+			hash = diff_hash_mix(hash, (unsigned char)*p);
+		return hash;
+	}
+
+	if (vs->vfwmark)
+		return diff_hash_mix(vs->af, vs->vfwmark);
+
+	return diff_hash_mix(sockaddr_hash(&vs->addr), vs->service_type);
+}
+
+static diff_index_t *
+alloc_diff_index(unsigned num)
+{
+	diff_index_t *index;
+	unsigned size = 4;
+
+	while (size < num * 2)
+		size <<= 1;
+
+	index = MALLOC(sizeof(*index) + size * sizeof(index->slot[0]));
+	index->mask = size - 1;
+
+	return index;
+}
+
+static diff_index_t *
+alloc_vs_index(void)
+{
+	diff_index_t *index;
+	virtual_server_t *vs;
+	unsigned num = 0;
+	unsigned i;
+
+	list_for_each_entry(vs, &check_data->vs, e_list)
+		num++;
+
+	index = alloc_diff_index(num);
+
+	list_for_each_entry(vs, &check_data->vs, e_list) {
+		for (i = vs_hash(vs) & index->mask; index->slot[i]; i = (i + 1) & index->mask);
+		index->slot[i] = vs;
+	}
+
+	return index;
+}
+
+static diff_index_t *
+alloc_rs_index(const virtual_server_t *vs)
+{
+	diff_index_t *index;
+	real_server_t *rs;
+	unsigned num = 0;
+	unsigned i;
+
+	list_for_each_entry(rs, &vs->rs, e_list)
+		num++;
+
+	if (num < RS_INDEX_MIN)
+		return NULL;
+
+	index = alloc_diff_index(num);
+
+	list_for_each_entry(rs, &vs->rs, e_list) {
+		for (i = sockaddr_hash(&rs->addr) & index->mask; index->slot[i]; i = (i + 1) & index->mask);
+		index->slot[i] = rs;
+	}
+
+	return index;
+}
+
 /* Check if a vs exist in new data and returns pointer to it */
 static virtual_server_t* __attribute__ ((pure))
-vs_exist(virtual_server_t * old_vs)
+vs_exist(virtual_server_t * old_vs, const diff_index_t *index)
 {
 	virtual_server_t *vs;
+	unsigned i;
 
-	list_for_each_entry(vs, &check_data->vs, e_list) {
+	for (i = vs_hash(old_vs) & index->mask; (vs = index->slot[i]); i = (i + 1) & index->mask) {
 		if (vs_iseq(old_vs, vs))
 			return vs;
 	}
@@ -928,9 +1065,19 @@ vs_exist(virtual_server_t * old_vs)
 
 /* Check if rs is in new vs data */
 static real_server_t * __attribute__ ((pure))
-rs_exist(real_server_t *old_rs, list_head_t *l)
+rs_exist(real_server_t *old_rs, list_head_t *l, const diff_index_t *index)
 {
 	real_server_t *rs;
+	unsigned i;
+
+	if (index) {
+		for (i = sockaddr_hash(&old_rs->addr) & index->mask; (rs = index->slot[i]); i = (i + 1) & index->mask) {
+			if (rs_iseq(rs, old_rs))
+				return rs;
+		}
+
+		return NULL;
+	}
 
 	list_for_each_entry(rs, l, e_list) {
 		if (rs_iseq(rs, old_rs))
@@ -959,6 +1106,7 @@ migrate_checkers(virtual_server_t *vs, real_server_t *old_rs, real_server_t *new
 
 					/* Transfer some other state flags */
 					new_c->has_run = old_c->has_run;
+					new_c->run_stats = old_c->run_stats;
 
 					/* If we have already had sufficient retries for the new retry value,
 					 * we hadn't already failed, so just require one more failure to trigger
@@ -1022,14 +1170,17 @@ static void
 clear_diff_rs(virtual_server_t *old_vs, virtual_server_t *new_vs)
 {
 	real_server_t *rs, *new_rs;
+	diff_index_t *index;
 
 	/* If old vs didn't own rs then nothing return */
 	if (list_empty(&old_vs->rs))
 		return;
 
+	index = alloc_rs_index(new_vs);
+
 	/* remove RS from old vs which are not found in new vs */
 	list_for_each_entry(rs, &old_vs->rs, e_list) {
-		new_rs = rs_exist(rs, &new_vs->rs);
+		new_rs = rs_exist(rs, &new_vs->rs, index);
 		if (!new_rs) {
 			log_message(LOG_INFO, "service %s no longer exist"
 					    , FMT_RS(rs, old_vs));
@@ -1073,6 +1224,9 @@ clear_diff_rs(virtual_server_t *old_vs, virtual_server_t *new_vs)
 			ipvs_cmd(LVS_CMD_EDIT_DEST, new_vs, new_rs);
 	}
 
+	if (index)
+		FREE(index);
+
 	update_vs_notifies(old_vs, false);
 }
 
@@ -1128,6 +1282,7 @@ void
 clear_diff_services(void)
 {
 	virtual_server_t *vs, *new_vs;
+	diff_index_t *index = alloc_vs_index();
 
 	/* Remove diff entries from previous IPVS rules */
 	list_for_each_entry(vs, &old_check_data->vs, e_list) {
@@ -1135,7 +1290,7 @@ clear_diff_services(void)
 		 * Try to find this vs in the new conf data
 		 * reloaded.
 		 */
-		new_vs = vs_exist(vs);
+		new_vs = vs_exist(vs, index);
 		if (!new_vs) {
 			if (vs->vsgname)
 				log_message(LOG_INFO, "Removing Virtual Server Group [%s]", vs->vsgname);
@@ -1174,6 +1329,8 @@ clear_diff_services(void)
 
 		update_alive_counts(vs, new_vs);
 	}
+
+	FREE(index);
 }
 
 /* This is only called during a reload. Any new real server with
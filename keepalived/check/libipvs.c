@@ -76,7 +76,6 @@ static struct nla_policy ipvs_cmd_policy[IPVS_CMD_ATTR_MAX + 1] = {
 	[IPVS_CMD_ATTR_TIMEOUT_UDP]	= { .type = NLA_U32 },
 };
 
-#ifdef _WITH_SNMP_CHECKER_
 static struct nla_policy ipvs_service_policy[IPVS_SVC_ATTR_MAX + 1] = {
 	[IPVS_SVC_ATTR_AF]		= { .type = NLA_U16 },
 	[IPVS_SVC_ATTR_PROTOCOL]	= { .type = NLA_U16 },
@@ -153,7 +152,6 @@ static struct nla_policy ipvs_stats_policy[IPVS_STATS_ATTR_MAX + 1] = {
 	[IPVS_STATS_ATTR_INBPS]		= { .type = NLA_U32 },
 	[IPVS_STATS_ATTR_OUTBPS]	= { .type = NLA_U32 },
 };
-#endif	/* _WITH_SNMP_CHECKER_ */
 
 static struct nla_policy ipvs_info_policy[IPVS_INFO_ATTR_MAX + 1] = {
 	[IPVS_INFO_ATTR_VERSION]	= { .type = NLA_U32 },
@@ -856,7 +854,6 @@ nla_put_failure:
 	return setsockopt(sockfd, IPPROTO_IP, IP_VS_SO_SET_STOPDAEMON, &dm->user, sizeof(dm->user));
 }
 
-#ifdef _WITH_SNMP_CHECKER_
 #ifdef _WITH_LVS_64BIT_STATS_
 static void
 ipvs_copy_stats(ip_vs_stats_t *stats_out, const struct ip_vs_stats_user *stats_in)
@@ -1278,7 +1275,6 @@ ipvs_get_service_err2:
 
 	return svc;
 }
-#endif	/* _WITH_SNMP_CHECKER_ */
 
 void ipvs_close(void)
 {
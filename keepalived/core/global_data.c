@@ -51,6 +51,7 @@
 #include "vrrp_dbus.h"
 #endif
 #include "safe_snprintf.h"
+#include "slab.h"
 
 /* global vars */
 data_t *global_data = NULL;
@@ -252,14 +253,18 @@ alloc_global_data(void)
 	new->notify_fifo.fd = -1;
 	new->max_auto_priority = 0;
 	new->min_auto_priority_delay = 1000000;	/* 1 second */
+	new->scheduler_slab_high_water = SLAB_DEFAULT_HIGH_WATER;
 #ifdef _WITH_VRRP_
 	new->vrrp_notify_fifo.fd = -1;
 	new->vrrp_rlimit_rt = RT_RLIMIT_DEFAULT;
 	new->vrrp_rx_bufs_multiples = 3;
+	new->vrrp_rx_filter = VRRP_RX_FILTER_VRID;
 #endif
 #ifdef _WITH_LVS_
 	new->lvs_notify_fifo.fd = -1;
 	new->checker_rlimit_rt = RT_RLIMIT_DEFAULT;
+	new->snmp_vs_stats_update_interval = 5 * TIMER_HZ;	/* 5 seconds */
+	new->snmp_rs_stats_update_interval = 0;
 #ifdef _WITH_BFD_
 	new->bfd_rlimit_rt = RT_RLIMIT_DEFAULT;
 #endif
@@ -283,10 +288,6 @@ alloc_global_data(void)
 
 	if (snmp_socket)
 		new->snmp_socket = STRDUP(snmp_socket);
-#ifdef _WITH_SNMP_CHECKER_
-	new->snmp_vs_stats_update_interval = 5 * TIMER_HZ;	/* 5 seconds */
-	new->snmp_rs_stats_update_interval = 0;
-#endif
 #endif
 
 #ifdef _WITH_LVS_
@@ -418,11 +419,9 @@ init_global_data(data_t * data, data_t *prev_global_data, bool copy_unchangeable
 		}
 #endif
 	}
-#ifdef _WITH_SNMP_CHECKER_
 	if (!data->snmp_rs_stats_update_interval)
 		data->snmp_rs_stats_update_interval = data->snmp_vs_stats_update_interval;
 #endif
-#endif
 
 #ifdef _WITH_VRRP_
 #ifdef IPROUTE_USR_DIR
@@ -517,6 +516,10 @@ free_global_data(data_t **datap)
 	FREE_CONST_PTR(data->reload_time_file);
 #endif
 	FREE_CONST_PTR(data->config_directory);
+	FREE_CONST_PTR(data->event_log_file);
+#ifdef _WITH_JSON_
+	FREE_CONST_PTR(data->json_socket);
+#endif
 #ifdef _WITH_VRRP_
 	FREE_CONST_PTR(data->iproute_usr_dir);
 	FREE_CONST_PTR(data->iproute_etc_dir);
@@ -524,6 +527,8 @@ free_global_data(data_t **datap)
 	FREE_CONST_PTR(data->state_dump_file);
 	FREE_CONST_PTR(data->stats_dump_file);
 	FREE_CONST_PTR(data->json_dump_file);
+	FREE_CONST_PTR(data->stats_socket);
+	FREE_CONST_PTR(data->metrics_socket);
 
 	FREE(data);
 
@@ -708,6 +713,8 @@ dump_global_data(FILE *fp, data_t * data)
 	}
 	if (data->reload_file)
 		conf_write(fp, " Reload_file = %s", data->reload_file);
+	if (data->reload_skip_unchanged)
+		conf_write(fp, " Skip reload if config files unchanged");
 #endif
 	if (data->config_directory)
 		conf_write(fp, " config save directory = %s", data->config_directory);
@@ -866,6 +873,11 @@ dump_global_data(FILE *fp, data_t * data)
 	else
 		conf_write(fp, " Max auto priority = %d", data->max_auto_priority);
 	conf_write(fp, " Min auto priority delay = %u usecs", data->min_auto_priority_delay);
+	conf_write(fp, " Scheduler slab high water = %u", data->scheduler_slab_high_water);
+	conf_write(fp, " Scheduler timer slack = %u usecs", data->scheduler_timer_slack);
+	conf_write(fp, " Log queue size = %u", data->log_queue_size);
+	if (data->event_log_file)
+		conf_write(fp, " Event log = %s, %u records", data->event_log_file, data->event_log_records);
 	conf_write(fp, " VRRP process priority = %d", data->vrrp_process_priority);
 	conf_write(fp, " VRRP don't swap = %s", data->vrrp_no_swap ? "true" : "false");
 	conf_write(fp, " VRRP realtime priority = %u", data->vrrp_realtime_priority);
@@ -874,6 +886,10 @@ dump_global_data(FILE *fp, data_t * data)
 		conf_write(fp, " VRRP CPU Affinity = %s", cpu_str);
 	}
 	conf_write(fp, " VRRP realtime limit = %" PRI_rlim_t, data->vrrp_rlimit_rt);
+	if (data->vrrp_timer_coalesce)
+		conf_write(fp, " VRRP timer coalescing window = %u usecs", data->vrrp_timer_coalesce);
+	if (data->vrrp_read_budget || data->vrrp_write_budget)
+		conf_write(fp, " VRRP scheduler budget = read %u, write %u", data->vrrp_read_budget, data->vrrp_write_budget);
 #endif
 #ifdef _WITH_LVS_
 	conf_write(fp, " Checker process priority = %d", data->checker_process_priority);
@@ -884,6 +900,11 @@ dump_global_data(FILE *fp, data_t * data)
 		conf_write(fp, " Checker CPU Affinity = %s", cpu_str);
 	}
 	conf_write(fp, " Checker realtime limit = %" PRI_rlim_t, data->checker_rlimit_rt);
+	if (data->checker_read_budget || data->checker_write_budget)
+		conf_write(fp, " Checker scheduler budget = read %u, write %u", data->checker_read_budget, data->checker_write_budget);
+#ifdef _WITH_CHECKER_WORKERS_
+	conf_write(fp, " Checker worker threads = %u", data->checker_worker_threads);
+#endif
 #endif
 #ifdef _WITH_BFD_
 	conf_write(fp, " BFD process priority = %d", data->bfd_process_priority);
@@ -894,6 +915,8 @@ dump_global_data(FILE *fp, data_t * data)
 		conf_write(fp, " BFD CPU Affinity = %s", cpu_str);
 	}
 	conf_write(fp, " BFD realtime limit = %" PRI_rlim_t, data->bfd_rlimit_rt);
+	if (data->bfd_read_budget || data->bfd_write_budget)
+		conf_write(fp, " BFD scheduler budget = read %u, write %u", data->bfd_read_budget, data->bfd_write_budget);
 #endif
 #ifdef _WITH_SNMP_VRRP_
 	conf_write(fp, " SNMP vrrp %s", data->enable_snmp_vrrp ? "enabled" : "disabled");
@@ -911,7 +934,7 @@ dump_global_data(FILE *fp, data_t * data)
 	conf_write(fp, " SNMP traps %s", data->enable_traps ? "enabled" : "disabled");
 	conf_write(fp, " SNMP socket = %s", data->snmp_socket ? data->snmp_socket : "default (unix:/var/agentx/master)");
 #endif
-#ifdef _WITH_SNMP_CHECKER_
+#ifdef _WITH_LVS_
 	conf_write(fp, " SNMP VS stats update interval = %s", format_decimal(data->snmp_vs_stats_update_interval, TIMER_HZ_DIGITS));
 	conf_write(fp, " SNMP RS stats update interval = %s", format_decimal(data->snmp_rs_stats_update_interval, TIMER_HZ_DIGITS));
 #endif
@@ -958,6 +981,8 @@ dump_global_data(FILE *fp, data_t * data)
 	if (buf[0])
 		conf_write(fp, "%s", buf);
 	conf_write(fp, " rx_bufs_multiples = %d", global_data->vrrp_rx_bufs_multiples);
+	conf_write(fp, " rx_filter = %s", global_data->vrrp_rx_filter == VRRP_RX_FILTER_NONE ? "none" :
+					  global_data->vrrp_rx_filter == VRRP_RX_FILTER_VRID ? "vrid" : "strict");
 	conf_write(fp, " umask = 0%o", umask_val);
 	if (global_data->vrrp_startup_delay)
 		conf_write(fp, " vrrp_startup_delay = %g", global_data->vrrp_startup_delay / TIMER_HZ_DOUBLE);
@@ -978,6 +1003,8 @@ dump_global_data(FILE *fp, data_t * data)
 		conf_write(fp, " current realtime time limit = %u", val);
 #ifdef _WITH_JSON_
 	conf_write(fp, " json_version %u", global_data->json_version);
+	if (global_data->json_socket)
+		conf_write(fp, " json socket %s", global_data->json_socket);
 #endif
 #ifdef _WITH_VRRP_
 	conf_write(fp, " iproute usr directory %s", global_data->iproute_usr_dir ? global_data->iproute_usr_dir : "(none)");
@@ -989,4 +1016,10 @@ dump_global_data(FILE *fp, data_t * data)
 		conf_write(fp, " stats dump file %s", global_data->stats_dump_file);
 	if (global_data->json_dump_file)
 		conf_write(fp, " json dump file %s", global_data->json_dump_file);
+	if (global_data->stats_socket)
+		conf_write(fp, " stats socket %s", global_data->stats_socket);
+	if (global_data->metrics_socket)
+		conf_write(fp, " metrics socket %s", global_data->metrics_socket);
+	if (global_data->metrics_port)
+		conf_write(fp, " metrics port %u", global_data->metrics_port);
 }
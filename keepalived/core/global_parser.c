@@ -63,6 +63,9 @@
 #ifdef _WITH_NFTABLES_
 #include "check_nftables.h"
 #endif
+#ifdef _WITH_CHECKER_WORKERS_
+#include "check_worker.h"
+#endif
 #endif
 #include "namespaces.h"
 #ifdef _WITH_JSON_
@@ -431,6 +434,66 @@ min_auto_priority_delay_handler(const vector_t *strvec)
 
 	global_data->min_auto_priority_delay = delay;
 }
+static void
+scheduler_slab_high_water_handler(const vector_t *strvec)
+{
+	unsigned high_water;
+
+	if (vector_size(strvec) < 2) {
+		report_config_error(CONFIG_GENERAL_ERROR, "scheduler_slab_high_water requires a number of objects");
+		return;
+	}
+	if (!read_unsigned_strvec(strvec, 1, &high_water, 0, UINT_MAX, true)) {
+		report_config_error(CONFIG_GENERAL_ERROR, "scheduler_slab_high_water '%s' is invalid - ignoring", strvec_slot(strvec, 1));
+		return;
+	}
+
+	global_data->scheduler_slab_high_water = high_water;
+}
+static void
+scheduler_timer_slack_handler(const vector_t *strvec)
+{
+	unsigned slack;
+
+	if (!read_unsigned_strvec(strvec, 1, &slack, 0, TIMER_HZ, true)) {
+		report_config_error(CONFIG_GENERAL_ERROR, "scheduler_timer_slack '%s' must be in [0, 1000000] usecs - ignoring", strvec_slot(strvec, 1));
+		return;
+	}
+
+	global_data->scheduler_timer_slack = slack;
+}
+static void
+log_queue_size_handler(const vector_t *strvec)
+{
+	unsigned size;
+
+	if (!read_unsigned_strvec(strvec, 1, &size, 0, 65536, true)) {
+		report_config_error(CONFIG_GENERAL_ERROR, "log_queue_size '%s' must be in [0, 65536] - ignoring", strvec_slot(strvec, 1));
+		return;
+	}
+
+	global_data->log_queue_size = size;
+}
+static void
+event_log_handler(const vector_t *strvec)
+{
+	unsigned records = DEFAULT_EVENT_LOG_RECORDS;
+
+	if (vector_size(strvec) < 2) {
+		report_config_error(CONFIG_GENERAL_ERROR, "event_log missing file name");
+		return;
+	}
+
+	if (vector_size(strvec) >= 3 &&
+	    !read_unsigned_strvec(strvec, 2, &records, 16, 1 << 22, true)) {
+		report_config_error(CONFIG_GENERAL_ERROR, "event_log records '%s' must be in [16, %u] - ignoring", strvec_slot(strvec, 2), 1U << 22);
+		return;
+	}
+
+	FREE_CONST_PTR(global_data->event_log_file);
+	global_data->event_log_file = STRDUP(strvec_slot(strvec, 1));
+	global_data->event_log_records = records;
+}
 #ifdef _WITH_VRRP_
 static void
 smtp_alert_vrrp_handler(const vector_t *strvec)
@@ -795,6 +858,33 @@ get_rt_rlimit(const vector_t *strvec, const char *process)
 	return rlim;
 }
 
+static void
+get_scheduler_budget(const vector_t *strvec, const char *process, unsigned *read_budget, unsigned *write_budget)
+{
+	unsigned rd, wr = 0;
+
+	if (vector_size(strvec) < 2 || vector_size(strvec) > 3) {
+		report_config_error(CONFIG_GENERAL_ERROR, "%s_scheduler_budget requires a read budget and an optional write budget", process);
+		return;
+	}
+
+	if (!read_unsigned_strvec(strvec, 1, &rd, 0, UINT_MAX, true)) {
+		report_config_error(CONFIG_GENERAL_ERROR, "Invalid %s scheduler read budget - %s", process, strvec_slot(strvec, 1));
+		return;
+	}
+
+	if (vector_size(strvec) > 2) {
+		if (!read_unsigned_strvec(strvec, 2, &wr, 0, UINT_MAX, true)) {
+			report_config_error(CONFIG_GENERAL_ERROR, "Invalid %s scheduler write budget - %s", process, strvec_slot(strvec, 2));
+			return;
+		}
+	} else
+		wr = rd;
+
+	*read_budget = rd;
+	*write_budget = wr;
+}
+
 static int8_t
 get_priority(const vector_t *strvec, const char *process)
 {
@@ -1472,6 +1562,23 @@ vrrp_rt_rlimit_handler(const vector_t *strvec)
 {
 	global_data->vrrp_rlimit_rt = get_rt_rlimit(strvec, "vrrp");
 }
+static void
+vrrp_scheduler_budget_handler(const vector_t *strvec)
+{
+	get_scheduler_budget(strvec, "vrrp", &global_data->vrrp_read_budget, &global_data->vrrp_write_budget);
+}
+static void
+vrrp_timer_coalesce_handler(const vector_t *strvec)
+{
+	unsigned window;
+
+	if (!read_unsigned_strvec(strvec, 1, &window, 0, 1000000, true)) {
+		report_config_error(CONFIG_GENERAL_ERROR, "vrrp_timer_coalesce '%s' must be in [0, 1000000] usecs - ignoring", strvec_slot(strvec, 1));
+		return;
+	}
+
+	global_data->vrrp_timer_coalesce = window;
+}
 #endif
 
 static void
@@ -1605,6 +1712,25 @@ checker_rt_rlimit_handler(const vector_t *strvec)
 {
 	global_data->checker_rlimit_rt = get_rt_rlimit(strvec, "checker");
 }
+static void
+checker_scheduler_budget_handler(const vector_t *strvec)
+{
+	get_scheduler_budget(strvec, "checker", &global_data->checker_read_budget, &global_data->checker_write_budget);
+}
+#ifdef _WITH_CHECKER_WORKERS_
+static void
+checker_worker_threads_handler(const vector_t *strvec)
+{
+	unsigned threads;
+
+	if (!read_unsigned_strvec(strvec, 1, &threads, 0, CHECKER_WORKERS_MAX, true)) {
+		report_config_error(CONFIG_GENERAL_ERROR, "Invalid checker_worker_threads %s - must be between 0 and %u", strvec_slot(strvec, 1), CHECKER_WORKERS_MAX);
+		return;
+	}
+
+	global_data->checker_worker_threads = threads;
+}
+#endif
 #endif
 
 #ifdef _WITH_BFD_
@@ -1637,6 +1763,11 @@ bfd_rt_rlimit_handler(const vector_t *strvec)
 {
 	global_data->bfd_rlimit_rt = get_rt_rlimit(strvec, "bfd");
 }
+static void
+bfd_scheduler_budget_handler(const vector_t *strvec)
+{
+	get_scheduler_budget(strvec, "bfd", &global_data->bfd_read_budget, &global_data->bfd_write_budget);
+}
 #endif
 
 #ifdef _WITH_SNMP_
@@ -1709,6 +1840,10 @@ snmp_checker_handler(__attribute__((unused)) const vector_t *strvec)
 {
 	global_data->enable_snmp_checker = true;
 }
+#endif
+#endif
+#ifdef _WITH_LVS_
+/* The IPVS stats are also used for the metrics */
 static void
 snmp_vs_stats_update_interval_handler(const vector_t *strvec)
 {
@@ -1732,7 +1867,6 @@ snmp_rs_stats_update_interval_handler(const vector_t *strvec)
 		report_config_error(CONFIG_GENERAL_ERROR, "snmp stats vs update interval '%s' invalid - ignoring", strvec_slot(strvec, 1));
 }
 #endif
-#endif
 
 static void
 net_namespace_handler(const vector_t *strvec)
@@ -1936,6 +2070,24 @@ vrrp_rx_bufs_multiplier_handler(const vector_t *strvec)
 	else
 		global_data->vrrp_rx_bufs_multiples = rx_buf_mult;
 }
+
+static void
+vrrp_rx_filter_handler(const vector_t *strvec)
+{
+	if (vector_size(strvec) != 2) {
+		report_config_error(CONFIG_GENERAL_ERROR, "vrrp_rx_filter requires none, vrid or strict");
+		return;
+	}
+
+	if (!strcmp(strvec_slot(strvec, 1), "none"))
+		global_data->vrrp_rx_filter = VRRP_RX_FILTER_NONE;
+	else if (!strcmp(strvec_slot(strvec, 1), "vrid"))
+		global_data->vrrp_rx_filter = VRRP_RX_FILTER_VRID;
+	else if (!strcmp(strvec_slot(strvec, 1), "strict"))
+		global_data->vrrp_rx_filter = VRRP_RX_FILTER_STRICT;
+	else
+		report_config_error(CONFIG_GENERAL_ERROR, "Invalid vrrp_rx_filter %s", strvec_slot(strvec, 1));
+}
 #endif
 
 #if defined _WITH_VRRP_ || defined _WITH_LVS_
@@ -2471,6 +2623,12 @@ reload_repeat_handler(__attribute__((unused)) const vector_t *strvec)
 	global_data->reload_repeat = true;
 }
 
+static void
+reload_skip_unchanged_handler(__attribute__((unused)) const vector_t *strvec)
+{
+	global_data->reload_skip_unchanged = true;
+}
+
 static void
 reload_file_handler(const vector_t *strvec)
 {
@@ -2536,6 +2694,19 @@ json_version_handler(const vector_t *strvec)
 
 	global_data->json_version = version;
 }
+
+static void
+json_socket_handler(const vector_t *strvec)
+{
+	if (vector_size(strvec) != 2 ||
+	    !strvec_slot(strvec, 1)[0]) {
+		report_config_error(CONFIG_GENERAL_ERROR, "%s requires a non-empty path", strvec_slot(strvec, 0));
+		return;
+	}
+
+	FREE_CONST_PTR(global_data->json_socket);
+	global_data->json_socket = STRDUP(strvec_slot(strvec, 1));
+}
 #endif
 
 #ifdef _WITH_VRRP_
@@ -2600,6 +2771,51 @@ json_dump_file_handler(const vector_t *strvec)
 	global_data->json_dump_file = STRDUP(strvec_slot(strvec, 1));
 }
 
+static void
+stats_socket_handler(const vector_t *strvec)
+{
+	if (vector_size(strvec) != 2 ||
+	    !strvec_slot(strvec, 1)[0]) {
+		report_config_error(CONFIG_GENERAL_ERROR, "%s requires a non-empty path", strvec_slot(strvec, 0));
+		return;
+	}
+
+	FREE_CONST_PTR(global_data->stats_socket);
+	global_data->stats_socket = STRDUP(strvec_slot(strvec, 1));
+}
+
+static void
+metrics_socket_handler(const vector_t *strvec)
+{
+	if (vector_size(strvec) != 2 ||
+	    !strvec_slot(strvec, 1)[0]) {
+		report_config_error(CONFIG_GENERAL_ERROR, "%s requires a non-empty path", strvec_slot(strvec, 0));
+		return;
+	}
+
+	FREE_CONST_PTR(global_data->metrics_socket);
+	global_data->metrics_socket = STRDUP(strvec_slot(strvec, 1));
+}
+
+static void
+metrics_port_handler(const vector_t *strvec)
+{
+	unsigned port;
+
+	if (vector_size(strvec) != 2) {
+		report_config_error(CONFIG_GENERAL_ERROR, "%s requires a port number", strvec_slot(strvec, 0));
+		return;
+	}
+
+	/* The checker process listens on the following port */
+	if (!read_unsigned_strvec(strvec, 1, &port, 1, 65534, false)) {
+		report_config_error(CONFIG_GENERAL_ERROR, "metrics_port '%s' must be in [1, 65534] - ignoring", strvec_slot(strvec, 1));
+		return;
+	}
+
+	global_data->metrics_port = (uint16_t)port;
+}
+
 void
 init_global_keywords(bool global_active)
 {
@@ -2641,6 +2857,10 @@ init_global_keywords(bool global_active)
 	install_keyword("shutdown_script_timeout", &shutdown_script_timeout_handler);
 	install_keyword("max_auto_priority", &max_auto_priority_handler);
 	install_keyword("min_auto_priority_delay", &min_auto_priority_delay_handler);
+	install_keyword("scheduler_slab_high_water", &scheduler_slab_high_water_handler);
+	install_keyword("scheduler_timer_slack", &scheduler_timer_slack_handler);
+	install_keyword("log_queue_size", &log_queue_size_handler);
+	install_keyword("event_log", &event_log_handler);
 #ifdef _WITH_VRRP_
 	install_keyword("smtp_alert_vrrp", &smtp_alert_vrrp_handler);
 #endif
@@ -2707,6 +2927,8 @@ init_global_keywords(bool global_active)
 	install_keyword("vrrp_cpu_affinity", &vrrp_cpu_affinity_handler);
 	install_keyword("vrrp_rlimit_rttime", &vrrp_rt_rlimit_handler);
 	install_keyword("vrrp_rlimit_rtime", &vrrp_rt_rlimit_handler);		/* Deprecated 02/02/2020 */
+	install_keyword("vrrp_scheduler_budget", &vrrp_scheduler_budget_handler);
+	install_keyword("vrrp_timer_coalesce", &vrrp_timer_coalesce_handler);
 #endif
 #ifdef _WITH_NFTABLES_
 #ifdef _WITH_LVS_
@@ -2735,6 +2957,10 @@ init_global_keywords(bool global_active)
 	install_keyword("checker_cpu_affinity", &checker_cpu_affinity_handler);
 	install_keyword("checker_rlimit_rttime", &checker_rt_rlimit_handler);
 	install_keyword("checker_rlimit_rtime", &checker_rt_rlimit_handler);	/* Deprecated 02/02/2020 */
+	install_keyword("checker_scheduler_budget", &checker_scheduler_budget_handler);
+#ifdef _WITH_CHECKER_WORKERS_
+	install_keyword("checker_worker_threads", &checker_worker_threads_handler);
+#endif
 #endif
 #ifdef _WITH_BFD_
 	install_keyword("bfd_priority", &bfd_prio_handler);
@@ -2743,6 +2969,7 @@ init_global_keywords(bool global_active)
 	install_keyword("bfd_cpu_affinity", &bfd_cpu_affinity_handler);
 	install_keyword("bfd_rlimit_rttime", &bfd_rt_rlimit_handler);
 	install_keyword("bfd_rlimit_rtime", &bfd_rt_rlimit_handler);		/* Deprecated 02/02/2020 */
+	install_keyword("bfd_scheduler_budget", &bfd_scheduler_budget_handler);
 #endif
 #ifdef _WITH_SNMP_
 	install_keyword("snmp_socket", &snmp_socket_handler);
@@ -2762,8 +2989,6 @@ init_global_keywords(bool global_active)
 #endif
 #ifdef _WITH_SNMP_CHECKER_
 	install_keyword("enable_snmp_checker", &snmp_checker_handler);
-	install_keyword("snmp_vs_stats_update_interval", &snmp_vs_stats_update_interval_handler);
-	install_keyword("snmp_rs_stats_update_interval", &snmp_rs_stats_update_interval_handler);
 #endif
 #endif
 #ifdef _WITH_DBUS_
@@ -2790,10 +3015,13 @@ init_global_keywords(bool global_active)
 	install_keyword("lvs_netlink_monitor_rcv_bufs_force", &lvs_netlink_monitor_rcv_bufs_force_handler);
 	install_keyword("rs_init_notifies", &rs_init_notifies_handler);
 	install_keyword("no_checker_emails", &no_checker_emails_handler);
+	install_keyword("snmp_vs_stats_update_interval", &snmp_vs_stats_update_interval_handler);
+	install_keyword("snmp_rs_stats_update_interval", &snmp_rs_stats_update_interval_handler);
 #endif
 #ifdef _WITH_VRRP_
 	install_keyword("vrrp_rx_bufs_policy", &vrrp_rx_bufs_policy_handler);
 	install_keyword("vrrp_rx_bufs_multiplier", &vrrp_rx_bufs_multiplier_handler);
+	install_keyword("vrrp_rx_filter", &vrrp_rx_filter_handler);
 	install_keyword("vrrp_startup_delay", &vrrp_startup_delay_handler);
 	install_keyword("vrrp_delay_after_boot", &vrrp_delay_after_boot_handler);
 	install_keyword("log_unknown_vrids", &vrrp_log_unknown_vrids_handler);
@@ -2810,6 +3038,7 @@ init_global_keywords(bool global_active)
 	install_keyword("reload_time_file", &reload_time_file_handler);
 	install_keyword("reload_repeat", &reload_repeat_handler);
 	install_keyword("reload_file", &reload_file_handler);
+	install_keyword("reload_skip_unchanged", &reload_skip_unchanged_handler);
 	install_keyword("include_check", &include_check_handler);
 	install_keyword("config_save_dir", &config_save_dir_handler);
 #endif
@@ -2817,6 +3046,7 @@ init_global_keywords(bool global_active)
 	install_keyword("data_use_instance", &data_use_instance_handler);
 #ifdef _WITH_JSON_
 	install_keyword("json_version", &json_version_handler);
+	install_keyword("json_socket", &json_socket_handler);
 #endif
 #ifdef _WITH_VRRP_
 	install_keyword("iproute_usr_dir", &iproute_usr_handler);
@@ -2825,4 +3055,7 @@ init_global_keywords(bool global_active)
 	install_keyword("state_dump_file", &state_dump_file_handler);
 	install_keyword("stats_dump_file", &stats_dump_file_handler);
 	install_keyword("json_dump_file", &json_dump_file_handler);
+	install_keyword("stats_socket", &stats_socket_handler);
+	install_keyword("metrics_socket", &metrics_socket_handler);
+	install_keyword("metrics_port", &metrics_port_handler);
 }
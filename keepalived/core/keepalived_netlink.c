@@ -72,6 +72,7 @@
 #endif
 #endif
 #include "logger.h"
+#include "event_log.h"
 #include "scheduler.h"
 #include "utils.h"
 #include "list_head.h"
@@ -1645,6 +1646,7 @@ process_interface_flags_change(interface_t *ifp, unsigned ifi_flags)
 
 	if (!list_empty(&ifp->tracking_vrrp)) {
 		log_message(LOG_INFO, "Netlink reports %s %s", ifp->ifname, now_up ? "up" : "down");
+		log_event(EVENT_LINK_STATE, now_up, ifp->ifindex, "%s", ifp->ifname);
 
 #ifdef _HAVE_VRRP_VMAC_
 		if (ifp->vmac_type &&
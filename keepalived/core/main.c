@@ -52,6 +52,7 @@
 #include "pidfile.h"
 #include "bitops.h"
 #include "logger.h"
+#include "event_log.h"
 #include "parser.h"
 #include "notify.h"
 #include "track_file.h"
@@ -316,6 +317,8 @@ free_parent_mallocs_startup(bool am_child)
 
 		free_notify_script(&global_data->startup_script);
 		free_notify_script(&global_data->shutdown_script);
+
+		free_config_sources();
 	}
 }
 
@@ -323,6 +326,7 @@ void
 free_parent_mallocs_exit(void)
 {
 	FREE_CONST_PTR(config_id);
+	free_config_sources();
 
 #ifdef _REPRODUCIBLE_BUILD_
 	FREE_CONST_PTR(config_opts);
@@ -528,6 +532,10 @@ start_keepalived(__attribute__((unused)) thread_ref_t thread)
 	 * termination of their immediate parent. */
 	prctl(PR_SET_CHILD_SUBREAPER, 1);
 
+	/* The children write to the event log mapped by the parent */
+	if (global_data->event_log_file)
+		open_event_log(global_data->event_log_file, global_data->event_log_records);
+
 #ifdef _WITH_BFD_
 	/* must be opened before vrrp and bfd start */
 	if (!open_bfd_pipes()) {
@@ -819,6 +827,14 @@ static bool reload_config(void)
 #endif
 #endif
 
+	if (!!old_global_data->event_log_file != !!global_data->event_log_file ||
+	    (global_data->event_log_file &&
+	     (strcmp(old_global_data->event_log_file, global_data->event_log_file) ||
+	      old_global_data->event_log_records != global_data->event_log_records))) {
+		log_message(LOG_INFO, "Cannot change event_log at a reload - please restart %s", PACKAGE);
+		unsupported_change = true;
+	}
+
 	if (!!old_global_data->config_directory != !!global_data->config_directory ||
 	    (global_data->config_directory && strcmp(old_global_data->config_directory, global_data->config_directory))) {
 		log_message(LOG_INFO, "Cannot change config_directory at a reload - please restart %s", PACKAGE);
@@ -1085,6 +1101,14 @@ start_reload(thread_ref_t thread)
 	if (thread && __test_bit(LOG_DETAIL_BIT, &debug))
 		log_message(LOG_INFO, "Processing queued reload");
 
+	if (global_data->reload_skip_unchanged && config_files_unchanged()) {
+		log_message(LOG_INFO, "Configuration files unchanged - not reloading");
+
+		/* An update process may be waiting for the reload file to go */
+		remove_reload_file();
+		return;
+	}
+
 	/* if reload_check_config is configured, validate the new config before reload */
 	if (!global_data->reload_check_config) {
 		do_reload();
@@ -2934,6 +2958,7 @@ end:
 	free_parent_mallocs_startup(false);
 	free_parent_mallocs_exit();
 	free_global_data(&global_data);
+	close_event_log();
 
 #ifdef DO_STACKSIZE
 	get_stacksize(true);
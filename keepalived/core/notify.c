@@ -202,6 +202,7 @@ system_call_script(thread_master_t *m, thread_func_t func, void * arg, unsigned
 	if (log_file_name)
 		flush_log_file();
 #endif
+	flush_log_queue();
 
 	pid = fork();
 
@@ -225,6 +226,7 @@ system_call_script(thread_master_t *m, thread_func_t func, void * arg, unsigned
 	}
 
 	/* Child process */
+	close_log_queue();
 	reset_process_priorities();
 
 #ifdef _MEM_CHECK_
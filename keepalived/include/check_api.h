@@ -62,6 +62,14 @@ typedef struct _checker_funcs {
 	void				(*migrate) (struct _checker *, const struct _checker *);
 } checker_funcs_t;
 
+/* Results of the runs of a checker, kept across reloads. They may be
+ * updated by a worker thread, so are read with checker_get_run_stats(). */
+typedef struct _checker_run_stats {
+	uint64_t			success;
+	uint64_t			failure;
+	uint64_t			duration_total;		/* usecs, of all the runs */
+} checker_run_stats_t;
+
 /* Checkers structure definition */
 typedef struct _checker {
 	const checker_funcs_t		*checker_funcs;
@@ -72,6 +80,8 @@ typedef struct _checker {
 	bool				enabled;		/* Activation flag */
 	bool				is_up;			/* Set if checker is up */
 	bool				has_run;		/* Set if the checker has completed at least once */
+	bool				run_is_up;		/* is_up and has_run as seen by the thread running */
+	bool				run_has_run;		/*   the checker, which may be a worker thread */
 	int				cur_weight;		/* Current weight of checker */
 	conn_opts_t			*co;			/* connection options */
 	int				alpha;			/* Alpha mode enabled */
@@ -83,6 +93,9 @@ typedef struct _checker {
 	unsigned			default_retry;		/* number of retries before failing */
 	unsigned long			default_delay_before_retry; /* interval between retries */
 	bool				log_all_failures;	/* Log all failures when checker up */
+	timeval_t			sands;			/* when the current run was due */
+	timeval_t			run_start;		/* when the current run started */
+	checker_run_stats_t		run_stats;
 
 	/* Linked list of checkers from rs */
 	list_head_t			rs_list;
@@ -124,6 +137,14 @@ extern void dequeue_new_checker(void);
 extern bool check_conn_opts(conn_opts_t *);
 extern bool compare_conn_opts(const conn_opts_t *, const conn_opts_t *) __attribute__ ((pure));
 extern void dump_checkers(FILE *);
+extern void apply_checker_state(checker_t *, bool, const char *);
+extern void checker_set_state(checker_t *, bool, const char *);
+extern thread_ref_t checker_add_timer(thread_master_t *, thread_func_t, checker_t *);
+extern thread_ref_t checker_add_retry_timer(thread_master_t *, thread_func_t, checker_t *, unsigned long);
+extern void checker_run_start(checker_t *);
+extern void checker_run_end(checker_t *, bool);
+extern void checker_get_run_stats(const checker_t *, checker_run_stats_t *);
+extern void checker_set_has_run(checker_t *);
 extern void register_checkers_thread(void);
 extern void install_checkers_keyword(void);
 extern void checker_set_dst_port(sockaddr_t *, uint16_t);
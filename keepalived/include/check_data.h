@@ -41,6 +41,7 @@
 #include "vector.h"
 #include "notify.h"
 #include "utils.h"
+#include "query_socket.h"
 #ifdef _WITH_BFD_
 #include "check_bfd.h"
 #endif
@@ -112,7 +113,6 @@ typedef struct _real_server {
 	bool				set;		/* in the IPVS table */
 	bool				reloaded;	/* active state was copied from old config while reloading */
 	const char			*virtualhost;	/* Default virtualhost for HTTP and SSL health checkers */
-#if defined(_WITH_SNMP_CHECKER_)
 	/* Statistics */
 	uint32_t			activeconns;	/* active connections */
 	uint32_t			inactconns;	/* inactive connections */
@@ -121,7 +121,6 @@ typedef struct _real_server {
 	struct ip_vs_stats_user		stats;
 #else
 	struct ip_vs_stats64		stats;
-#endif
 #endif
 	list_head_t			track_files;	/* tracked_file_monitor_t - Files whose value we monitor */
 #ifdef _WITH_BFD_
@@ -222,7 +221,7 @@ typedef struct _virtual_server {
 	int				smtp_alert;	/* Send email on status change */
 	bool				quorum_state_up; /* Reflects result of the last transition done. */
 	bool				reloaded;	/* quorum_state was copied from old config while reloading */
-#if defined _WITH_SNMP_CHECKER_
+	query_track_t			query_track;	/* Changes seen by the stats socket */
 	/* Statistics */
 	struct timespec			vs_stats_last_updated;
 	struct timespec			rs_stats_last_updated;
@@ -232,7 +231,6 @@ typedef struct _virtual_server {
 	struct ip_vs_stats_user		stats;
 #else
 	struct ip_vs_stats64		stats;
-#endif
 #endif
 	/* Linked list member */
 	list_head_t			e_list;
@@ -156,6 +156,7 @@ extern void dump_digest(unsigned char *, unsigned);
 extern void http_process_response(thread_ref_t, request_t *, size_t, url_t *);
 extern void http_handle_response(thread_ref_t, unsigned char digest[16], bool);
 extern void http_connect_thread(thread_ref_t);
+extern bool http_check_uses_regex(const checker_t *) __attribute__ ((pure));
 #ifdef THREAD_DUMP
 extern void register_check_http_addresses(void);
 #endif
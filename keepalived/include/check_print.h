@@ -25,5 +25,9 @@
 #define _CHECK_PRINT_H
 
 extern void check_print_data(void);
+extern void check_stats_socket_open(void);
+extern void check_stats_socket_close(void);
+extern void check_metrics_socket_open(void);
+extern void check_metrics_socket_close(void);
 
 #endif
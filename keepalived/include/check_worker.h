@@ -0,0 +1,48 @@
+/*
+ * Soft:        Keepalived is a failover program for the LVS project
+ *              <www.linuxvirtualserver.org>. It monitor & manipulate
+ *              a loadbalanced server pool using multi-layer checks.
+ *
+ * Part:        check_worker.c include file.
+ *
+ * Author:      Alexandre Cassen, <acassen@linux-vs.org>
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *              See the GNU General Public License for more details.
+ *
+ *              This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU General Public License
+ *              as published by the Free Software Foundation; either version
+ *              2 of the License, or (at your option) any later version.
+ *
+ * Copyright (C) 2026 Alexandre Cassen, <acassen@gmail.com>
+ */
+
+#ifndef _CHECK_WORKER_H
+#define _CHECK_WORKER_H
+
+/* global includes */
+#include <stdbool.h>
+#include <stdio.h>
+
+/* local includes */
+#include "scheduler.h"
+#include "check_api.h"
+
+#define CHECKER_WORKERS_MAX	64U
+
+/* Prototypes defs */
+extern void checker_workers_init(unsigned);
+extern void checker_workers_start(void);
+extern void checker_workers_stop(void);
+extern thread_master_t *checker_worker_master(const checker_t *);
+extern bool checker_worker_queue_state(checker_t *, bool, const char *);
+extern bool checker_worker_queue_has_run(checker_t *);
+extern void dump_checker_workers(FILE *);
+#ifdef THREAD_DUMP
+extern void register_check_worker_addresses(void);
+#endif
+
+#endif
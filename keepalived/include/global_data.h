@@ -58,11 +58,17 @@
 
 /* constants */
 #define DEFAULT_SMTP_CONNECTION_TIMEOUT (30 * TIMER_HZ)
+#define DEFAULT_EVENT_LOG_RECORDS	16384
 
 #ifdef _WITH_VRRP_
 #define RX_BUFS_POLICY_MTU		0x01
 #define RX_BUFS_POLICY_ADVERT		0x02
 #define RX_BUFS_SIZE			0x04
+
+/* vrrp_rx_filter */
+#define VRRP_RX_FILTER_NONE		0
+#define VRRP_RX_FILTER_VRID		1
+#define VRRP_RX_FILTER_STRICT		2
 #endif
 
 #ifdef _WITH_LVS_
@@ -133,6 +139,7 @@ typedef struct _data {
 	time_t				reload_time;
 	bool				reload_date_specified;
 	const char			*reload_file;
+	bool				reload_skip_unchanged;	/* Don't reload if no config file has changed */
 #endif
 	const char 			*config_directory;
 	bool				data_use_instance;
@@ -156,6 +163,11 @@ typedef struct _data {
 #endif
 	int				max_auto_priority;
 	unsigned			min_auto_priority_delay;
+	unsigned			scheduler_slab_high_water;
+	unsigned			scheduler_timer_slack;
+	unsigned			log_queue_size;
+	const char			*event_log_file;
+	unsigned			event_log_records;
 #ifdef _WITH_VRRP_
 	struct sockaddr_in6		vrrp_mcast_group6 __attribute__((aligned(__alignof__(sockaddr_t))));
 	struct sockaddr_in		vrrp_mcast_group4 __attribute__((aligned(__alignof__(sockaddr_t))));
@@ -204,6 +216,9 @@ typedef struct _data {
 	unsigned			vrrp_realtime_priority;
 	cpu_set_t			vrrp_cpu_mask;
 	rlim_t				vrrp_rlimit_rt;
+	unsigned			vrrp_timer_coalesce;
+	unsigned			vrrp_read_budget;
+	unsigned			vrrp_write_budget;
 #endif
 #ifdef _WITH_LVS_
 	bool				have_checker_config;
@@ -212,6 +227,11 @@ typedef struct _data {
 	unsigned			checker_realtime_priority;
 	cpu_set_t			checker_cpu_mask;
 	rlim_t				checker_rlimit_rt;
+	unsigned			checker_read_budget;
+	unsigned			checker_write_budget;
+#ifdef _WITH_CHECKER_WORKERS_
+	unsigned			checker_worker_threads;
+#endif
 #ifdef _WITH_NFTABLES_
 	const char			*ipvs_nf_table_name;
 	int				ipvs_nf_chain_priority;
@@ -228,6 +248,8 @@ typedef struct _data {
 	unsigned			bfd_realtime_priority;
 	cpu_set_t			bfd_cpu_mask;
 	rlim_t				bfd_rlimit_rt;
+	unsigned			bfd_read_budget;
+	unsigned			bfd_write_budget;
 #endif
 	notify_fifo_t			notify_fifo;
 #ifdef _WITH_VRRP_
@@ -256,8 +278,6 @@ typedef struct _data {
 #endif
 #ifdef _WITH_SNMP_CHECKER_
 	bool				enable_snmp_checker;
-	unsigned long			snmp_vs_stats_update_interval;
-	unsigned long			snmp_rs_stats_update_interval;
 #endif
 #endif
 #ifdef _WITH_DBUS_
@@ -284,11 +304,14 @@ typedef struct _data {
 #ifdef _WITH_LVS_
 	bool				rs_init_notifies;
 	bool				no_checker_emails;
+	unsigned long			snmp_vs_stats_update_interval;	/* also used for the metrics */
+	unsigned long			snmp_rs_stats_update_interval;
 #endif
 #ifdef _WITH_VRRP_
 	int				vrrp_rx_bufs_policy;
 	size_t				vrrp_rx_bufs_size;
 	int				vrrp_rx_bufs_multiples;
+	int				vrrp_rx_filter;
 	unsigned			vrrp_startup_delay;
 	bool				log_unknown_vrids;
 	bool				vrrp_owner_ignore_adverts;
@@ -299,6 +322,7 @@ typedef struct _data {
 #endif
 #ifdef _WITH_JSON_
 	unsigned			json_version;
+	const char			*json_socket;
 #endif
 #ifdef _WITH_VRRP_
 	const char			*iproute_usr_dir;
@@ -307,6 +331,9 @@ typedef struct _data {
 	const char			*state_dump_file;
 	const char			*stats_dump_file;
 	const char			*json_dump_file;
+	const char			*stats_socket;
+	const char			*metrics_socket;
+	uint16_t			metrics_port;
 } data_t;
 
 /* Global vars exported */
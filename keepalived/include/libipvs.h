@@ -69,7 +69,6 @@ extern int ipvs_start_daemon(ipvs_daemon_t *dm);
 /* stop a connection synchronizaiton daemon (master/backup) */
 extern int ipvs_stop_daemon(ipvs_daemon_t *dm);
 
-#ifdef _WITH_SNMP_CHECKER_
 /* get the destination array of the specified service */
 extern struct ip_vs_get_dests_app *ipvs_get_dests(__u32, __u16, __u16, union nf_inet_addr *, __u16, unsigned);
 
@@ -77,7 +76,6 @@ extern struct ip_vs_get_dests_app *ipvs_get_dests(__u32, __u16, __u16, union nf_
 /* get an ipvs service entry */
 extern ipvs_service_entry_t *
 ipvs_get_service(__u32 fwmark, __u16 af, __u16 protocol, union nf_inet_addr *addr, __u16 port);
-#endif
 
 /* close the socket */
 extern void ipvs_close(void);
@@ -47,6 +47,7 @@
 #include "vrrp_sock.h"
 #include "vrrp_track.h"
 #include "sockaddr.h"
+#include "query_socket.h"
 #if defined _WITH_VRRP_AUTH_
 #include "vrrp_auth_hmac.h"
 #endif
@@ -311,6 +312,7 @@ typedef struct _vrrp_t {
 	const char		*iname;			/* Instance Name */
 	vrrp_sgroup_t		*sync;			/* Sync group we belong to */
 	vrrp_stats		*stats;			/* Statistics */
+	query_track_t		query_track;		/* Changes seen by the stats socket */
 	interface_t		*ifp;			/* Interface we belong to */
 #ifdef _HAVE_VRF_
 	const interface_t	*vrf_ifp;		/* VRF interface if no interface specified */
@@ -442,6 +444,11 @@ typedef struct _vrrp_t {
 	/* Sending buffer */
 	char			*send_buffer;		/* Allocated send buffer */
 	size_t			send_buffer_size;
+	struct mmsghdr		*unicast_msgs;		/* One per unicast peer, for sendmmsg() */
+	struct iovec		*unicast_iov;
+	char			*unicast_buffers;	/* IPv4 per peer copies of send_buffer */
+	bool			unicast_templates_set;	/* unicast_buffers can be updated in place */
+	unsigned		num_unicast_peers;
 	uint32_t		ipv4_csum;		/* Checksum ip IPv4 pseudo header for VRRPv3 */
 
 #if defined _WITH_VRRP_AUTH_
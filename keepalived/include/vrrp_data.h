@@ -57,13 +57,17 @@ typedef struct _vrrp_data {
 	unsigned		num_smtp_alert;		/* No of smtp_alerts configured */
 } vrrp_data_t;
 
+/* Number of packets read by each recvmmsg() call */
+#define VRRP_RX_BATCH	16
+
 /* Global Vars exported */
 extern vrrp_data_t *vrrp_data;
 extern vrrp_data_t *old_vrrp_data;
-extern void *vrrp_buffer;
-extern size_t vrrp_buffer_len;
+extern void *vrrp_buffer;		/* VRRP_RX_BATCH receive buffers */
+extern size_t vrrp_buffer_len;		/* Length of each receive buffer */
 
 /* prototypes */
+extern const char *get_state_str(int) __attribute__ ((const));
 extern static_track_group_t *alloc_static_track_group(const char *);
 extern void alloc_saddress(const vector_t *);
 extern void alloc_sroute(const vector_t *);
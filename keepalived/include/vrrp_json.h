@@ -29,5 +29,7 @@
 
 /* Prototypes */
 extern void vrrp_print_json(void);
+extern void vrrp_json_socket_open(const char *);
+extern void vrrp_json_socket_close(void);
 
 #endif
@@ -29,5 +29,9 @@
 
 extern void vrrp_print_data(void);
 extern void vrrp_print_stats(bool);
+extern void vrrp_stats_socket_open(void);
+extern void vrrp_stats_socket_close(void);
+extern void vrrp_metrics_socket_open(void);
+extern void vrrp_metrics_socket_close(void);
 
 #endif
@@ -52,6 +52,7 @@ typedef struct _sock {
 	int			rx_buf_size;
 	thread_ref_t		thread;
 	rb_root_t		rb_vrid;
+	struct _vrrp_t		*vrid_map[256];		/* first instance in rb_vrid for each VRID */
 	rb_root_cached_t	rb_sands;
 
 	/* Linked list member */
@@ -44,6 +44,7 @@
 #if !defined ETH_HLEN || !defined ETH_ZLEN
 #include <linux/if_ether.h>		/* This may not be needed at all - try removing and see if any issues raised */
 #endif
+#include <linux/filter.h>
 #ifdef _NETWORK_TIMESTAMP_
 #include <linux/net_tstamp.h>
 #endif
@@ -382,16 +383,65 @@ expected_vrrp_pkt_len(const vrrphdr_t *vh, int family)
 	return len;
 }
 
+/* The VRRP header of an advert built by vrrp_build_pkt() */
+static vrrphdr_t *
+vrrp_pkt_header(const vrrp_t *vrrp, char *buf)
+{
+	if (vrrp->family == AF_INET) {
+		buf += sizeof(struct iphdr);
+
+#ifdef _WITH_VRRP_AUTH_
+		if (vrrp->auth_type == VRRP_AUTH_AH)
+			buf += sizeof(ipsec_ah_t);
+#endif
+	}
+
+	return PTR_CAST(vrrphdr_t, buf);
+}
+
+static void
+vrrp_pkt_set_prio(const vrrp_t *vrrp, vrrphdr_t *hd, uint8_t prio)
+{
+	if (hd->priority == prio)
+		return;
+
+	if (vrrp->family == AF_INET) {
+		/* HC' = ~(~HC + ~m + m') */
+		uint16_t *prio_addr = PTR_CAST(uint16_t, ((char *)&hd->priority - (((char *)hd -(char *)&hd->priority) & 1)));
+		uint16_t old_val = *prio_addr;
+
+		hd->priority = prio;
+		hd->chksum = csum_incremental_update16(hd->chksum, old_val, *prio_addr);
+	}
+	else
+		hd->priority = prio;
+}
+
+static void
+vrrp_pkt_set_saddr(const vrrp_t *vrrp, struct iphdr *ip, vrrphdr_t *hd)
+{
+	uint32_t new_saddr;
+
+	if (__test_bit(VRRP_FLAG_SADDR_FROM_CONFIG, &vrrp->flags))
+		return;
+
+	new_saddr = PTR_CAST_CONST(struct sockaddr_in, &vrrp->saddr)->sin_addr.s_addr;
+	if (ip->saddr == new_saddr)
+		return;
+
+	if (vrrp->version == VRRP_VERSION_3)
+		hd->chksum = csum_incremental_update32(hd->chksum, ip->saddr, new_saddr);
+	ip->saddr = new_saddr;
+}
+
 static void
 vrrp_update_pkt(vrrp_t *vrrp, uint8_t prio, sockaddr_t *addr)
 {
-	char *bufptr = vrrp->send_buffer;
 	vrrphdr_t *hd;
 #ifdef _WITH_VRRP_AUTH_
 	bool final_update;
 	unicast_peer_t *peer = NULL;
 #endif
-	uint32_t new_saddr = 0;
 	uint32_t new_daddr;
 
 #ifdef _WITH_VRRP_AUTH_
@@ -401,28 +451,8 @@ vrrp_update_pkt(vrrp_t *vrrp, uint8_t prio, sockaddr_t *addr)
 	final_update = (!peer || list_is_last(&peer->e_list, &vrrp->unicast_peer) || addr);
 #endif
 
-	if (vrrp->family == AF_INET) {
-		bufptr += sizeof(struct iphdr);
-
-#ifdef _WITH_VRRP_AUTH_
-		if (vrrp->auth_type == VRRP_AUTH_AH)
-			bufptr += sizeof(ipsec_ah_t);
-#endif
-	}
-
-	hd = PTR_CAST(vrrphdr_t, bufptr);
-	if (hd->priority != prio) {
-		if (vrrp->family == AF_INET) {
-			/* HC' = ~(~HC + ~m + m') */
-			uint16_t *prio_addr = PTR_CAST(uint16_t, ((char *)&hd->priority - (((char *)hd -(char *)&hd->priority) & 1)));
-			uint16_t old_val = *prio_addr;
-
-			hd->priority = prio;
-			hd->chksum = csum_incremental_update16(hd->chksum, old_val, *prio_addr);
-		}
-		else
-			hd->priority = prio;
-	}
+	hd = vrrp_pkt_header(vrrp, vrrp->send_buffer);
+	vrrp_pkt_set_prio(vrrp, hd, prio);
 
 	if (vrrp->family == AF_INET) {
 		struct iphdr *ip = PTR_CAST(struct iphdr, (vrrp->send_buffer));
@@ -450,24 +480,15 @@ vrrp_update_pkt(vrrp_t *vrrp, uint8_t prio, sockaddr_t *addr)
 		}
 
 		/* Has the source address changed? */
-		if (!__test_bit(VRRP_FLAG_SADDR_FROM_CONFIG, &vrrp->flags) &&
-		    ip->saddr != PTR_CAST(struct sockaddr_in, &vrrp->saddr)->sin_addr.s_addr) {
-			if (vrrp->version == VRRP_VERSION_2)
-				ip->saddr = PTR_CAST(struct sockaddr_in, &vrrp->saddr)->sin_addr.s_addr;
-			else {
-				new_saddr = PTR_CAST(struct sockaddr_in, &vrrp->saddr)->sin_addr.s_addr;
-				hd->chksum = csum_incremental_update32(hd->chksum, ip->saddr, new_saddr);
-				ip->saddr = new_saddr;
-			}
-		}
+		vrrp_pkt_set_saddr(vrrp, ip, hd);
 
 #ifdef _WITH_VRRP_AUTH_
 		if (vrrp->auth_type == VRRP_AUTH_AH) {
 			unsigned char digest[MD5_DIGEST_LENGTH];
 			ipsec_ah_t *ah = PTR_CAST(ipsec_ah_t, (vrrp->send_buffer + sizeof (struct iphdr)));
 
-			if (new_saddr)
-				ah->spi = new_saddr;
+			/* The SPI is the source address */
+			ah->spi = ip->saddr;
 
 			if (!addr) {
 				/* Processing sequence number.
@@ -536,6 +557,9 @@ vrrp_csum_mcast(vrrp_t *vrrp)
 		/* The checksum is calculated using the standard multicast address */
 		hd->chksum = csum_incremental_update32(hd->chksum, ip->daddr, global_data->vrrp_mcast_group4.sin_addr.s_addr);
 	}
+
+	/* The unicast peers' copies must be made again with the new checksum */
+	vrrp->unicast_templates_set = false;
 }
 #endif
 
@@ -636,10 +660,10 @@ vrrp_in_chk_vips(const vrrp_t *vrrp, const ip_address_t *ipaddress, const void *
 
 #ifdef _CHECKSUM_DEBUG_
 static void
-check_tx_checksum(vrrp_t *vrrp, unicast_peer_t *peer)
+check_tx_checksum(vrrp_t *vrrp, unicast_peer_t *peer, char *buf)
 {
-	struct iphdr *ip = PTR_CAST(struct iphdr, vrrp->send_buffer);
-	vrrphdr_t *hd = PTR_CAST(vrrphdr_t, ((char *)vrrp->send_buffer + sizeof(struct iphdr)));
+	struct iphdr *ip = PTR_CAST(struct iphdr, buf);
+	vrrphdr_t *hd = PTR_CAST(vrrphdr_t, (buf + sizeof(struct iphdr)));
 	size_t vrrppkt_len;
 	uint32_t acc_csum;
 	ipv4_phdr_t ipv4_phdr;
@@ -712,7 +736,7 @@ check_tx_checksum(vrrp_t *vrrp, unicast_peer_t *peer)
 
 		if (vrrp->version == VRRP_VERSION_3)
 			log_buffer("IPv4 pseudo header", &ipv4_phdr, sizeof ipv4_phdr);
-		log_buffer("Advert packet", vrrp->send_buffer, vrrp->send_buffer_size);
+		log_buffer("Advert packet", buf, vrrp->send_buffer_size);
 
 		chk->sent_to = true;
 		chk->last_tx_checksum = acc_csum;
@@ -1595,6 +1619,9 @@ vrrp_build_pkt(vrrp_t * vrrp)
 	}
 	else if (vrrp->family == AF_INET6)
 		vrrp_build_vrrp(vrrp, vrrp->send_buffer, NULL);
+
+	/* The unicast peers' copies must be made again */
+	vrrp->unicast_templates_set = false;
 }
 
 /* send VRRP packet */
@@ -1648,7 +1675,7 @@ vrrp_build_ancillary_data(struct msghdr *msg, char *cbuf, sockaddr_t *src, const
 }
 
 static ssize_t
-vrrp_send_pkt(vrrp_t * vrrp, unicast_peer_t *peer)
+vrrp_send_pkt(vrrp_t * vrrp)
 {
 	sockaddr_t *src = &vrrp->saddr;
 	struct msghdr msg;
@@ -1666,15 +1693,8 @@ vrrp_send_pkt(vrrp_t * vrrp, unicast_peer_t *peer)
 	if (vrrp->family == AF_INET6)
 		memset(cbuf, 0, sizeof(cbuf));
 
-	/* Unicast sending path */
-	if (peer && peer->address.ss_family == AF_INET) {
-		msg.msg_name = &peer->address;
-		msg.msg_namelen = sizeof(struct sockaddr_in);
-	} else if (peer && peer->address.ss_family == AF_INET6) {
-		msg.msg_name = &peer->address;
-		msg.msg_namelen = sizeof(struct sockaddr_in6);
-		vrrp_build_ancillary_data(&msg, cbuf, src, vrrp);
-	} else if (vrrp->family == AF_INET) { /* Multicast sending path */
+	/* Multicast sending path */
+	if (vrrp->family == AF_INET) {
 		msg.msg_name = &vrrp->mcast_daddr;
 		msg.msg_namelen = sizeof(struct sockaddr_in);
 	} else if (vrrp->family == AF_INET6) {
@@ -1685,28 +1705,141 @@ vrrp_send_pkt(vrrp_t * vrrp, unicast_peer_t *peer)
 
 #ifdef _CHECKSUM_DEBUG_
 	if (vrrp->family == AF_INET && do_checksum_debug)
-		check_tx_checksum(vrrp, peer);
+		check_tx_checksum(vrrp, NULL, vrrp->send_buffer);
 #endif
 
 	/* Send the packet */
-	return sendmsg(vrrp->sockets->fd_out, &msg, (peer) ? 0 : MSG_DONTROUTE);
+	return sendmsg(vrrp->sockets->fd_out, &msg, MSG_DONTROUTE);
+}
+
+/* Whether the IPv4 unicast peers' copies of the advert can be kept between
+ * adverts and updated in place. Authentication data covers the whole packet,
+ * so with authentication they are copied from send_buffer for each advert. */
+static inline bool
+vrrp_unicast_templates(__attribute__((unused)) const vrrp_t *vrrp)
+{
+#ifdef _WITH_VRRP_AUTH_
+	if (vrrp->auth_type == VRRP_AUTH_AH || vrrp->auth_hmac)
+		return false;
+#endif
+
+	return true;
+}
+
+/* Update a unicast peer's copy of the advert for the next advert. Only the
+ * fields that can change between adverts are written, and the checksum is
+ * adjusted incrementally (RFC 1624), so the VIPs are not summed again. */
+static void
+vrrp_update_template(const vrrp_t *vrrp, char *buf, uint8_t prio)
+{
+	struct iphdr *ip = PTR_CAST(struct iphdr, buf);
+	vrrphdr_t *hd = vrrp_pkt_header(vrrp, buf);
+
+	vrrp_pkt_set_prio(vrrp, hd, prio);
+	ip->id = htons(vrrp->ip_id);
+	vrrp_pkt_set_saddr(vrrp, ip, hd);
+}
+
+/* Unicast sending path. The packets for all the peers are prepared first
+ * and then sent with sendmmsg(). For IPv4 each peer has its own copy of
+ * the packet, since the destination address and, for VRRPv3, the checksum
+ * differ. The copies are made from send_buffer for the first advert, or
+ * after send_buffer has been rebuilt, and are then updated in place. */
+static void
+vrrp_send_unicast(vrrp_t *vrrp, uint8_t prio)
+{
+	unicast_peer_t *peer;
+	struct msghdr ancillary;
+	struct msghdr *msg;
+	char cbuf[256] __attribute__((aligned(__alignof__(struct cmsghdr))));
+	unsigned i = 0;
+	int sent;
+
+	memset(&ancillary, 0, sizeof(ancillary));
+	if (vrrp->family == AF_INET6) {
+		/* glibc's CMSG_NXTHDR requires the buffer to have been initialised to all 0s */
+		memset(cbuf, 0, sizeof(cbuf));
+		vrrp_build_ancillary_data(&ancillary, cbuf, &vrrp->saddr, vrrp);
+	}
+
+	list_for_each_entry(peer, &vrrp->unicast_peer, e_list) {
+		msg = &vrrp->unicast_msgs[i].msg_hdr;
+
+		if (vrrp->family == AF_INET) {
+			if (vrrp->unicast_templates_set)
+				vrrp_update_template(vrrp, vrrp->unicast_iov[i].iov_base, prio);
+			else {
+				vrrp_update_pkt(vrrp, prio, &peer->address);
+				memcpy(vrrp->unicast_iov[i].iov_base, vrrp->send_buffer, vrrp->send_buffer_size);
+			}
+#ifdef _CHECKSUM_DEBUG_
+			if (do_checksum_debug)
+				check_tx_checksum(vrrp, peer, vrrp->unicast_iov[i].iov_base);
+#endif
+		} else if (peer->address.ss_family == AF_INET6) {
+			msg->msg_control = ancillary.msg_control;
+			msg->msg_controllen = ancillary.msg_controllen;
+		}
+
+		i++;
+	}
+
+	if (vrrp->family == AF_INET)
+		vrrp->unicast_templates_set = vrrp_unicast_templates(vrrp);
+
+	/* sendmmsg() stops at the first message that cannot be sent. Report
+	 * that peer and carry on with the following ones. */
+	for (i = 0; i < vrrp->num_unicast_peers; i += (unsigned)sent) {
+		sent = sendmmsg(vrrp->sockets->fd_out, vrrp->unicast_msgs + i, vrrp->num_unicast_peers - i, 0);
+		if (sent > 0)
+			continue;
+
+		if (prio != VRRP_PRIO_STOP || errno != ENETUNREACH || (vrrp->ifp && IF_FLAGS_UP(vrrp->ifp)))
+			log_message(LOG_INFO, "(%s) Cant send advert to %s (%m)"
+					    , vrrp->iname, inet_sockaddrtos(PTR_CAST(sockaddr_t, vrrp->unicast_msgs[i].msg_hdr.msg_name)));
+		sent = 1;
+	}
 }
 
-/* Allocate the sending buffer */
+/* Allocate the sending buffer, and the messages for the unicast peers */
 static void
 vrrp_alloc_send_buffer(vrrp_t * vrrp)
 {
+	unicast_peer_t *peer;
+	struct msghdr *msg;
+	unsigned i = 0;
+
 	vrrp->send_buffer_size = vrrp_adv_len(vrrp);
 
 	vrrp->send_buffer = MALLOC(vrrp->send_buffer_size);
+
+	if (list_empty(&vrrp->unicast_peer))
+		return;
+
+	list_for_each_entry(peer, &vrrp->unicast_peer, e_list)
+		vrrp->num_unicast_peers++;
+
+	vrrp->unicast_msgs = MALLOC(vrrp->num_unicast_peers * sizeof(*vrrp->unicast_msgs));
+	vrrp->unicast_iov = MALLOC(vrrp->num_unicast_peers * sizeof(*vrrp->unicast_iov));
+	if (vrrp->family == AF_INET)
+		vrrp->unicast_buffers = MALLOC(vrrp->num_unicast_peers * vrrp->send_buffer_size);
+
+	list_for_each_entry(peer, &vrrp->unicast_peer, e_list) {
+		msg = &vrrp->unicast_msgs[i].msg_hdr;
+		msg->msg_name = &peer->address;
+		msg->msg_namelen = peer->address.ss_family == AF_INET6 ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+		msg->msg_iov = &vrrp->unicast_iov[i];
+		msg->msg_iovlen = 1;
+		vrrp->unicast_iov[i].iov_base = vrrp->unicast_buffers ? vrrp->unicast_buffers + i * vrrp->send_buffer_size : vrrp->send_buffer;
+		vrrp->unicast_iov[i].iov_len = vrrp->send_buffer_size;
+		i++;
+	}
 }
 
 /* send VRRP advertisement */
 void
 vrrp_send_adv(vrrp_t * vrrp, uint8_t prio)
 {
-	unicast_peer_t *peer;
-
 	if (!vrrp->sockets || vrrp->sockets->fd_out == -1)
 		return;
 
@@ -1743,19 +1876,11 @@ vrrp_send_adv(vrrp_t * vrrp, uint8_t prio)
 	vrrp->last_advert_sent = time_now;
 	if (!__test_bit(VRRP_FLAG_UNICAST, &vrrp->flags)) {
 // What if mcast_src_ip is configured?
-		if (vrrp_send_pkt(vrrp, NULL) == -1 &&
+		if (vrrp_send_pkt(vrrp) == -1 &&
 		    (prio != VRRP_PRIO_STOP || errno != ENETUNREACH || (vrrp->ifp && IF_FLAGS_UP(vrrp->ifp))))
 			log_message(LOG_INFO, "(%s): send advert error %d (%m)", vrrp->iname, errno);
-	} else {
-		list_for_each_entry(peer, &vrrp->unicast_peer, e_list) {
-			if (vrrp->family == AF_INET)
-				vrrp_update_pkt(vrrp, prio, &peer->address);
-			if (vrrp_send_pkt(vrrp, peer) == -1 &&
-			    (prio != VRRP_PRIO_STOP || errno != ENETUNREACH || (vrrp->ifp && IF_FLAGS_UP(vrrp->ifp))))
-				log_message(LOG_INFO, "(%s) Cant send advert to %s (%m)"
-						    , vrrp->iname, inet_sockaddrtos(&peer->address));
-		}
-	}
+	} else
+		vrrp_send_unicast(vrrp, prio);
 
 	++vrrp->stats->advert_sent;
 }
@@ -2912,6 +3037,82 @@ open_vrrp_read_socket(sa_family_t family, int proto, const interface_t *ifp,
 	return fd;
 }
 
+/* Have the kernel discard adverts that would be ignored (see vrrp_rx_filter).
+ * IPv4 packets start with the IP header, and IPv6 packets with the VRRP header. */
+static void
+vrrp_set_rx_filter(const sock_t *sock)
+{
+	struct sock_filter code[16 + 256];
+	struct sock_fprog prog;
+	const vrrp_t *vrrp;
+	bool strict = global_data->vrrp_rx_filter == VRRP_RX_FILTER_STRICT;
+	unsigned versions = 0;
+	unsigned short n = 0, first, i;
+	int last_vrid = -1;
+
+	/* The VRRP header follows the AH header for AH sockets */
+	if (global_data->vrrp_rx_filter == VRRP_RX_FILTER_NONE ||
+	    sock->proto != IPPROTO_VRRP)
+		return;
+
+	/* X is the offset of the VRRP header */
+	if (sock->family == AF_INET)
+		code[n++] = (struct sock_filter)BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 0);
+	else
+		code[n++] = (struct sock_filter)BPF_STMT(BPF_LDX | BPF_W | BPF_IMM, 0);
+
+	if (strict) {
+		/* The TTL is not checked for unicast, and IPv6 hop limits are
+		 * only available as ancillary data */
+		if (sock->family == AF_INET && !sock->unicast_src) {
+			code[n++] = (struct sock_filter)BPF_STMT(BPF_LD | BPF_B | BPF_ABS, offsetof(struct iphdr, ttl));
+			code[n++] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, VRRP_IP_TTL, 1, 0);
+			code[n++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, 0);
+		}
+
+		rb_for_each_entry_const(vrrp, &sock->rb_vrid, rb_vrid)
+			versions |= 1U << vrrp->version;
+
+		/* The version can only be checked if all the instances use the same one */
+		if (versions && !(versions & (versions - 1))) {
+			code[n++] = (struct sock_filter)BPF_STMT(BPF_LD | BPF_B | BPF_IND, offsetof(vrrphdr_t, vers_type));
+			code[n++] = (struct sock_filter)BPF_STMT(BPF_ALU | BPF_RSH | BPF_K, 4);
+			code[n++] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, (unsigned)__builtin_ctz(versions), 1, 0);
+			code[n++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, 0);
+		}
+	}
+
+	if (!global_data->log_unknown_vrids) {
+		code[n++] = (struct sock_filter)BPF_STMT(BPF_LD | BPF_B | BPF_IND, offsetof(vrrphdr_t, vrid));
+
+		/* rb_vrid is sorted by VRID, and can have duplicates for unicast */
+		first = n;
+		rb_for_each_entry_const(vrrp, &sock->rb_vrid, rb_vrid) {
+			if (vrrp->vrid == last_vrid)
+				continue;
+			last_vrid = vrrp->vrid;
+			code[n++] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, vrrp->vrid, 0, 0);
+		}
+
+		/* A match jumps past the following return to the accepting one.
+		 * There are at most 255 VRIDs, so the offsets fit in jt. */
+		for (i = first; i < n; i++)
+			code[i].jt = (uint8_t)(n - i);
+		code[n++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, 0);
+	}
+
+	/* Nothing to check */
+	if (n == 1)
+		return;
+
+	code[n++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, UINT32_MAX);
+
+	prog.len = n;
+	prog.filter = code;
+	if (setsockopt(sock->fd_in, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)))
+		log_message(LOG_INFO, "fd %d - can't set SO_ATTACH_FILTER for received adverts. errno=%d (%m)", sock->fd_in, errno);
+}
+
 void
 open_sockpool_socket(sock_t *sock)
 {
@@ -2945,14 +3146,18 @@ open_sockpool_socket(sock_t *sock)
 		sock->fd_in = -1;
 	}
 
-	if (sock->fd_in == -1)
+	if (sock->fd_in == -1) {
 		sock->fd_out = -1;
-	else
-		sock->fd_out = open_vrrp_send_socket(sock->family, sock->proto, sock->ifp,
+		return;
+	}
+
+	vrrp_set_rx_filter(sock);
+
+	sock->fd_out = open_vrrp_send_socket(sock->family, sock->proto, sock->ifp,
 #ifdef _HAVE_VRF_
-						     sock->vrf_ifp,
+					     sock->vrf_ifp,
 #endif
-						     sock->unicast_src);
+					     sock->unicast_src);
 }
 
 /* Try to find a VRRP instance */
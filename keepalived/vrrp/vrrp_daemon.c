@@ -55,6 +55,7 @@
 #include "global_data.h"
 #include "pidfile.h"
 #include "logger.h"
+#include "event_log.h"
 #include "signals.h"
 #include "process.h"
 #include "memory.h"
@@ -200,7 +201,35 @@ set_vrrp_max_fds(void)
 	 *
 	 * 20 spare (in case we have forgotten anything)
 	 */
-	set_max_file_limit(cnt * 2 + vrrp_data->num_smtp_alert + 23 + 20);
+	cnt = cnt * 2 + vrrp_data->num_smtp_alert + 23 + 20;
+	set_max_file_limit(cnt);
+	thread_set_max_fds(master, cnt);
+}
+
+/* Delaying timers must not change the order in which backups with adjacent
+ * priorities time out, so the window is limited to a quarter of the smallest
+ * skew time between priorities. */
+static unsigned long
+vrrp_timer_coalesce_window(void)
+{
+	vrrp_t *vrrp;
+	unsigned long max_window = ULONG_MAX;
+
+	if (!global_data->vrrp_timer_coalesce)
+		return 0;
+
+	list_for_each_entry(vrrp, &vrrp_data->vrrp, e_list) {
+		if (VRRP_TIMER_SKEW_MIN(vrrp) / 4 < max_window)
+			max_window = VRRP_TIMER_SKEW_MIN(vrrp) / 4;
+	}
+
+	if (global_data->vrrp_timer_coalesce <= max_window)
+		return global_data->vrrp_timer_coalesce;
+
+	log_message(LOG_INFO, "vrrp_timer_coalesce reduced from %u to %lu usecs to preserve VRRP skew times",
+			global_data->vrrp_timer_coalesce, max_window);
+
+	return max_window;
 }
 
 #ifdef _WITH_LVS_
@@ -303,8 +332,15 @@ vrrp_terminate_phase2(int exit_status)
 #endif
 
 	kernel_netlink_close_cmd();
+#ifdef _WITH_JSON_
+	vrrp_json_socket_close();
+#endif
+	vrrp_stats_socket_close();
+	vrrp_metrics_socket_close();
 	thread_destroy_master(master);
 	master = NULL;
+	close_log_queue();
+	log_event(EVENT_PROCESS_STOP, 0, 0, "%s", "VRRP");
 	gratuitous_arp_close();
 	ndisc_close();
 #ifdef _WITH_LINKBEAT_
@@ -510,6 +546,8 @@ delayed_start_clear_thread(__attribute__((unused)) thread_ref_t thread)
 static void
 start_vrrp(data_t *prev_global_data)
 {
+	log_event(EVENT_PROCESS_START, reload, 0, "%s", "VRRP");
+
 	/* Clear the flags used for optimising performance */
 	clear_summary_flags();
 
@@ -724,6 +762,25 @@ start_vrrp(data_t *prev_global_data)
 	/* Set the process cpu affinity if configured */
 	set_process_cpu_affinity(&global_data->vrrp_cpu_mask, "vrrp");
 
+	/* Limit the bulk fd threads run per wakeup if configured */
+	thread_set_budgets(master, global_data->vrrp_read_budget, global_data->vrrp_write_budget);
+	thread_set_slab_high_water(master, global_data->scheduler_slab_high_water);
+	thread_set_timer_slack(master, global_data->scheduler_timer_slack);
+
+	/* Queue log messages to be written when the process is idle if configured */
+	open_log_queue(global_data->log_queue_size);
+	thread_set_timer_coalesce(master, vrrp_timer_coalesce_window());
+
+#ifdef _WITH_JSON_
+	/* Serve the JSON state to clients connecting to the socket */
+	if (global_data->json_socket)
+		vrrp_json_socket_open(global_data->json_socket);
+#endif
+	if (global_data->stats_socket)
+		vrrp_stats_socket_open();
+	if (global_data->metrics_socket || global_data->metrics_port)
+		vrrp_metrics_socket_open();
+
 	/* Ensure we can open sufficient file descriptors */
 	set_vrrp_max_fds();
 }
@@ -875,6 +932,11 @@ reload_vrrp_thread(__attribute__((unused)) thread_ref_t thread)
 	cancel_vrrp_threads();
 #endif
 	cancel_kernel_netlink_threads();
+#ifdef _WITH_JSON_
+	vrrp_json_socket_close();
+#endif
+	vrrp_stats_socket_close();
+	vrrp_metrics_socket_close();
 	thread_cleanup_master(master, true);
 	thread_add_base_threads(master, with_snmp);
 
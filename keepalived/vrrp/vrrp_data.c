@@ -56,7 +56,7 @@ vrrp_data_t *old_vrrp_data = NULL;
 void *vrrp_buffer;
 size_t vrrp_buffer_len;
 
-static const char *
+const char *
 get_state_str(int state)
 {
 	if (state == VRRP_STATE_INIT) return "INIT";
@@ -564,10 +564,14 @@ static void
 free_vrrp(vrrp_t *vrrp)
 {
 	FREE_CONST(vrrp->iname);
+	free_query_track(&vrrp->query_track);
 #ifdef _HAVE_VRRP_IPVLAN_
 	FREE_PTR(vrrp->ipvlan_addr);
 #endif
 	FREE_PTR(vrrp->send_buffer);
+	FREE_PTR(vrrp->unicast_msgs);
+	FREE_PTR(vrrp->unicast_iov);
+	FREE_PTR(vrrp->unicast_buffers);
 	free_notify_script(&vrrp->script_backup);
 	free_notify_script(&vrrp->script_master);
 	free_notify_script(&vrrp->script_fault);
@@ -1332,7 +1336,7 @@ alloc_vrrp_buffer(size_t len)
 	if (vrrp_buffer)
 		FREE(vrrp_buffer);
 
-	vrrp_buffer = MALLOC(len);
+	vrrp_buffer = MALLOC(len * VRRP_RX_BATCH);
 	vrrp_buffer_len = (vrrp_buffer) ? len : 0;
 }
 
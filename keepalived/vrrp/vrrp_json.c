@@ -28,6 +28,7 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "vrrp.h"
@@ -42,6 +43,8 @@
 #include "utils.h"
 #include "global_data.h"
 #include "json_writer.h"
+#include "scheduler.h"
+#include "query_socket.h"
 
 static inline double
 timeval_to_double(const timeval_t *t)
@@ -319,18 +322,19 @@ vrrp_json_vprocesses_dump(json_writer_t *wr)
 }
 #endif
 
-/*
- *	Split dump function for future purpose
- *	this offer generic integration for mapping
- *	socket fd to a FILE stream.
- */
-static int
-vrrp_json_dump(FILE *fp)
+static query_socket_t *json_socket;
+
+/* The length of the previous output, so the buffer is the right size */
+static size_t json_size_hint;
+
+static char *
+vrrp_json_dump(size_t *len)
 {
 	json_writer_t *wr;
 	vrrp_t *vrrp;
+	char *buf;
 
-	wr = jsonw_new(fp);
+	wr = jsonw_new_buffer(json_size_hint + json_size_hint / 8);
 
 	if (global_data->json_version == JSON_VERSION_V2) {
 		jsonw_start_object(wr);
@@ -354,20 +358,45 @@ vrrp_json_dump(FILE *fp)
 			vrrp_json_vprocesses_dump(wr);
 #endif
 
+		jsonw_name(wr, "scheduler");
+		dump_scheduler_json(master, wr);
+
 		jsonw_end_object(wr);
 	}
 
-	jsonw_destroy(&wr);
-	return 0;
+	buf = jsonw_detach(&wr, len);
+	json_size_hint = *len;
+
+	return buf;
+}
+
+static bool
+write_all(int fd, const char *buf, size_t len)
+{
+	ssize_t ret;
+
+	while (len) {
+		ret = write(fd, buf, len);
+		if (ret == -1) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		buf += ret;
+		len -= (size_t)ret;
+	}
+
+	return true;
 }
 
 void
 vrrp_print_json(void)
 {
 	int fd;
-	FILE *fp;
 	const char *filename;
 	char file_tmp_name[PATH_MAX];
+	char *buf;
+	size_t len;
 
 	if (list_empty(&vrrp_data->vrrp))
 		return;
@@ -385,15 +414,34 @@ vrrp_print_json(void)
 	if (fd == -1)
 		log_message(LOG_INFO, "Unable to create temporary json file '%s' - errno %d (%m)", file_tmp_name, errno);
 	else {
-		fp = fdopen(fd, "w+e");
-		if (fp) {
-			vrrp_json_dump(fp);
-			fclose(fp);
-			if (rename(file_tmp_name, filename))
-				log_message(LOG_INFO, "Failed to rename %s to %s - errno %d (%m)", file_tmp_name, filename, errno);
-		} else
-			log_message(LOG_INFO, "Can't create %s (%d: %m)", filename, errno);
+		buf = vrrp_json_dump(&len);
+		if (!write_all(fd, buf, len)) {
+			log_message(LOG_INFO, "Can't write %s (%d: %m)", file_tmp_name, errno);
+			unlink(file_tmp_name);
+		} else if (rename(file_tmp_name, filename))
+			log_message(LOG_INFO, "Failed to rename %s to %s - errno %d (%m)", file_tmp_name, filename, errno);
+		close(fd);
+		FREE(buf);
 	}
 
 	FREE_CONST(filename);
 }
+
+static void
+vrrp_json_query(query_buf_t *b, __attribute__((unused)) const query_req_t *req)
+{
+	b->buf = vrrp_json_dump(&b->len);
+	b->size = b->len;
+}
+
+void
+vrrp_json_socket_open(const char *path)
+{
+	json_socket = open_query_socket(path, vrrp_json_query, QUERY_DUMP);
+}
+
+void
+vrrp_json_socket_close(void)
+{
+	close_query_socket(&json_socket);
+}
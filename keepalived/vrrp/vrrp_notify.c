@@ -36,6 +36,7 @@
 #include "global_data.h"
 #include "notify.h"
 #include "logger.h"
+#include "event_log.h"
 #if defined _WITH_SNMP_RFC_ || defined _WITH_SNMP_VRRP_
 #include "vrrp_snmp.h"
 #endif
@@ -283,6 +284,8 @@ send_instance_notifies(vrrp_t *vrrp)
 
 	vrrp->notifies_sent = true;
 
+	log_event(EVENT_VRRP_STATE, (uint32_t)vrrp->state, (uint32_t)vrrp->effective_priority, "%s", vrrp->iname);
+
 	/* Launch the notify_* script */
 	if (script) {
 		if (vrrp->state == VRRP_STATE_STOP)
@@ -323,6 +326,8 @@ send_group_notifies(vrrp_sgroup_t *vgroup)
 	notify_script_t *script = get_gscript(vgroup, vgroup->state);
 	notify_script_t *gscript = get_ggscript(vgroup);
 
+	log_event(EVENT_VRRP_GROUP_STATE, (uint32_t)vgroup->state, 0, "%s", vgroup->gname);
+
 	/* Launch the notify_* script */
 	if (script)
 		notify_exec(script);
@@ -342,6 +347,8 @@ send_group_notifies(vrrp_sgroup_t *vgroup)
 void
 send_instance_priority_notifies(vrrp_t *vrrp)
 {
+	log_event(EVENT_VRRP_PRIORITY, (uint32_t)vrrp->effective_priority, (uint32_t)vrrp->state, "%s", vrrp->iname);
+
 	notify_fifo(vrrp->iname,
 		    vrrp->state == VRRP_STATE_MAST ? VRRP_EVENT_MASTER_PRIORITY_CHANGE : VRRP_EVENT_BACKUP_PRIORITY_CHANGE,
 		    false,
@@ -26,6 +26,7 @@
 
 #include <errno.h>
 #include <inttypes.h>
+#include <stddef.h>
 
 #include "logger.h"
 #include "list_head.h"
@@ -35,6 +36,9 @@
 #include "vrrp_data.h"
 #include "vrrp_print.h"
 #include "utils.h"
+#include "scheduler.h"
+#include "query_socket.h"
+#include "metrics.h"
 
 
 void
@@ -48,6 +52,7 @@ vrrp_print_data(void)
 		return;
 
 	dump_data_vrrp(fp);
+	dump_scheduler_data(master, fp);
 
 	fclose(fp);
 }
@@ -113,3 +118,213 @@ vrrp_print_stats(bool clear_stats)
 	}
 	fclose(file);
 }
+
+static query_socket_t *stats_socket;
+
+static void
+vrrp_query_instance(query_buf_t *b, const vrrp_t *vrrp)
+{
+	const vrrp_stats *stats = vrrp->stats;
+
+	query_printf(b, "instance %s\n", vrrp->iname);
+	query_printf(b, "state %s\n", get_state_str(vrrp->state));
+	query_printf(b, "interface %s\n", vrrp->ifp ? vrrp->ifp->ifname : "");
+	query_printf(b, "vrid %u\n", vrrp->vrid);
+	query_printf(b, "priority %u\n", vrrp->base_priority);
+	query_printf(b, "effective_priority %u\n", vrrp->effective_priority);
+	query_printf(b, "last_transition %" PRI_tv_sec ".%6.6" PRI_tv_usec "\n",
+		     vrrp->last_transition.tv_sec, vrrp->last_transition.tv_usec);
+	query_printf(b, "advert_rcvd %" PRIu64 "\n", stats->advert_rcvd);
+	query_printf(b, "advert_sent %u\n", stats->advert_sent);
+	query_printf(b, "become_master %u\n", stats->become_master);
+	query_printf(b, "release_master %u\n", stats->release_master);
+	query_printf(b, "packet_len_err %" PRIu64 "\n", stats->packet_len_err);
+	query_printf(b, "ip_ttl_err %" PRIu64 "\n", stats->ip_ttl_err);
+	query_printf(b, "invalid_type_rcvd %" PRIu64 "\n", stats->invalid_type_rcvd);
+	query_printf(b, "advert_interval_err %" PRIu64 "\n", stats->advert_interval_err);
+	query_printf(b, "addr_list_err %" PRIu64 "\n", stats->addr_list_err);
+	query_printf(b, "invalid_authtype %u\n", stats->invalid_authtype);
+#ifdef _WITH_VRRP_AUTH_
+	query_printf(b, "authtype_mismatch %u\n", stats->authtype_mismatch);
+	query_printf(b, "auth_failure %u\n", stats->auth_failure);
+	query_printf(b, "auth_ext_missing %u\n", stats->auth_ext_missing);
+	query_printf(b, "auth_ext_malformed %u\n", stats->auth_ext_malformed);
+	query_printf(b, "auth_ext_unknown_key %u\n", stats->auth_ext_unknown_key);
+	query_printf(b, "auth_ext_invalid_hmac %u\n", stats->auth_ext_invalid_hmac);
+	query_printf(b, "auth_ext_stale %u\n", stats->auth_ext_stale);
+	query_printf(b, "auth_ext_replay %u\n", stats->auth_ext_replay);
+#endif
+	query_printf(b, "pri_zero_rcvd %" PRIu64 "\n", stats->pri_zero_rcvd);
+	query_printf(b, "pri_zero_sent %" PRIu64 "\n", stats->pri_zero_sent);
+}
+
+static void
+vrrp_stats_query(query_buf_t *b, const query_req_t *req)
+{
+	vrrp_t *vrrp;
+	size_t start;
+
+	list_for_each_entry(vrrp, &vrrp_data->vrrp, e_list) {
+		if (!query_match(req, vrrp->iname))
+			continue;
+
+		if (req->cmd == QUERY_LIST) {
+			query_printf(b, "%s\n", vrrp->iname);
+			continue;
+		}
+
+		start = b->len;
+		vrrp_query_instance(b, vrrp);
+		query_object_end(b, start, &vrrp->query_track, req);
+	}
+}
+
+void
+vrrp_stats_socket_open(void)
+{
+	const char *path;
+
+	path = make_file_name(global_data->stats_socket, "vrrp",
+			      global_data->network_namespace, global_data->instance_name);
+	stats_socket = open_query_socket(path, vrrp_stats_query, QUERY_REQUEST);
+	FREE_CONST(path);
+}
+
+void
+vrrp_stats_socket_close(void)
+{
+	close_query_socket(&stats_socket);
+}
+
+static query_socket_t *metrics_socket;
+static query_socket_t *metrics_port_socket;
+
+typedef struct _vrrp_stat_metric {
+	const char	*name;
+	const char	*help;
+	size_t		offset;
+	bool		is_64;
+} vrrp_stat_metric_t;
+
+#define VRRP_STAT_METRIC(name, field, help) \
+	{ "keepalived_vrrp_" name, help, offsetof(vrrp_stats, field), sizeof(((vrrp_stats *)NULL)->field) == sizeof(uint64_t) }
+
+static const vrrp_stat_metric_t vrrp_stat_metrics[] = {
+	VRRP_STAT_METRIC("adverts_received", advert_rcvd, "Adverts received"),
+	VRRP_STAT_METRIC("adverts_sent", advert_sent, "Adverts sent"),
+	VRRP_STAT_METRIC("become_master", become_master, "Transitions to master state"),
+	VRRP_STAT_METRIC("release_master", release_master, "Transitions from master state"),
+	VRRP_STAT_METRIC("packet_length_errors", packet_len_err, "Packets received with an invalid length"),
+	VRRP_STAT_METRIC("advert_interval_errors", advert_interval_err, "Adverts received with a different advert interval"),
+	VRRP_STAT_METRIC("ip_ttl_errors", ip_ttl_err, "Adverts received with a TTL or hop limit other than 255"),
+	VRRP_STAT_METRIC("invalid_type_received", invalid_type_rcvd, "Packets received with an invalid type"),
+	VRRP_STAT_METRIC("address_list_errors", addr_list_err, "Adverts received with a different address list"),
+	VRRP_STAT_METRIC("invalid_authtype", invalid_authtype, "Adverts received with an invalid authentication type"),
+#ifdef _WITH_VRRP_AUTH_
+	VRRP_STAT_METRIC("authtype_mismatch", authtype_mismatch, "Adverts received with a different authentication type"),
+	VRRP_STAT_METRIC("auth_failures", auth_failure, "Adverts received failing authentication"),
+	VRRP_STAT_METRIC("auth_ext_missing", auth_ext_missing, "Adverts received without the authentication extension"),
+	VRRP_STAT_METRIC("auth_ext_malformed", auth_ext_malformed, "Adverts received with a malformed authentication extension"),
+	VRRP_STAT_METRIC("auth_ext_unknown_key", auth_ext_unknown_key, "Adverts received with an unknown authentication key"),
+	VRRP_STAT_METRIC("auth_ext_invalid_hmac", auth_ext_invalid_hmac, "Adverts received with an invalid HMAC"),
+	VRRP_STAT_METRIC("auth_ext_stale", auth_ext_stale, "Adverts received with a stale authentication sequence"),
+	VRRP_STAT_METRIC("auth_ext_replay", auth_ext_replay, "Adverts received that replay an earlier advert"),
+#endif
+	VRRP_STAT_METRIC("priority_zero_received", pri_zero_rcvd, "Adverts received with priority 0"),
+	VRRP_STAT_METRIC("priority_zero_sent", pri_zero_sent, "Adverts sent with priority 0"),
+};
+
+static const int vrrp_metric_states[] = { VRRP_STATE_INIT, VRRP_STATE_BACK, VRRP_STATE_MAST, VRRP_STATE_FAULT };
+
+static void
+vrrp_metrics(query_buf_t *b, __attribute__((unused)) const query_req_t *req)
+{
+	const vrrp_stat_metric_t *stat;
+	const char *labels[] = { "instance", NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+	const char *state_labels[] = { "instance", NULL, "keepalived_vrrp_state", NULL, NULL };
+	char vrid[4];
+	char sample[64];
+	const char *counters;
+	vrrp_t *vrrp;
+	unsigned i;
+
+	metrics_family(b, "keepalived_vrrp_instance", METRICS_INFO, "VRRP instance");
+	list_for_each_entry(vrrp, &vrrp_data->vrrp, e_list) {
+		snprintf(vrid, sizeof(vrid), "%u", vrrp->vrid);
+		labels[1] = vrrp->iname;
+		labels[2] = "interface";
+		labels[3] = vrrp->ifp ? vrrp->ifp->ifname : "";
+		labels[4] = "vrid";
+		labels[5] = vrid;
+		labels[6] = "family";
+		labels[7] = vrrp->family == AF_INET6 ? "inet6" : "inet";
+		metrics_uint(b, "keepalived_vrrp_instance_info", labels, 1);
+	}
+	labels[2] = NULL;
+
+	metrics_family(b, "keepalived_vrrp_state", METRICS_STATESET, "VRRP instance state");
+	list_for_each_entry(vrrp, &vrrp_data->vrrp, e_list) {
+		state_labels[1] = vrrp->iname;
+		for (i = 0; i < sizeof(vrrp_metric_states) / sizeof(vrrp_metric_states[0]); i++) {
+			state_labels[3] = get_state_str(vrrp_metric_states[i]);
+			metrics_uint(b, "keepalived_vrrp_state", state_labels, vrrp->state == vrrp_metric_states[i]);
+		}
+	}
+
+	metrics_family(b, "keepalived_vrrp_priority", METRICS_GAUGE, "Configured priority");
+	list_for_each_entry(vrrp, &vrrp_data->vrrp, e_list) {
+		labels[1] = vrrp->iname;
+		metrics_uint(b, "keepalived_vrrp_priority", labels, vrrp->base_priority);
+	}
+
+	metrics_family(b, "keepalived_vrrp_effective_priority", METRICS_GAUGE, "Priority after tracking adjustments");
+	list_for_each_entry(vrrp, &vrrp_data->vrrp, e_list) {
+		labels[1] = vrrp->iname;
+		metrics_uint(b, "keepalived_vrrp_effective_priority", labels, vrrp->effective_priority);
+	}
+
+	metrics_family(b, "keepalived_vrrp_last_transition_timestamp_seconds", METRICS_GAUGE, "Time of the last state transition");
+	list_for_each_entry(vrrp, &vrrp_data->vrrp, e_list) {
+		labels[1] = vrrp->iname;
+		metrics_usecs(b, "keepalived_vrrp_last_transition_timestamp_seconds", labels,
+			      (uint64_t)vrrp->last_transition.tv_sec * TIMER_HZ + (uint64_t)vrrp->last_transition.tv_usec);
+	}
+
+	for (stat = vrrp_stat_metrics; stat < vrrp_stat_metrics + sizeof(vrrp_stat_metrics) / sizeof(vrrp_stat_metrics[0]); stat++) {
+		metrics_family(b, stat->name, METRICS_COUNTER, stat->help);
+		snprintf(sample, sizeof(sample), "%s_total", stat->name);
+		list_for_each_entry(vrrp, &vrrp_data->vrrp, e_list) {
+			labels[1] = vrrp->iname;
+			counters = PTR_CAST_CONST(char, vrrp->stats);
+			metrics_uint(b, sample, labels,
+				     stat->is_64 ? *PTR_CAST_CONST(uint64_t, counters + stat->offset)
+						 : *PTR_CAST_CONST(uint32_t, counters + stat->offset));
+		}
+	}
+
+	dump_scheduler_metrics(master, b);
+	metrics_eof(b);
+}
+
+void
+vrrp_metrics_socket_open(void)
+{
+	const char *path;
+
+	if (global_data->metrics_socket) {
+		path = make_file_name(global_data->metrics_socket, "vrrp",
+				      global_data->network_namespace, global_data->instance_name);
+		metrics_socket = open_query_socket(path, vrrp_metrics, QUERY_HTTP);
+		FREE_CONST(path);
+	}
+
+	if (global_data->metrics_port)
+		metrics_port_socket = open_query_socket_port(global_data->metrics_port, vrrp_metrics, QUERY_HTTP);
+}
+
+void
+vrrp_metrics_socket_close(void)
+{
+	close_query_socket(&metrics_socket);
+	close_query_socket(&metrics_port_socket);
+}
@@ -334,6 +334,17 @@ vrrp_init_instance_sands(vrrp_t *vrrp)
 	rb_move_cached(&vrrp->rb_sands, &vrrp->sockets->rb_sands, vrrp_timer_less);
 }
 
+/* Compute the next advert time of a master from when the last advert was
+ * due, so that the time taken to send adverts doesn't accumulate as drift */
+static void
+vrrp_next_advert_sands(vrrp_t *vrrp)
+{
+	set_time_now();
+
+	vrrp->sands = timer_next_periodic(vrrp->sands, vrrp->adver_int, TIMER_CATCHUP_SKIP);
+	rb_move_cached(&vrrp->rb_sands, &vrrp->sockets->rb_sands, vrrp_timer_less);
+}
+
 static void
 vrrp_init_sands(list_head_t *l)
 {
@@ -406,7 +417,7 @@ vrrp_register_workers(list_head_t *l)
 // TODO - should we only do this if we have track_bfd? Probably not
 		/* Init BFD tracking thread */
 		bfd_thread = thread_add_read(master, vrrp_bfd_thread, NULL,
-					     bfd_vrrp_event_pipe[0], TIMER_NEVER, 0);
+					     bfd_vrrp_event_pipe[0], TIMER_NEVER, THREAD_PRIORITY);
 	}
 #endif
 
@@ -415,7 +426,7 @@ vrrp_register_workers(list_head_t *l)
 		/* Register a timer thread if interface exists */
 		if (sock->fd_in != -1)
 			sock->thread = thread_add_read_sands(master, vrrp_read_dispatcher_thread,
-						       sock, sock->fd_in, vrrp_compute_timer(sock), 0);
+						       sock, sock->fd_in, vrrp_compute_timer(sock), THREAD_PRIORITY);
 	}
 }
 
@@ -423,7 +434,7 @@ void
 vrrp_thread_add_read(vrrp_t *vrrp)
 {
 	vrrp->sockets->thread = thread_add_read_sands(master, vrrp_read_dispatcher_thread,
-						vrrp->sockets, vrrp->sockets->fd_in, vrrp_compute_timer(vrrp->sockets), 0);
+						vrrp->sockets, vrrp->sockets->fd_in, vrrp_compute_timer(vrrp->sockets), THREAD_PRIORITY);
 }
 
 /* VRRP dispatcher functions */
@@ -574,8 +585,14 @@ vrrp_set_fds(list_head_t *l)
 	vrrp_t *vrrp;
 
 	list_for_each_entry(sock, l, e_list) {
-		rb_for_each_entry(vrrp, &sock->rb_vrid, rb_vrid)
+		rb_for_each_entry(vrrp, &sock->rb_vrid, rb_vrid) {
 			vrrp->sockets = sock;
+
+			/* Received adverts are looked up by VRID, and instances
+			 * with duplicate VRIDs follow the first in rb_vrid */
+			if (!sock->vrid_map[vrrp->vrid])
+				sock->vrid_map[vrrp->vrid] = vrrp;
+		}
 	}
 }
 
@@ -874,7 +891,7 @@ vrrp_bfd_thread(thread_ref_t thread)
 	}
 
 	bfd_thread = thread_add_read(master, vrrp_bfd_thread, NULL,
-				     thread->u.f.fd, TIMER_NEVER, 0);
+				     thread->u.f.fd, TIMER_NEVER, THREAD_PRIORITY);
 
 	if (thread->type != THREAD_READY_READ_FD)
 		return;
@@ -921,56 +938,248 @@ vrrp_dispatcher_read_timeout(sock_t *sock)
 #endif
 		VRRP_TSM_HANDLE(prev_state, vrrp);
 
-		vrrp_init_instance_sands(vrrp);
+		if (prev_state == VRRP_STATE_MAST && vrrp->state == VRRP_STATE_MAST)
+			vrrp_next_advert_sands(vrrp);
+		else
+			vrrp_init_instance_sands(vrrp);
 	}
 
 	return sock->fd_in;
 }
 
-/* Handle dispatcher read packet */
-static int
-vrrp_dispatcher_read(sock_t *sock)
+/* Handle a received advert. Returns true if the advert is the second one for
+ * its VRID, or is not a VRRP packet, so no more should be read for now. */
+static bool
+vrrp_dispatch_packet(sock_t *sock, const char *buffer, ssize_t len, struct msghdr *msghdr, unsigned long *rx_vrid_map)
 {
 	vrrp_t *vrrp;
 	rb_node_t *vrrp_node;
 	const vrrphdr_t *hd;
-	ssize_t len = 0;
 	int prev_state = 0;
-	sockaddr_t src_addr = { .ss_family = AF_UNSPEC };
+	const sockaddr_t *src_addr = msghdr->msg_name;
+	struct cmsghdr *cmsg;
+	bool expected_cmsg;
+	bool terminate_receiving = false;
+	const struct iphdr *iph;
+	unicast_peer_t *unicast_peer;
+
+	/* Check the received data includes at least the IP, possibly
+	 * the AH header and the VRRP header */
+	if (!(hd = vrrp_get_header(sock->family, buffer, len)))
+		return true;
+
+	vrrp = sock->vrid_map[hd->vrid];
+
+	/* No instance found => ignore the advert */
+	if (!vrrp) {
+		if (global_data->log_unknown_vrids)
+			log_message(LOG_INFO, "Unknown VRID(%d) received on interface(%s). ignoring..."
+					    , hd->vrid, IF_NAME(sock->ifp));
+		return false;
+	}
+	vrrp_node = &vrrp->rb_vrid;
+
+	/* Defense strategy here is to handle no more than one advert
+	 * per VRID in order to flush socket rcvq...
+	 * This is a best effort mitigation */
+	if (__test_and_set_bit_array(hd->vrid, rx_vrid_map))
+		terminate_receiving = true;
+
+	if (__test_bit(VRRP_FLAG_UNICAST_DUPLICATE_VRID, &vrrp->flags)) {
+		rb_node_t *first = vrrp_node;	/* Save for second loop */
+
+		/* First check the address we last received an advert from. This is
+		 * an optimisation since we are most likely to receive an advert from
+		 * the same address as last time, and it saves searching all the peers. */
+		for (; vrrp_node; vrrp_node = rb_next_match(&hd->vrid, vrrp_node, vrrp_vrid_cmp)) {
+			vrrp = rb_entry(vrrp_node, vrrp_t, rb_vrid);
+			if (!inet_sockaddrcmp(src_addr, &vrrp->pkt_saddr))
+				break;
+		}
+
+		if (!vrrp_node) {
+			/* Loop through VRRP instances matching hd->vrid if unicast to match
+			 * src address of packet against configured peers */
+			for (vrrp_node = first; vrrp_node; vrrp_node = rb_next_match(&hd->vrid, vrrp_node, vrrp_vrid_cmp)) {
+				vrrp = rb_entry(vrrp_node, vrrp_t, rb_vrid);
+
+				list_for_each_entry(unicast_peer, &vrrp->unicast_peer, e_list) {
+					if (inet_sockaddrcmp(src_addr, &unicast_peer->address) == 0)
+						break;
+					if (list_is_last(&unicast_peer->e_list, &vrrp->unicast_peer)) {
+						unicast_peer = NULL;
+						break;
+					}
+				}
+
+				/* We have found the matching peer */
+				if (unicast_peer)
+					break;
+			}
+
+			if (!vrrp_node) {
+				/* Do nothing and fail because we didn't match any good instance */
+				if (global_data->log_unknown_vrids)
+					log_message(LOG_INFO, "Unknown VRID(%d) received on interface(%s) from %s. ignoring..."
+							    , hd->vrid, IF_NAME(sock->ifp), inet_sockaddrtos(src_addr));
+
+				return terminate_receiving;
+			}
+		}
+	}
+
+	if (vrrp->state == VRRP_STATE_FAULT || vrrp->state == VRRP_STATE_INIT) {
+		/* We just ignore a message received when we are in fault state or
+		 * not yet fully initialised */
+		return terminate_receiving;
+	}
+
+	/* Save non packet data */
+	vrrp->pkt_saddr = *src_addr;
+	vrrp->rx_ttl_hl = -1;           /* Default to not received */
+	if (sock->family == AF_INET) {
+		iph = PTR_CAST_CONST(struct iphdr, buffer);
+		vrrp->multicast_pkt = IN_MULTICAST(htonl(iph->daddr));
+		vrrp->rx_ttl_hl = iph->ttl;
+	} else
+		vrrp->multicast_pkt = false;
+	for (cmsg = CMSG_FIRSTHDR(msghdr); cmsg; cmsg = CMSG_NXTHDR(msghdr, cmsg)) {
+		expected_cmsg = false;
+		if (cmsg->cmsg_level == IPPROTO_IPV6) {
+			expected_cmsg = true;
+
+			if (cmsg->cmsg_type == IPV6_HOPLIMIT &&
+			    cmsg->cmsg_len - sizeof(struct cmsghdr) == sizeof(unsigned int))
+				vrrp->rx_ttl_hl = *PTR_CAST(unsigned int, CMSG_DATA(cmsg));
+			else
+			if (cmsg->cmsg_type == IPV6_PKTINFO &&
+			    cmsg->cmsg_len - sizeof(struct cmsghdr) == sizeof(struct in6_pktinfo))
+				vrrp->multicast_pkt = IN6_IS_ADDR_MULTICAST(&(PTR_CAST(struct in6_pktinfo, CMSG_DATA(cmsg)))->ipi6_addr);
+			else
+				expected_cmsg = false;
+		}
 #ifdef _NETWORK_TIMESTAMP_
-	char control_buf[128] __attribute__((aligned(__alignof__(struct cmsghdr))));
+		else if (do_network_timestamp && cmsg->cmsg_level == SOL_SOCKET) {
+			struct timespec *ts = (void *)CMSG_DATA(cmsg);
+			char time_buf[9];
+
+			expected_cmsg = true;
+			if (cmsg->cmsg_type == SO_TIMESTAMPNS) {
+				strftime(time_buf, sizeof time_buf, "%T", localtime(&ts->tv_sec));
+				log_message(LOG_INFO, "TIMESTAMPNS (socket %d - VRID %u) %s.%9.9" PRI_ts_nsec
+						    , sock->fd_in, hd->vrid, time_buf, ts->tv_nsec);
+			}
+#if 0
+			if (cmsg->cmsg_type == SO_TIMESTAMP) {
+				struct timeval *tv = (void *)CMSG_DATA(cmsg);
+				log_message(LOG_INFO, "TIMESTAMP message (%d - %u)  %" PRI_tv_sec ".%6.6" PRI_tv_usec
+						    , sock->fd_in, hd->vrid, tv->tv_sec, tv->tv_usec);
+			}
+			else if (cmsg->cmsg_type == SO_TIMESTAMPING) {
+				struct timespec *ts = (void *)CMSG_DATA(cmsg);
+				log_message(LOG_INFO, "TIMESTAMPING message (%d - %u)  %" PRI_ts_sec ".%9.9" PRI_ts_nsec ", raw %" PRI_ts_sec ".%9.9" PRI_ts_nsec
+						    , sock->fd_in, hd->vrid, ts->tv_sec, ts->tv_nsec, (ts+2)->tv_sec, (ts+2)->tv_nsec);
+			}
+#endif
+			else
+				expected_cmsg = false;
+		}
+#endif
+
+		if (!expected_cmsg)
+			log_message(LOG_INFO, "fd %d, unexpected control msg len %" PRI_MSG_CONTROLLEN ", level %d, type %d"
+					    , sock->fd_in, cmsg->cmsg_len
+					    , cmsg->cmsg_level, cmsg->cmsg_type);
+	}
+
+	/* For multicast, we attempt to bind the socket to ::1 to stop receiving any (non ::1)
+	 * unicast packets, but if that fails we will receive unicast packets on the multicast socket,
+	 * so just discard them here.
+	 * For unicast sockets, if any other instance on the same interface is using multicast we
+	 * will also receive the multicast packets, so also discard them here. */
+	if (sock->family == AF_INET6 && vrrp->multicast_pkt == __test_bit(VRRP_FLAG_UNICAST, &vrrp->flags)) {
+		if (__test_bit(LOG_DETAIL_BIT, &debug))
+			log_message(LOG_INFO, "(%s) discarding %sicast packet on %sicast instance", vrrp->iname,
+					vrrp->multicast_pkt ? "mult" : "un", __test_bit(VRRP_FLAG_UNICAST, &vrrp->flags) ? "un" : "mult");
+		return terminate_receiving;
+	}
+
+	prev_state = vrrp->state;
+
+	if (vrrp->state == VRRP_STATE_BACK)
+		vrrp_state_backup(vrrp, hd, buffer, len);
+	else if (vrrp->state == VRRP_STATE_MAST) {
+		if (vrrp_state_master_rx(vrrp, hd, buffer, len))
+			vrrp_state_leave_master(vrrp, false);
+	} else
+		log_message(LOG_INFO, "(%s) In dispatcher_read with state %d"
+				    , vrrp->iname, vrrp->state);
+
+
+	/* handle instance synchronization */
+#ifdef _TSM_DEBUG_
+	if (do_tsm_debug)
+		log_message(LOG_INFO, "Read [%s] TSM transition : [%d,%d] Wantstate = [%d]"
+				    , vrrp->iname, prev_state, vrrp->state, vrrp->wantstate);
+#endif
+	VRRP_TSM_HANDLE(prev_state, vrrp);
+
+	/* If we have sent an advert, reset the timer */
+	if (vrrp->state != VRRP_STATE_MAST || !vrrp->lower_prio_no_advert)
+		vrrp_init_instance_sands(vrrp);
+
+	return terminate_receiving;
+}
+
+/* Handle dispatcher read packet */
+static int
+vrrp_dispatcher_read(sock_t *sock)
+{
+	static struct mmsghdr msgs[VRRP_RX_BATCH];
+	static struct iovec iovecs[VRRP_RX_BATCH];
+	static sockaddr_t src_addrs[VRRP_RX_BATCH];
+#ifdef _NETWORK_TIMESTAMP_
+	static char control_bufs[VRRP_RX_BATCH][128] __attribute__((aligned(__alignof__(struct cmsghdr))));
 #else
-	char control_buf[64] __attribute__((aligned(__alignof__(struct cmsghdr))));
+	static char control_bufs[VRRP_RX_BATCH][64] __attribute__((aligned(__alignof__(struct cmsghdr))));
 #endif
-	struct iovec iovec = { .iov_base = vrrp_buffer, .iov_len = vrrp_buffer_len };
-	struct msghdr msghdr = { .msg_name = &src_addr, .msg_namelen = sizeof(src_addr),
-				 .msg_iov = &iovec, .msg_iovlen = 1,
-				 .msg_control = control_buf, .msg_controllen = sizeof(control_buf) };
-	struct cmsghdr *cmsg;
-	bool expected_cmsg;
+	struct msghdr *msghdr;
+	char *buffer;
+	ssize_t len = 0;
+	int num_msgs, i;
 	unsigned eintr_count;
 	unsigned long rx_vrid_map[BIT_WORD(256 + BIT_PER_LONG - 1)] = { 0 };
 	bool terminate_receiving = false;
 #ifdef DEBUG_RECVMSG
 	unsigned recv_data_count = 0;
 #endif
-	const struct iphdr *iph;
-	unicast_peer_t *unicast_peer;
 
 	/* Strategy here is to handle incoming adverts pending into socket recvq
 	 * but stop if receive 2nd advert for a VRID on socket (this applies to
 	 * both configured and unconfigured VRIDs).
-	 * Seems a good tradeoff while simulating */
+	 * Seems a good tradeoff while simulating.
+	 * The adverts are read VRRP_RX_BATCH at a time, and all the adverts
+	 * of a batch are handled, since they have been taken off the socket. */
 	while (!terminate_receiving) {
-		/* read & affect received buffer */
+		/* vrrp_buffer can be reallocated if an interface's MTU increases */
+		for (i = 0; i < VRRP_RX_BATCH; i++) {
+			iovecs[i].iov_base = (char *)vrrp_buffer + i * vrrp_buffer_len;
+			iovecs[i].iov_len = vrrp_buffer_len;
+			src_addrs[i].ss_family = AF_UNSPEC;
+			msgs[i].msg_hdr = (struct msghdr){ .msg_name = &src_addrs[i], .msg_namelen = sizeof(src_addrs[i]),
+							   .msg_iov = &iovecs[i], .msg_iovlen = 1,
+							   .msg_control = control_bufs[i], .msg_controllen = sizeof(control_bufs[i]) };
+		}
+
+		/* read & affect received buffers */
 		eintr_count = 0;
-		while ((len = recvmsg(sock->fd_in, &msghdr, MSG_TRUNC | MSG_CTRUNC)) == -1 &&
+		while ((num_msgs = recvmmsg(sock->fd_in, msgs, VRRP_RX_BATCH, MSG_TRUNC | MSG_CTRUNC, NULL)) == -1 &&
 		       check_EINTR(errno) && eintr_count++ < 10);
-		if (len < 0) {
+		if (num_msgs < 0) {
 #ifdef DEBUG_RECVMSG
 #ifdef _RECVMSG_DEBUG_
 			if (do_recvmsg_debug && (!recv_data_count || !check_EAGAIN(errno)))
-				log_message(LOG_INFO, "recvmsg(%d) returned errno %d, %u eintr", sock->fd_in, errno, eintr_count);
+				log_message(LOG_INFO, "recvmmsg(%d) returned errno %d, %u eintr", sock->fd_in, errno, eintr_count);
 #endif
 
 #ifdef _RECVMSG_DEBUG_
@@ -978,13 +1187,13 @@ vrrp_dispatcher_read(sock_t *sock)
 #endif
 			{
 				if (check_EINTR(errno))
-					log_message(LOG_INFO, "recvmsg(%d) looped %u times due to EINTR before terminating loop"
+					log_message(LOG_INFO, "recvmmsg(%d) looped %u times due to EINTR before terminating loop"
 							    , sock->fd_in, eintr_count);
 			}
 #endif
 
 			if (!check_EAGAIN(errno))
-				log_message(LOG_INFO, "recvmsg(%d) returned %d (%m)"
+				log_message(LOG_INFO, "recvmmsg(%d) returned %d (%m)"
 						    , sock->fd_in, errno);
 #ifdef DEBUG_RECVMSG
 			else if (
@@ -992,226 +1201,79 @@ vrrp_dispatcher_read(sock_t *sock)
 				 do_recvmsg_debug &&
 #endif
 				 recv_data_count == 0)
-				log_message(LOG_INFO, "recvmsg(%d) returned EAGAIN without any data being received"
+				log_message(LOG_INFO, "recvmmsg(%d) returned EAGAIN without any data being received"
 						    , sock->fd_in);
-
-#ifdef _RECVMSG_DEBUG_
-			if (do_recvmsg_debug)
-#endif
-			{
-				if (recv_data_count != 1)
-					log_message(LOG_INFO, "recvmsg(%d) loop received %u packets"
-							    , sock->fd_in, recv_data_count);
-			}
 #endif
 			break;
 		}
 #ifdef _RECVMSG_DEBUG_
 		else if (do_recvmsg_debug)
-			log_message(LOG_INFO, "recvmsg(%d) looped %u times due to EINTR before returning %zd bytes from %s"
-					    , sock->fd_in, eintr_count, len, inet_sockaddrtos(&src_addr));
+			log_message(LOG_INFO, "recvmmsg(%d) looped %u times due to EINTR before returning %d packets"
+					    , sock->fd_in, eintr_count, num_msgs);
 #elif defined DEBUG_RECVMSG
 		if (eintr_count)
-			log_message(LOG_INFO, "recvmsg(%d) looped %u times due to EINTR before returning %ld"
-					    , sock->fd_in, eintr_count, len);
+			log_message(LOG_INFO, "recvmmsg(%d) looped %u times due to EINTR before returning %d packets"
+					    , sock->fd_in, eintr_count, num_msgs);
 #endif
 
-		/* Don't attempt to process data if no data received */
-		if (len == 0) {
-			log_message(LOG_INFO, "recvmsg(%d) returned data length 0", sock->fd_in);
-			continue;
-		}
+		for (i = 0; i < num_msgs; i++) {
+			msghdr = &msgs[i].msg_hdr;
+			buffer = iovecs[i].iov_base;
+			len = msgs[i].msg_len;
+
+			/* Don't attempt to process data if no data received */
+			if (len == 0) {
+				log_message(LOG_INFO, "recvmmsg(%d) returned data length 0", sock->fd_in);
+				continue;
+			}
 
 #ifdef _RECVMSG_DEBUG_
-		if (do_recvmsg_debug_dump) {
-			log_buffer("Received data", vrrp_buffer, len);
-		}
+			if (do_recvmsg_debug) {
+				log_message(LOG_INFO, "recvmmsg(%d) returned %zd bytes from %s"
+						    , sock->fd_in, len, inet_sockaddrtos(&src_addrs[i]));
+				if (do_recvmsg_debug_dump)
+					log_buffer("Received data", buffer, len);
+			}
 #endif
 
 #ifdef DEBUG_RECVMSG
-		recv_data_count++;
+			recv_data_count++;
 #endif
 
-		if (msghdr.msg_flags & MSG_TRUNC) {
-			log_message(LOG_INFO, "recvmsg(%d) message truncated from %zd to %zu bytes"
-					    , sock->fd_in, len, vrrp_buffer_len);
-			continue;
-		}
-
-		if (msghdr.msg_flags & MSG_CTRUNC) {
-			log_message(LOG_INFO, "recvmsg(%d), control message truncated from %zu to %" PRI_MSG_CONTROLLEN " bytes"
-					    , sock->fd_in, sizeof(control_buf), msghdr.msg_controllen);
-			msghdr.msg_controllen = 0;
-		}
-
-		if (vrrp_delayed_start_time.tv_sec)
-			continue;
-
-		/* Check the received data includes at least the IP, possibly
-		 * the AH header and the VRRP header */
-		if (!(hd = vrrp_get_header(sock->family, vrrp_buffer, len)))
-			break;
-
-		vrrp_node = rb_find(&hd->vrid, &sock->rb_vrid, vrrp_vrid_cmp);
-
-		/* No instance found => ignore the advert */
-		if (!vrrp_node) {
-			if (global_data->log_unknown_vrids)
-				log_message(LOG_INFO, "Unknown VRID(%d) received on interface(%s). ignoring..."
-						    , hd->vrid, IF_NAME(sock->ifp));
-			continue;
-		}
-		vrrp = rb_entry(vrrp_node, vrrp_t, rb_vrid);
-
-		/* Defense strategy here is to handle no more than one advert
-		 * per VRID in order to flush socket rcvq...
-		 * This is a best effort mitigation */
-		if (__test_and_set_bit_array(hd->vrid, rx_vrid_map))
-			terminate_receiving = true;
-
-		if (__test_bit(VRRP_FLAG_UNICAST_DUPLICATE_VRID, &vrrp->flags)) {
-			rb_node_t *first = vrrp_node;	/* Save for second loop */
-
-			/* First check the address we last received an advert from. This is
-			 * an optimisation since we are most likely to receive an advert from
-			 * the same address as last time, and it saves searching all the peers. */
-			for (; vrrp_node; vrrp_node = rb_next_match(&hd->vrid, vrrp_node, vrrp_vrid_cmp)) {
-				vrrp = rb_entry(vrrp_node, vrrp_t, rb_vrid);
-				if (!inet_sockaddrcmp(&src_addr, &vrrp->pkt_saddr))
-					break;
-			}
-
-			if (!vrrp_node) {
-				/* Loop through VRRP instances matching hd->vrid if unicast to match
-				 * src address of packet against configured peers */
-				for (vrrp_node = first; vrrp_node; vrrp_node = rb_next_match(&hd->vrid, vrrp_node, vrrp_vrid_cmp)) {
-					vrrp = rb_entry(vrrp_node, vrrp_t, rb_vrid);
-
-					list_for_each_entry(unicast_peer, &vrrp->unicast_peer, e_list) {
-						if (inet_sockaddrcmp(&src_addr, &unicast_peer->address) == 0)
-							break;
-						if (list_is_last(&unicast_peer->e_list, &vrrp->unicast_peer)) {
-							unicast_peer = NULL;
-							break;
-						}
-					}
-
-					/* We have found the matching peer */
-					if (unicast_peer)
-						break;
-				}
-
-				if (!vrrp_node) {
-					/* Do nothing and fail because we didn't match any good instance */
-					if (global_data->log_unknown_vrids)
-						log_message(LOG_INFO, "Unknown VRID(%d) received on interface(%s) from %s. ignoring..."
-								    , hd->vrid, IF_NAME(sock->ifp), inet_sockaddrtos(&src_addr));
-
-					continue;
-				}
+			if (msghdr->msg_flags & MSG_TRUNC) {
+				log_message(LOG_INFO, "recvmmsg(%d) message truncated from %zd to %zu bytes"
+						    , sock->fd_in, len, vrrp_buffer_len);
+				continue;
 			}
-		}
 
-		if (vrrp->state == VRRP_STATE_FAULT || vrrp->state == VRRP_STATE_INIT) {
-			/* We just ignore a message received when we are in fault state or
-			 * not yet fully initialised */
-			continue;
-		}
-
-		/* Save non packet data */
-		vrrp->pkt_saddr = src_addr;
-		vrrp->rx_ttl_hl = -1;           /* Default to not received */
-		if (sock->family == AF_INET) {
-			iph = PTR_CAST_CONST(struct iphdr, vrrp_buffer);
-			vrrp->multicast_pkt = IN_MULTICAST(htonl(iph->daddr));
-			vrrp->rx_ttl_hl = iph->ttl;
-		} else
-			vrrp->multicast_pkt = false;
-		for (cmsg = CMSG_FIRSTHDR(&msghdr); cmsg; cmsg = CMSG_NXTHDR(&msghdr, cmsg)) {
-			expected_cmsg = false;
-			if (cmsg->cmsg_level == IPPROTO_IPV6) {
-				expected_cmsg = true;
-
-				if (cmsg->cmsg_type == IPV6_HOPLIMIT &&
-				    cmsg->cmsg_len - sizeof(struct cmsghdr) == sizeof(unsigned int))
-					vrrp->rx_ttl_hl = *PTR_CAST(unsigned int, CMSG_DATA(cmsg));
-				else
-				if (cmsg->cmsg_type == IPV6_PKTINFO &&
-				    cmsg->cmsg_len - sizeof(struct cmsghdr) == sizeof(struct in6_pktinfo))
-					vrrp->multicast_pkt = IN6_IS_ADDR_MULTICAST(&(PTR_CAST(struct in6_pktinfo, CMSG_DATA(cmsg)))->ipi6_addr);
-				else
-					expected_cmsg = false;
+			if (msghdr->msg_flags & MSG_CTRUNC) {
+				log_message(LOG_INFO, "recvmmsg(%d), control message truncated from %zu to %" PRI_MSG_CONTROLLEN " bytes"
+						    , sock->fd_in, sizeof(control_bufs[i]), msghdr->msg_controllen);
+				msghdr->msg_controllen = 0;
 			}
-#ifdef _NETWORK_TIMESTAMP_
-			else if (do_network_timestamp && cmsg->cmsg_level == SOL_SOCKET) {
-				struct timespec *ts = (void *)CMSG_DATA(cmsg);
-				char time_buf[9];
 
-				expected_cmsg = true;
-				if (cmsg->cmsg_type == SO_TIMESTAMPNS) {
-					strftime(time_buf, sizeof time_buf, "%T", localtime(&ts->tv_sec));
-					log_message(LOG_INFO, "TIMESTAMPNS (socket %d - VRID %u) %s.%9.9" PRI_ts_nsec
-							    , sock->fd_in, hd->vrid, time_buf, ts->tv_nsec);
-				}
-#if 0
-				if (cmsg->cmsg_type == SO_TIMESTAMP) {
-					struct timeval *tv = (void *)CMSG_DATA(cmsg);
-					log_message(LOG_INFO, "TIMESTAMP message (%d - %u)  %" PRI_tv_sec ".%6.6" PRI_tv_usec
-							    , sock->fd_in, hd->vrid, tv->tv_sec, tv->tv_usec);
-				}
-				else if (cmsg->cmsg_type == SO_TIMESTAMPING) {
-					struct timespec *ts = (void *)CMSG_DATA(cmsg);
-					log_message(LOG_INFO, "TIMESTAMPING message (%d - %u)  %" PRI_ts_sec ".%9.9" PRI_ts_nsec ", raw %" PRI_ts_sec ".%9.9" PRI_ts_nsec
-							    , sock->fd_in, hd->vrid, ts->tv_sec, ts->tv_nsec, (ts+2)->tv_sec, (ts+2)->tv_nsec);
-				}
-#endif
-				else
-					expected_cmsg = false;
-			}
-#endif
-
-			if (!expected_cmsg)
-				log_message(LOG_INFO, "fd %d, unexpected control msg len %" PRI_MSG_CONTROLLEN ", level %d, type %d"
-						    , sock->fd_in, cmsg->cmsg_len
-						    , cmsg->cmsg_level, cmsg->cmsg_type);
-		}
+			if (vrrp_delayed_start_time.tv_sec)
+				continue;
 
-		/* For multicast, we attempt to bind the socket to ::1 to stop receiving any (non ::1)
-		 * unicast packets, but if that fails we will receive unicast packets on the multicast socket,
-		 * so just discard them here.
-		 * For unicast sockets, if any other instance on the same interface is using multicast we
-		 * will also receive the multicast packets, so also discard them here. */
-		if (sock->family == AF_INET6 && vrrp->multicast_pkt == __test_bit(VRRP_FLAG_UNICAST, &vrrp->flags)) {
-			if (__test_bit(LOG_DETAIL_BIT, &debug))
-				log_message(LOG_INFO, "(%s) discarding %sicast packet on %sicast instance", vrrp->iname,
-						vrrp->multicast_pkt ? "mult" : "un", __test_bit(VRRP_FLAG_UNICAST, &vrrp->flags) ? "un" : "mult");
-			continue;
+			if (vrrp_dispatch_packet(sock, buffer, len, msghdr, rx_vrid_map))
+				terminate_receiving = true;
 		}
 
-		prev_state = vrrp->state;
-
-		if (vrrp->state == VRRP_STATE_BACK)
-			vrrp_state_backup(vrrp, hd, vrrp_buffer, len);
-		else if (vrrp->state == VRRP_STATE_MAST) {
-			if (vrrp_state_master_rx(vrrp, hd, vrrp_buffer, len))
-				vrrp_state_leave_master(vrrp, false);
-		} else
-			log_message(LOG_INFO, "(%s) In dispatcher_read with state %d"
-					    , vrrp->iname, vrrp->state);
-
+		/* A short batch means the socket has been emptied */
+		if (num_msgs < VRRP_RX_BATCH)
+			break;
+	}
 
-		/* handle instance synchronization */
-#ifdef _TSM_DEBUG_
-		if (do_tsm_debug)
-			log_message(LOG_INFO, "Read [%s] TSM transition : [%d,%d] Wantstate = [%d]"
-					    , vrrp->iname, prev_state, vrrp->state, vrrp->wantstate);
+#ifdef DEBUG_RECVMSG
+#ifdef _RECVMSG_DEBUG_
+	if (do_recvmsg_debug)
 #endif
-		VRRP_TSM_HANDLE(prev_state, vrrp);
-
-		/* If we have sent an advert, reset the timer */
-		if (vrrp->state != VRRP_STATE_MAST || !vrrp->lower_prio_no_advert)
-			vrrp_init_instance_sands(vrrp);
+	{
+		if (recv_data_count != 1)
+			log_message(LOG_INFO, "recvmmsg(%d) loop received %u packets"
+					    , sock->fd_in, recv_data_count);
 	}
+#endif
 
 	return sock->fd_in;
 }
@@ -1235,7 +1297,7 @@ vrrp_read_dispatcher_thread(thread_ref_t thread)
 	/* register next dispatcher thread */
 	if (fd != -1)
 		sock->thread = thread_add_read_sands(thread->master, vrrp_read_dispatcher_thread,
-						     sock, fd, vrrp_compute_timer(sock), 0);
+						     sock, fd, vrrp_compute_timer(sock), THREAD_PRIORITY);
 }
 
 static void
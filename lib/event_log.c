@@ -0,0 +1,178 @@
+/*
+ * Soft:        Keepalived is a failover program for the LVS project
+ *              <www.linuxvirtualserver.org>. It monitor & manipulate
+ *              a loadbalanced server pool using multi-layer checks.
+ *
+ * Part:        Binary event log. Fixed size records of state changes are
+ *              written to a circular log in a shared mapped file, so that
+ *              the timeline of a failover can be reconstructed afterwards,
+ *              even if the process has died.
+ *
+ * Author:      Alexandre Cassen, <acassen@linux-vs.org>
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *              See the GNU General Public License for more details.
+ *
+ *              This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU General Public License
+ *              as published by the Free Software Foundation; either version
+ *              2 of the License, or (at your option) any later version.
+ *
+ * Copyright (C) 2026 Alexandre Cassen, <acassen@gmail.com>
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "event_log.h"
+#include "align.h"
+#include "logger.h"
+#include "process.h"
+#include "scheduler.h"
+
+event_log_hdr_t *event_log;
+static event_log_rec_t *event_log_recs;
+static size_t event_log_size;
+
+static uint8_t __attribute__ ((pure))
+event_process(void)
+{
+#ifndef _ONE_PROCESS_DEBUG_
+	switch (prog_type) {
+#ifdef _WITH_VRRP_
+	case PROG_TYPE_VRRP:
+		return EVENT_PROCESS_VRRP;
+#endif
+#ifdef _WITH_LVS_
+	case PROG_TYPE_CHECKER:
+		return EVENT_PROCESS_CHECKER;
+#endif
+#ifdef _WITH_BFD_
+	case PROG_TYPE_BFD:
+		return EVENT_PROCESS_BFD;
+#endif
+	default:
+		return EVENT_PROCESS_PARENT;
+	}
+#else
+	return EVENT_PROCESS_PARENT;
+#endif
+}
+
+static bool __attribute__ ((pure))
+event_log_valid(const event_log_hdr_t *hdr, unsigned num_records)
+{
+	return hdr->magic == EVENT_LOG_MAGIC &&
+	       hdr->version == EVENT_LOG_VERSION &&
+	       hdr->record_size == sizeof(event_log_rec_t) &&
+	       hdr->num_records == num_records;
+}
+
+/* If the file already holds a log of the same size, it is continued, so
+ * that the events before a restart are kept. */
+bool
+open_event_log(const char *path, unsigned num_records)
+{
+	size_t size = sizeof(event_log_hdr_t) + num_records * sizeof(event_log_rec_t);
+	struct stat st;
+	void *map;
+	int fd;
+
+	if (event_log)
+		close_event_log();
+
+	if ((fd = open(path, O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP)) == -1) {
+		log_message(LOG_INFO, "Unable to open event log %s - %m", path);
+		return false;
+	}
+
+	if (fstat(fd, &st) || !S_ISREG(st.st_mode)) {
+		log_message(LOG_INFO, "Event log %s is not a regular file", path);
+		close(fd);
+		return false;
+	}
+
+	if ((size_t)st.st_size != size &&
+	    (ftruncate(fd, 0) || ftruncate(fd, (off_t)size))) {
+		log_message(LOG_INFO, "Unable to set size of event log %s - %m", path);
+		close(fd);
+		return false;
+	}
+
+	map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		log_message(LOG_INFO, "Unable to map event log %s - %m", path);
+		return false;
+	}
+
+	event_log = map;
+	event_log_recs = PTR_CAST(event_log_rec_t, event_log + 1);
+	event_log_size = size;
+
+	if (!event_log_valid(event_log, num_records)) {
+		memset(map, 0, size);
+		event_log->version = EVENT_LOG_VERSION;
+		event_log->record_size = sizeof(event_log_rec_t);
+		event_log->num_records = num_records;
+		__atomic_store_n(&event_log->magic, EVENT_LOG_MAGIC, __ATOMIC_RELEASE);
+	}
+
+	return true;
+}
+
+void
+close_event_log(void)
+{
+	if (!event_log)
+		return;
+
+	munmap(event_log, event_log_size);
+	event_log = NULL;
+	event_log_recs = NULL;
+}
+
+void
+log_event(event_type_t type, uint32_t val1, uint32_t val2, const char *format, ...)
+{
+	event_log_rec_t *rec;
+	struct timespec ts;
+	uint64_t seq;
+	va_list args;
+
+	if (!event_log)
+		return;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+
+	seq = __atomic_fetch_add(&event_log->next_seq, 1, __ATOMIC_RELAXED);
+	rec = &event_log_recs[seq % event_log->num_records];
+
+	/* Mark the record incomplete while it is written */
+	__atomic_store_n(&rec->seq, 0, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	rec->time = (uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec;
+	rec->pid = (uint32_t)our_pid;
+	rec->type = (uint16_t)type;
+	rec->process = event_process();
+	rec->val1 = val1;
+	rec->val2 = val2;
+
+	va_start(args, format);
+	vsnprintf(rec->object, sizeof(rec->object), format, args);
+	va_end(args);
+
+	__atomic_store_n(&rec->seq, seq + 1, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,98 @@
+/*
+ * Soft:        Keepalived is a failover program for the LVS project
+ *              <www.linuxvirtualserver.org>. It monitor & manipulate
+ *              a loadbalanced server pool using multi-layer checks.
+ *
+ * Part:        event_log.c include file.
+ *
+ * Author:      Alexandre Cassen, <acassen@linux-vs.org>
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *              See the GNU General Public License for more details.
+ *
+ *              This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU General Public License
+ *              as published by the Free Software Foundation; either version
+ *              2 of the License, or (at your option) any later version.
+ *
+ * Copyright (C) 2026 Alexandre Cassen, <acassen@gmail.com>
+ */
+
+#ifndef _EVENT_LOG_H
+#define _EVENT_LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Binary event log.
+ *
+ * The file is a header followed by a circular array of fixed size
+ * records. It is mapped shared by the parent process before the
+ * children are started, so that the VRRP, checker and BFD processes all
+ * write to the same log. A writer takes the next sequence number with an
+ * atomic increment of next_seq, so no locking is needed. The record's
+ * seq is cleared while the record is being written, and set to the
+ * sequence number + 1 once it is complete.
+ *
+ * All fields are in host byte order. The layout must not be changed
+ * without changing EVENT_LOG_VERSION, and tools/event_log_decode. */
+
+#define EVENT_LOG_MAGIC		0x4b41454cU	/* "KAEL" */
+#define EVENT_LOG_VERSION	1
+#define EVENT_LOG_OBJECT_LEN	96
+
+/* The process writing a record. These values are independent of which
+ * processes keepalived was built with. */
+typedef enum {
+	EVENT_PROCESS_PARENT,
+	EVENT_PROCESS_VRRP,
+	EVENT_PROCESS_CHECKER,
+	EVENT_PROCESS_BFD,
+} event_process_t;
+
+typedef enum {
+	EVENT_NONE,
+	EVENT_PROCESS_START,	/* val1: 1 if reload */
+	EVENT_PROCESS_STOP,
+	EVENT_VRRP_STATE,	/* object: instance, val1: state, val2: effective priority */
+	EVENT_VRRP_PRIORITY,	/* object: instance, val1: effective priority, val2: state */
+	EVENT_VRRP_GROUP_STATE,	/* object: sync group, val1: state */
+	EVENT_LINK_STATE,	/* object: interface, val1: 1 if up, val2: ifindex */
+	EVENT_CHECKER_STATE,	/* object: vs rs, val1: 1 if up, val2: checker type */
+	EVENT_RS_STATE,		/* object: vs rs, val1: 1 if alive, val2: weight */
+	EVENT_VS_QUORUM,	/* object: vs, val1: 1 if quorum up, val2: live weight */
+	EVENT_BFD_STATE,	/* object: session, val1: state, val2: diagnostic */
+} event_type_t;
+
+typedef struct _event_log_hdr {
+	uint32_t		magic;
+	uint16_t		version;
+	uint16_t		record_size;
+	uint32_t		num_records;
+	uint32_t		pad;
+	uint64_t		next_seq;	/* updated atomically */
+	uint8_t			reserved[40];
+} event_log_hdr_t;
+
+typedef struct _event_log_rec {
+	uint64_t		seq;		/* sequence number + 1, 0 if incomplete */
+	uint64_t		time;		/* CLOCK_REALTIME, nanoseconds */
+	uint32_t		pid;
+	uint16_t		type;		/* event_type_t */
+	uint8_t			process;	/* event_process_t */
+	uint8_t			pad;
+	uint32_t		val1;
+	uint32_t		val2;
+	char			object[EVENT_LOG_OBJECT_LEN];
+} event_log_rec_t;
+
+extern event_log_hdr_t *event_log;
+
+extern bool open_event_log(const char *, unsigned);
+extern void close_event_log(void);
+extern void log_event(event_type_t, uint32_t, uint32_t, const char *, ...)
+	__attribute__ ((format (printf, 4, 5)));
+
+#endif
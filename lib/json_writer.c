@@ -15,6 +15,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdarg.h>
+#include <string.h>
 #include <malloc.h>
 #include <inttypes.h>
 #include <stdint.h>
@@ -23,28 +24,129 @@
 #include "json_writer.h"
 #include "assert_debug.h"
 
+/* Output is built in buf. A writer created with jsonw_new() writes the
+ * buffer to its FILE when it is full, so the buffer stays small; a
+ * writer created with jsonw_new_buffer() keeps growing it, and the
+ * result is taken with jsonw_detach(). */
+#define JSONW_FILE_BUF_SIZE	16384
+#define JSONW_MIN_BUF_SIZE	1024
+
 struct json_writer {
-	FILE		*out;	/* output file */
+	FILE		*out;	/* output file, or NULL for a buffer */
+	char		*buf;	/* pending output */
+	size_t		len;
+	size_t		size;
 	unsigned	depth;  /* nesting */
 	bool		pretty; /* optional whitepace */
 	char		sep;	/* either nul or comma */
 };
 
+/* The character to follow a '\' for characters that must be escaped,
+ * 'u' for those written as \u00XX, and 0 if no escape is needed. */
+static const char jsonw_escape[256] = {
+	[0x00] = 'u', [0x01] = 'u', [0x02] = 'u', [0x03] = 'u',
+	[0x04] = 'u', [0x05] = 'u', [0x06] = 'u', [0x07] = 'u',
+	['\b'] = 'b', ['\t'] = 't', ['\n'] = 'n', [0x0b] = 'u',
+	['\f'] = 'f', ['\r'] = 'r', [0x0e] = 'u', [0x0f] = 'u',
+	[0x10] = 'u', [0x11] = 'u', [0x12] = 'u', [0x13] = 'u',
+	[0x14] = 'u', [0x15] = 'u', [0x16] = 'u', [0x17] = 'u',
+	[0x18] = 'u', [0x19] = 'u', [0x1a] = 'u', [0x1b] = 'u',
+	[0x1c] = 'u', [0x1d] = 'u', [0x1e] = 'u', [0x1f] = 'u',
+	['"'] = '"', ['\\'] = '\\', ['/'] = '/',
+};
+
+static void
+jsonw_flush(json_writer_t *self)
+{
+	if (self->out && self->len) {
+		fwrite(self->buf, 1, self->len, self->out);
+		self->len = 0;
+	}
+}
+
+/* Ensure there is space for n more characters */
+static inline void
+jsonw_reserve(json_writer_t *self, size_t n)
+{
+	size_t size;
+
+	if (self->len + n <= self->size)
+		return;
+
+	jsonw_flush(self);
+	if (self->len + n <= self->size)
+		return;
+
+	for (size = self->size * 2; size < self->len + n; size *= 2);
+	self->buf = REALLOC(self->buf, size);
+	self->size = size;
+}
+
+static inline void
+jsonw_putc(json_writer_t *self, char c)
+{
+	jsonw_reserve(self, 1);
+	self->buf[self->len++] = c;
+}
+
+static inline void
+jsonw_putn(json_writer_t *self, const char *str, size_t n)
+{
+	jsonw_reserve(self, n);
+	memcpy(self->buf + self->len, str, n);
+	self->len += n;
+}
+
+static void __attribute__ ((format (printf, 2, 0)))
+jsonw_vprintf(json_writer_t *self, const char *fmt, va_list ap)
+{
+	va_list ap1;
+	int n;
+
+	va_copy(ap1, ap);
+	n = vsnprintf(self->buf + self->len, self->size - self->len, fmt, ap1);
+	va_end(ap1);
+
+	if (n < 0)
+		return;
+
+	if ((size_t)n >= self->size - self->len) {
+		jsonw_reserve(self, (size_t)n + 1);
+		vsnprintf(self->buf + self->len, self->size - self->len, fmt, ap);
+	}
+
+	self->len += (size_t)n;
+}
+
+static void
+jsonw_put_uint(json_writer_t *self, uint64_t num)
+{
+	char tmp[20];
+	char *p = tmp + sizeof(tmp);
+
+	do {
+		*--p = (char)('0' + num % 10);
+		num /= 10;
+	} while (num);
+
+	jsonw_putn(self, p, (size_t)(tmp + sizeof(tmp) - p));
+}
+
 /* indentation for pretty print */
-static void jsonw_indent(const json_writer_t *self)
+static void jsonw_indent(json_writer_t *self)
 {
-	unsigned i;
-	for (i = 0; i < self->depth; ++i)
-		fputs("    ", self->out);
+	jsonw_reserve(self, self->depth * 4);
+	memset(self->buf + self->len, ' ', self->depth * 4);
+	self->len += self->depth * 4;
 }
 
 /* end current line and indent if pretty printing */
-static void jsonw_eol(const json_writer_t *self)
+static void jsonw_eol(json_writer_t *self)
 {
 	if (!self->pretty)
 		return;
 
-	putc('\n', self->out);
+	jsonw_putc(self, '\n');
 	jsonw_indent(self);
 }
 
@@ -52,58 +154,53 @@ static void jsonw_eol(const json_writer_t *self)
 static void jsonw_eor(json_writer_t *self)
 {
 	if (self->sep != '\0')
-		putc(self->sep, self->out);
+		jsonw_putc(self, self->sep);
 	self->sep = ',';
 }
 
 
 /* Output JSON encoded string */
 /* Handles C escapes, does not do Unicode */
-static void jsonw_puts(const json_writer_t *self, const char *str)
+static void jsonw_puts(json_writer_t *self, const char *str)
 {
-	putc('"', self->out);
+	static const char hex[] = "0123456789abcdef";
+	const char *run;
+	char esc;
+
+	jsonw_putc(self, '"');
 	/* tolerate NULL so a failed cmd_str() does not crash the dump */
-	for (; str && *str; ++str)
-		switch (*str) {
-		case '\t':
-			fputs("\\t", self->out);
-			break;
-		case '\n':
-			fputs("\\n", self->out);
-			break;
-		case '\r':
-			fputs("\\r", self->out);
-			break;
-		case '\f':
-			fputs("\\f", self->out);
-			break;
-		case '\b':
-			fputs("\\b", self->out);
+	while (str && *str) {
+		/* Copy the longest run that needs no escaping in one go */
+		for (run = str; *str && !jsonw_escape[(unsigned char)*str]; str++);
+		if (str != run)
+			jsonw_putn(self, run, (size_t)(str - run));
+		if (!*str)
 			break;
-		case '\\':
-			fputs("\\\\", self->out);
-			break;
-		case '"':
-			fputs("\\\"", self->out);
-			break;
-		case '/':
-			fputs("\\/", self->out);
-			break;
-		default:
-			if ((unsigned char)*str < 0x20)
-				fprintf(self->out, "\\u%04x", (unsigned char)*str);
-			else
-				putc(*str, self->out);
+
+		esc = jsonw_escape[(unsigned char)*str];
+		jsonw_reserve(self, 6);
+		self->buf[self->len++] = '\\';
+		self->buf[self->len++] = esc;
+		if (esc == 'u') {
+			self->buf[self->len++] = '0';
+			self->buf[self->len++] = '0';
+			self->buf[self->len++] = hex[(unsigned char)*str >> 4];
+			self->buf[self->len++] = hex[*str & 0xf];
 		}
-	putc('"', self->out);
+		str++;
+	}
+	jsonw_putc(self, '"');
 }
 
-/* Create a new JSON stream */
-json_writer_t *jsonw_new(FILE *f)
+static json_writer_t *
+jsonw_alloc(FILE *f, size_t size)
 {
 	json_writer_t *self = MALLOC(sizeof(*self));
 	if (self) {
 		self->out = f;
+		self->size = size < JSONW_MIN_BUF_SIZE ? JSONW_MIN_BUF_SIZE : size;
+		self->buf = MALLOC(self->size);
+		self->len = 0;
 		self->depth = 0;
 		self->pretty = false;
 		self->sep = '\0';
@@ -111,40 +208,74 @@ json_writer_t *jsonw_new(FILE *f)
 	return self;
 }
 
+/* Create a new JSON stream */
+json_writer_t *jsonw_new(FILE *f)
+{
+	return jsonw_alloc(f, JSONW_FILE_BUF_SIZE);
+}
+
+/* Create a new JSON stream written to memory. size is the expected
+ * length of the output. */
+json_writer_t *jsonw_new_buffer(size_t size)
+{
+	return jsonw_alloc(NULL, size);
+}
+
 /* End output to JSON stream */
 void jsonw_destroy(json_writer_t ** const self_p)
 {
 	json_writer_t *self = *self_p;
 
 	assert(self->depth == 0);
-	fputs("\n", self->out);
-	fflush(self->out);
+	jsonw_putc(self, '\n');
+	jsonw_flush(self);
+	if (self->out)
+		fflush(self->out);
+	FREE(self->buf);
 	FREE(self);
 	*self_p = NULL;
 }
 
+/* End output to a buffer JSON stream, and return the output, which
+ * the caller must FREE. */
+char *jsonw_detach(json_writer_t ** const self_p, size_t *len)
+{
+	json_writer_t *self = *self_p;
+	char *buf;
+
+	assert(self->depth == 0);
+	assert(!self->out);
+	jsonw_putc(self, '\n');
+	buf = self->buf;
+	*len = self->len;
+	FREE(self);
+	*self_p = NULL;
+
+	return buf;
+}
+
 void jsonw_pretty(json_writer_t *self, bool on)
 {
 	self->pretty = on;
 }
 
 /* Basic blocks */
-static void jsonw_begin(json_writer_t *self, int c)
+static void jsonw_begin(json_writer_t *self, char c)
 {
 	jsonw_eor(self);
-	putc(c, self->out);
+	jsonw_putc(self, c);
 	++self->depth;
 	self->sep = '\0';
 }
 
-static void jsonw_end(json_writer_t *self, int c)
+static void jsonw_end(json_writer_t *self, char c)
 {
 	assert(self->depth > 0);
 
 	--self->depth;
 	if (self->sep != '\0')
 		jsonw_eol(self);
-	putc(c, self->out);
+	jsonw_putc(self, c);
 	self->sep = ',';
 }
 
@@ -156,17 +287,18 @@ void jsonw_name(json_writer_t *self, const char *name)
 	jsonw_eol(self);
 	self->sep = '\0';
 	jsonw_puts(self, name);
-	putc(':', self->out);
 	if (self->pretty)
-		putc(' ', self->out);
+		jsonw_putn(self, ": ", 2);
+	else
+		jsonw_putc(self, ':');
 }
 
 void jsonw_vprintf_enquote(json_writer_t *self, const char *fmt, va_list ap)
 {
 	jsonw_eor(self);
-	putc('"', self->out);
-	vfprintf(self->out, fmt, ap);
-	putc('"', self->out);
+	jsonw_putc(self, '"');
+	jsonw_vprintf(self, fmt, ap);
+	jsonw_putc(self, '"');
 }
 
 void jsonw_printf(json_writer_t *self, const char *fmt, ...)
@@ -175,7 +307,7 @@ void jsonw_printf(json_writer_t *self, const char *fmt, ...)
 
 	va_start(ap, fmt);
 	jsonw_eor(self);
-	vfprintf(self->out, fmt, ap);
+	jsonw_vprintf(self, fmt, ap);
 	va_end(ap);
 }
 
@@ -209,12 +341,17 @@ void jsonw_string(json_writer_t *self, const char *value)
 
 void jsonw_bool(json_writer_t *self, bool val)
 {
-	jsonw_printf(self, "%s", val ? "true" : "false");
+	jsonw_eor(self);
+	if (val)
+		jsonw_putn(self, "true", 4);
+	else
+		jsonw_putn(self, "false", 5);
 }
 
 void jsonw_null(json_writer_t *self)
 {
-	jsonw_printf(self, "null");
+	jsonw_eor(self);
+	jsonw_putn(self, "null", 4);
 }
 
 void jsonw_float_fmt(json_writer_t *self, const char *fmt, double num)
@@ -229,22 +366,30 @@ void jsonw_float(json_writer_t *self, double num)
 
 void jsonw_hu(json_writer_t *self, unsigned short num)
 {
-	jsonw_printf(self, "%hu", num);
+	jsonw_eor(self);
+	jsonw_put_uint(self, num);
 }
 
 void jsonw_uint(json_writer_t *self, uint64_t num)
 {
-	jsonw_printf(self, "%"PRIu64, num);
+	jsonw_eor(self);
+	jsonw_put_uint(self, num);
 }
 
 void jsonw_lluint(json_writer_t *self, unsigned long long int num)
 {
-	jsonw_printf(self, "%llu", num);
+	jsonw_eor(self);
+	jsonw_put_uint(self, num);
 }
 
 void jsonw_int(json_writer_t *self, int64_t num)
 {
-	jsonw_printf(self, "%"PRId64, num);
+	jsonw_eor(self);
+	if (num < 0) {
+		jsonw_putc(self, '-');
+		jsonw_put_uint(self, -(uint64_t)num);
+	} else
+		jsonw_put_uint(self, (uint64_t)num);
 }
 
 /* Basic name/value objects */
@@ -18,6 +18,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdarg.h>
+#include <stdio.h>
 
 /* Opaque class structure */
 typedef struct json_writer json_writer_t;
@@ -25,9 +26,15 @@ typedef struct json_writer json_writer_t;
 /* Create a new JSON stream */
 json_writer_t *jsonw_new(FILE *f);
 
+/* Create a new JSON stream written to memory */
+json_writer_t *jsonw_new_buffer(size_t size);
+
 /* End output to JSON stream */
 void jsonw_destroy(json_writer_t ** const self_p);
 
+/* End output to memory JSON stream and take the buffer */
+char *jsonw_detach(json_writer_t ** const self_p, size_t *len);
+
 /* Cause output to have pretty whitespace */
 void jsonw_pretty(json_writer_t *self, bool on);
 
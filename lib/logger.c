@@ -23,6 +23,7 @@
 #include "config.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include <time.h>
 #include <unistd.h>
@@ -34,6 +35,14 @@
 #include "logger.h"
 #include "bitops.h"
 #include "utils.h"
+#include "memory.h"
+
+/* A message queued to be written when the process is next idle */
+typedef struct _log_queue_entry {
+	struct timespec	ts;
+	int		facility;
+	char		msg[2 * MAX_LOG_MSG + 1];
+} log_queue_entry_t;
 
 /* Boolean flag - send messages to console as well as syslog */
 static bool log_console = false;
@@ -47,6 +56,25 @@ static FILE *log_file;
 bool always_flush_log_file;
 #endif
 
+/* Messages logged by the thread that opened the queue are queued, and
+ * written by flush_log_queue(), which the scheduler calls before waiting.
+ * Other threads write their messages directly. If the queue is full,
+ * messages are dropped and counted. */
+static log_queue_entry_t *log_queue;
+static unsigned log_queue_mask;
+static unsigned log_queue_head;		/* next entry to write */
+static unsigned log_queue_tail;		/* next free entry */
+static unsigned log_queue_dropped;
+static __thread bool log_queue_owner;
+
+/* The timestamps are only reformatted when the second changes */
+static __thread time_t timestamp_sec = -1;
+static __thread char console_timestamp[64];
+#ifdef ENABLE_LOG_TO_FILE
+static __thread char file_timestamp[32];
+static __thread char file_timestamp_year[8];
+#endif
+
 void
 enable_console_log(void)
 {
@@ -117,6 +145,153 @@ update_log_file_perms(mode_t umask_bits)
 }
 #endif
 
+static void
+update_timestamps(time_t t)
+{
+	struct tm tm;
+
+	if (t == timestamp_sec)
+		return;
+
+	localtime_r(&t, &tm);
+	strftime(console_timestamp, sizeof(console_timestamp), "%c", &tm);
+#ifdef ENABLE_LOG_TO_FILE
+	strftime(file_timestamp, sizeof(file_timestamp), "%a %b %d %T", &tm);
+	strftime(file_timestamp_year, sizeof(file_timestamp_year), " %Y", &tm);
+#endif
+	timestamp_sec = t;
+}
+
+/* Write a message to the console and log file, if they are in use */
+static void
+write_local_log(const struct timespec *ts, const char *buf, bool flush)
+{
+	update_timestamps(ts->tv_sec);
+
+	if (log_console && __test_bit(DONT_FORK_BIT, &debug))
+		fprintf(stderr, "%s: %s\n", console_timestamp, buf);
+
+#ifdef ENABLE_LOG_TO_FILE
+	if (log_file) {
+		fprintf(log_file, "%s.%9.9" PRI_ts_nsec "%s: %s\n", file_timestamp, ts->tv_nsec, file_timestamp_year, buf);
+		if (flush && always_flush_log_file)
+			fflush(log_file);
+	}
+#else
+	(void)flush;
+#endif
+}
+
+static inline bool
+local_log_active(void)
+{
+	return
+#ifdef ENABLE_LOG_TO_FILE
+	       log_file ||
+#endif
+	       (__test_bit(DONT_FORK_BIT, &debug) && log_console);
+}
+
+void
+open_log_queue(unsigned entries)
+{
+	static bool flush_at_exit;
+	unsigned size = 16;
+
+	while (size < entries)
+		size <<= 1;
+
+	if (log_queue) {
+		if (entries && log_queue_owner && size == log_queue_mask + 1)
+			return;
+		close_log_queue();
+	}
+
+	if (!entries)
+		return;
+
+	log_queue = MALLOC(size * sizeof(*log_queue));
+	log_queue_mask = size - 1;
+	log_queue_head = log_queue_tail = 0;
+	log_queue_dropped = 0;
+	log_queue_owner = true;
+
+	/* Paths that log and then call exit() don't close the queue */
+	if (!flush_at_exit) {
+		atexit(flush_log_queue);
+		flush_at_exit = true;
+	}
+}
+
+void
+flush_log_queue(void)
+{
+	log_queue_entry_t *entry;
+	log_queue_entry_t dropped;
+	bool local_log;
+
+	if (!log_queue_owner || (log_queue_head == log_queue_tail && !log_queue_dropped))
+		return;
+
+	local_log = local_log_active();
+
+	for (; log_queue_head != log_queue_tail; log_queue_head++) {
+		entry = &log_queue[log_queue_head & log_queue_mask];
+
+		if (local_log)
+			write_local_log(&entry->ts, entry->msg, false);
+		if (!__test_bit(NO_SYSLOG_BIT, &debug))
+			syslog(entry->facility, "%s", entry->msg);
+	}
+
+	if (log_queue_dropped) {
+		clock_gettime(CLOCK_REALTIME, &dropped.ts);
+		snprintf(dropped.msg, sizeof(dropped.msg), "Log queue full - %u message%s dropped", log_queue_dropped, log_queue_dropped == 1 ? "" : "s");
+		log_queue_dropped = 0;
+
+		if (local_log)
+			write_local_log(&dropped.ts, dropped.msg, false);
+		if (!__test_bit(NO_SYSLOG_BIT, &debug))
+			syslog(LOG_INFO, "%s", dropped.msg);
+	}
+
+#ifdef ENABLE_LOG_TO_FILE
+	if (log_file && always_flush_log_file)
+		fflush(log_file);
+#endif
+}
+
+void
+close_log_queue(void)
+{
+	if (!log_queue)
+		return;
+
+	flush_log_queue();
+
+	FREE(log_queue);
+	log_queue = NULL;
+	log_queue_owner = false;
+}
+
+static void __attribute__ ((format (printf, 2, 0)))
+queue_log_message(const int facility, const char* format, va_list args)
+{
+	log_queue_entry_t *entry;
+
+	if (log_queue_tail - log_queue_head > log_queue_mask) {
+		log_queue_dropped++;
+		return;
+	}
+
+	entry = &log_queue[log_queue_tail & log_queue_mask];
+	clock_gettime(CLOCK_REALTIME, &entry->ts);
+	entry->facility = facility;
+	vsnprintf(entry->msg, sizeof(entry->msg), format, args);
+
+	log_queue_tail++;
+}
+
 void
 vlog_message(const int facility, const char* format, va_list args)
 {
@@ -128,15 +303,21 @@ vlog_message(const int facility, const char* format, va_list args)
 	if (__test_bit(CONFIG_TEST_BIT, &debug))
 		return;
 
+	/* Errors are written straight away, after any queued messages, in
+	 * case the process is about to exit or crash */
+	if (log_queue_owner) {
+		if (LOG_PRI(facility) > LOG_ERR) {
+			queue_log_message(facility, format, args);
+			return;
+		}
+		flush_log_queue();
+	}
+
 #if !HAVE_VSYSLOG
 	vsnprintf(buf, sizeof(buf), format, args);
 #endif
 
-	if (
-#ifdef ENABLE_LOG_TO_FILE
-	    log_file ||
-#endif
-			(__test_bit(DONT_FORK_BIT, &debug) && log_console)) {
+	if (local_log_active()) {
 #if HAVE_VSYSLOG
 		va_list args1;
 		char buf[2 * MAX_LOG_MSG + 1];
@@ -145,39 +326,10 @@ vlog_message(const int facility, const char* format, va_list args)
 		vsnprintf(buf, sizeof(buf), format, args1);
 		va_end(args1);
 #endif
-
-		/* timestamp setup */
-#ifdef ENABLE_LOG_TO_FILE
 		struct timespec ts;
-		time_t t;
-		char *p;
 
 		clock_gettime(CLOCK_REALTIME, &ts);
-		t = ts.tv_sec;
-#else
-		time_t t = time(NULL);
-#endif
-		struct tm tm;
-		char timestamp[64];
-
-		localtime_r(&t, &tm);
-
-		if (log_console && __test_bit(DONT_FORK_BIT, &debug)) {
-
-			strftime(timestamp, sizeof(timestamp), "%c", &tm);
-			fprintf(stderr, "%s: %s\n", timestamp, buf);
-		}
-#ifdef ENABLE_LOG_TO_FILE
-		if (log_file) {
-			p = timestamp;
-			p += strftime(timestamp, sizeof(timestamp), "%a %b %d %T", &tm);
-			p += snprintf(p, timestamp + sizeof(timestamp) - p, ".%9.9" PRI_ts_nsec, ts.tv_nsec);
-			strftime(p, timestamp + sizeof(timestamp) - p, " %Y", &tm);
-			fprintf(log_file, "%s: %s\n", timestamp, buf);
-			if (always_flush_log_file)
-				fflush(log_file);
-		}
-#endif
+		write_local_log(&ts, buf, true);
 	}
 
 	if (!__test_bit(NO_SYSLOG_BIT, &debug)) {
@@ -49,6 +49,9 @@ extern void open_log_file(const char *, const char *, const char *, const char *
 extern void flush_log_file(void);
 extern void update_log_file_perms(mode_t);
 #endif
+extern void open_log_queue(unsigned);
+extern void flush_log_queue(void);
+extern void close_log_queue(void);
 extern void vlog_message(const int facility, const char* format, va_list args)
 	__attribute__ ((format (printf, 2, 0)));
 extern void log_message(int priority, const char* format, ...)
@@ -0,0 +1,105 @@
+/*
+ * Soft:        Keepalived is a failover program for the LVS project
+ *              <www.linuxvirtualserver.org>. It monitor & manipulate
+ *              a loadbalanced server pool using multi-layer checks.
+ *
+ * Part:        OpenMetrics text exposition. The metrics are appended to
+ *              a query socket's output buffer as they are read, with no
+ *              intermediate copies.
+ *
+ * Author:      Alexandre Cassen, <acassen@linux-vs.org>
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *              See the GNU General Public License for more details.
+ *
+ *              This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU General Public License
+ *              as published by the Free Software Foundation; either version
+ *              2 of the License, or (at your option) any later version.
+ *
+ * Copyright (C) 2026 Alexandre Cassen, <acassen@gmail.com>
+ */
+
+#include "config.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "metrics.h"
+
+/* The samples of a family must follow its TYPE line. The name of a
+ * counter's family does not include the _total suffix of its samples. */
+void
+metrics_family(query_buf_t *b, const char *name, const char *type, const char *help)
+{
+	query_printf(b, "# TYPE %s %s\n# HELP %s %s\n", name, type, name, help);
+}
+
+static void
+metrics_label_value(query_buf_t *b, const char *val)
+{
+	size_t len;
+
+	for (;;) {
+		len = strcspn(val, "\\\"\n");
+		query_write(b, val, len);
+		val += len;
+
+		if (!*val)
+			return;
+
+		query_write(b, *val == '\n' ? "\\n" : *val == '"' ? "\\\"" : "\\\\", 2);
+		val++;
+	}
+}
+
+/* labels is NULL, or a NULL terminated array of name, value pairs */
+void
+metrics_sample(query_buf_t *b, const char *name, const char * const *labels)
+{
+	const char *sep = "{";
+
+	query_write(b, name, strlen(name));
+
+	if (labels && *labels) {
+		for (; *labels; labels += 2) {
+			query_printf(b, "%s%s=\"", sep, labels[0]);
+			metrics_label_value(b, labels[1]);
+			query_write(b, "\"", 1);
+			sep = ",";
+		}
+		query_write(b, "}", 1);
+	}
+
+	query_write(b, " ", 1);
+}
+
+void
+metrics_uint(query_buf_t *b, const char *name, const char * const *labels, uint64_t val)
+{
+	metrics_sample(b, name, labels);
+	query_printf(b, "%" PRIu64 "\n", val);
+}
+
+void
+metrics_int(query_buf_t *b, const char *name, const char * const *labels, int64_t val)
+{
+	metrics_sample(b, name, labels);
+	query_printf(b, "%" PRId64 "\n", val);
+}
+
+/* Times are kept in usecs, but exposed in seconds */
+void
+metrics_usecs(query_buf_t *b, const char *name, const char * const *labels, uint64_t usecs)
+{
+	metrics_sample(b, name, labels);
+	query_printf(b, "%" PRIu64 ".%06" PRIu64 "\n", usecs / 1000000, usecs % 1000000);
+}
+
+void
+metrics_eof(query_buf_t *b)
+{
+	query_write(b, "# EOF\n", 6);
+}
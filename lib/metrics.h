@@ -0,0 +1,46 @@
+/*
+ * Soft:        Keepalived is a failover program for the LVS project
+ *              <www.linuxvirtualserver.org>. It monitor & manipulate
+ *              a loadbalanced server pool using multi-layer checks.
+ *
+ * Part:        metrics.c include file.
+ *
+ * Author:      Alexandre Cassen, <acassen@linux-vs.org>
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *              See the GNU General Public License for more details.
+ *
+ *              This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU General Public License
+ *              as published by the Free Software Foundation; either version
+ *              2 of the License, or (at your option) any later version.
+ *
+ * Copyright (C) 2026 Alexandre Cassen, <acassen@gmail.com>
+ */
+
+#ifndef _METRICS_H
+#define _METRICS_H
+
+#include <stdint.h>
+
+#include "query_socket.h"
+
+/* Metric family types */
+#define METRICS_COUNTER		"counter"
+#define METRICS_GAUGE		"gauge"
+#define METRICS_HISTOGRAM	"histogram"
+#define METRICS_SUMMARY		"summary"
+#define METRICS_INFO		"info"
+#define METRICS_STATESET	"stateset"
+
+/* Prototypes */
+extern void metrics_family(query_buf_t *, const char *, const char *, const char *);
+extern void metrics_sample(query_buf_t *, const char *, const char * const *);
+extern void metrics_uint(query_buf_t *, const char *, const char * const *, uint64_t);
+extern void metrics_int(query_buf_t *, const char *, const char * const *, int64_t);
+extern void metrics_usecs(query_buf_t *, const char *, const char * const *, uint64_t);
+extern void metrics_eof(query_buf_t *);
+
+#endif
@@ -43,9 +43,7 @@
 #include <inttypes.h>
 #include <signal.h>
 #include <dirent.h>
-#ifdef HAVE_MEMFD_CREATE
 #include <sys/mman.h>
-#endif
 #ifdef USE_MEMFD_CREATE_SYSCALL
 #include <sys/syscall.h>
 #include <linux/memfd.h>
@@ -92,10 +90,34 @@
  * correct file name and line number.
  * The reason for 4 is so that include file processing errors can be written to the
  * log files of all processes.
+ *
+ * The first process also writes a binary snapshot of the lines returned by
+ * read_line(), i.e. after @ conditionals, $ definitions and ~SEQ/~LST have been
+ * expanded, together with the include file open/close events and errors. The
+ * other processes map the snapshot and take the lines from it rather than
+ * expanding the configuration again, which also means that all processes see
+ * identical expansions (e.g. of $_RANDOM). The snapshot is only used if it is
+ * complete, otherwise the processes read the temporary file as before.
+ *
+ * While the first process reads the configuration files, it also records each
+ * include glob, with the directory it was expanded in and a hash of the names
+ * and contents of the files it matched. The records are written at the end of
+ * the copy, so that the parent has them when the config test process has read
+ * the files. config_files_unchanged() repeats the globs and hashes the files,
+ * and a reload can be skipped if nothing has changed.
  */
 
 #define DEF_LINE_END	"\n"
 
+#define CONF_SNAPSHOT_MAGIC	0x4b41434eU	/* "NCAK" */
+#define CONF_SNAPSHOT_VERSION	1
+
+/* The text of each record is nul terminated and padded to a multiple of 4 bytes */
+#define SNAPSHOT_TEXT_SIZE(len)	(((len) + 1 + 3) & ~(size_t)3)
+
+#define CONF_HASH_OFFSET	0xcbf29ce484222325ULL
+#define CONF_HASH_PRIME		0x100000001b3ULL
+
 #define BOB "{"
 #define EOB "}"
 #define WHITE_SPACE_STR " \t\f\n\r\v"
@@ -115,6 +137,26 @@ typedef enum _include {
 } include_t;
 
 
+typedef enum _snapshot_rec_type {
+	SNAPSHOT_LINE,		/* A line returned by read_line() */
+	SNAPSHOT_OPEN,		/* An include file opened, text is the file name */
+	SNAPSHOT_CLOSE,		/* An include file closed */
+	SNAPSHOT_ERROR,		/* An include file processing error */
+	SNAPSHOT_END,		/* All the configuration has been read */
+} snapshot_rec_type_t;
+
+typedef struct _conf_snapshot_hdr {
+	uint32_t	magic;
+	uint32_t	version;
+} conf_snapshot_hdr_t;
+
+typedef struct _conf_snapshot_rec {
+	uint16_t	type;
+	uint16_t	len;		/* Length of text, excluding the nul */
+	uint32_t	line_no;
+	char		text[];
+} conf_snapshot_rec_t;
+
 typedef struct _defs {
 	const char *name;
 	size_t name_len;
@@ -172,6 +214,16 @@ typedef struct _seq {
 	list_head_t e_list;
 } seq_t;
 
+/* An include glob, and a hash of the names and contents of the files it matched */
+typedef struct _conf_source {
+	const char	*dir;		/* The directory the glob was expanded in */
+	const char	*pattern;
+	uint64_t	hash;
+
+	/* Linked list member */
+	list_head_t	e_list;
+} conf_source_t;
+
 /* Structure for include file stack */
 typedef struct _include_file {
 	glob_t		globbuf;
@@ -184,6 +236,8 @@ typedef struct _include_file {
 	size_t		current_line_no;
 	include_t	include_type;
 	unsigned	sav_include_check;
+	conf_source_t	*source;	/* Set if the files read are being recorded */
+	uint64_t	content_hash;	/* Of the current file so far */
 
 	list_head_t	e_list;
 } include_file_t;
@@ -214,8 +268,16 @@ bool have_wildcards;
 #endif
 static bool config_file_error;
 
+/* Index of the keywords of one level. The slots are hashed by keyword
+ * string with linear probing, and are at most half full. */
+struct _keyword_hash {
+	unsigned mask;
+	keyword_t *slot[];
+};
+
 /* local vars */
 static vector_t *current_keywords;
+static keyword_hash_t *keywords_hash;
 static int sublevel = 0;
 static int skip_sublevel = 0;
 static vpp_t cur_check_ptr;
@@ -236,6 +298,18 @@ static FILE *conf_copy;
 static bool write_conf_copy;
 static bool read_conf_copy;
 
+static FILE *conf_snapshot;
+static bool write_conf_snapshot;
+static bool conf_snapshot_complete;
+static const char *snapshot_map;
+static size_t snapshot_size;
+static const char *snapshot_pos;
+static const char *snapshot_end;
+
+static LIST_HEAD_INITIALIZE(conf_sources); /* conf_source_t */
+static bool record_conf_sources;
+static bool conf_sources_complete;
+
 /* Parameter definitions */
 static LIST_HEAD_INITIALIZE(defs); /* def_t */
 
@@ -296,6 +370,23 @@ report_config_error(config_err_t err, const char *format, ...)
 	va_end(args);
 }
 
+static void
+write_snapshot_rec(snapshot_rec_type_t type, size_t line_no, const char *text)
+{
+	static const char pad[4];
+	conf_snapshot_rec_t rec = { .type = type, .line_no = (uint32_t)line_no };
+	size_t len = text ? strlen(text) : 0;
+
+	if (len > UINT16_MAX)
+		len = UINT16_MAX;
+	rec.len = (uint16_t)len;
+
+	fwrite(&rec, sizeof(rec), 1, conf_snapshot);
+	if (len)
+		fwrite(text, len, 1, conf_snapshot);
+	fwrite(pad, SNAPSHOT_TEXT_SIZE(len) - len, 1, conf_snapshot);
+}
+
 static void __attribute__ ((format (printf, 2, 3)))
 file_config_error(include_t error_type, const char *format, ...)
 {
@@ -323,6 +414,15 @@ file_config_error(include_t error_type, const char *format, ...)
 		fprintf(conf_copy, "\n");
 	}
 
+	if (write_conf_snapshot) {
+		char err_buf[MAXBUF];
+
+		va_end(args);
+		va_start(args, format);
+		vsnprintf(err_buf, sizeof(err_buf), format, args);
+		write_snapshot_rec(SNAPSHOT_ERROR, 0, err_buf);
+	}
+
 	va_end(args);
 }
 
@@ -363,27 +463,24 @@ open_tmpfile(const char *dir, int flags, mode_t mode)
 #endif
 }
 
-void
-use_disk_copy_for_config(const char *dir_name)
+static FILE *
+move_copy_to_disk(FILE *fp, const char *dir_name)
 {
 	int fd;
 	int fd_mem;
 	char buf[512];
 	ssize_t len;
-	FILE *new_conf_copy;
-
-	if (!write_conf_copy)
-		return;
+	FILE *new_fp;
 
 	fd = open_tmpfile(dir_name, O_RDWR | O_EXCL | O_CLOEXEC, S_IRUSR | S_IWUSR);
 	if (fd == -1) {
 		report_config_error(CONFIG_GENERAL_ERROR, "Cannot open config directory %s for writing, errno %d - %m", dir_name, errno);
-		return;
+		return NULL;
 	}
 
 	/* Copy what we have already written to the disk based file */
-	rewind(conf_copy);
-	fd_mem = fileno(conf_copy);
+	rewind(fp);
+	fd_mem = fileno(fp);
 	lseek(fd_mem, 0L, SEEK_SET);
 
 	while ((len = read(fd_mem, buf, sizeof(buf))) > 0) {
@@ -394,18 +491,90 @@ use_disk_copy_for_config(const char *dir_name)
 	if (len) {
 		log_message(LOG_INFO, "Unable to config to new disk file on %s", dir_name);
 		close(fd);
-		return;
+		return NULL;
 	}
 
-	new_conf_copy = fdopen(fd, "a+");
-	if (!new_conf_copy) {
+	new_fp = fdopen(fd, "a+");
+	if (!new_fp) {
 		log_message(LOG_INFO, "fdopen of disk file error %d - %m", errno);
 		close(fd);
-		return;
+		return NULL;
+	}
+
+	fclose(fp);
+
+	return new_fp;
+}
+
+static FILE *
+open_config_copy(const char *memfd_name, const char *desc)
+{
+	int fd;
+	FILE *fp;
+
+#if defined HAVE_MEMFD_CREATE || defined USE_MEMFD_CREATE_SYSCALL
+	fd = memfd_create(memfd_name, MFD_CLOEXEC);
+
+	/* SELinux can allow memfd_create() to succeed, but reads and writes fail.
+	 * Perversely the open does not log an SELinux error if keepalived has no
+	 * permissions for "tmpfs", but if it has read and write permissions but
+	 * not open permission, then the open fails. */
+	if (fd != -1) {
+		char read_byte;		/* coverity[suspicious_sizeof] is generated if this is an int */
+
+		if (read(fd, &read_byte, 1) == -1) {
+			if (errno == EACCES)
+				log_message(LOG_INFO, "SELinux permissions for memfd (tmpfs) appear to be missing for keepalived");
+			else
+				log_message(LOG_INFO, "read from memfd failed with errno %d - %m", errno);
+			close(fd);
+			fd = open_tmpfile(RUNSTATEDIR, O_RDWR | O_EXCL | O_CLOEXEC, S_IRUSR | S_IWUSR);
+		}
+	}
+#else
+	(void)memfd_name;
+#endif
+#ifndef HAVE_MEMFD_CREATE
+#ifdef USE_MEMFD_CREATE_SYSCALL
+	if (fd == -1 && errno == ENOSYS)
+#endif
+		fd = open_tmpfile(RUNSTATEDIR, O_RDWR | O_EXCL | O_CLOEXEC, S_IRUSR | S_IWUSR);
+#endif
+	if (fd == -1) {
+		log_message(LOG_INFO, "%s open error %d - %m", desc, errno);
+		return NULL;
+	}
+
+	if (!(fp = fdopen(fd, "w+"))) {
+		log_message(LOG_INFO, "fdopen of %s fd error %d - %m", desc, errno);
+		close(fd);
 	}
 
-	fclose(conf_copy);
-	conf_copy = new_conf_copy;
+	return fp;
+}
+
+void
+use_disk_copy_for_config(const char *dir_name)
+{
+	FILE *new_fp;
+
+	if (!write_conf_copy)
+		return;
+
+	if (!(new_fp = move_copy_to_disk(conf_copy, dir_name)))
+		return;
+	conf_copy = new_fp;
+
+	if (write_conf_snapshot) {
+		if ((new_fp = move_copy_to_disk(conf_snapshot, dir_name)))
+			conf_snapshot = new_fp;
+		else {
+			/* The other processes will read conf_copy */
+			fclose(conf_snapshot);
+			conf_snapshot = NULL;
+			write_conf_snapshot = false;
+		}
+	}
 }
 
 void
@@ -983,6 +1152,67 @@ dump_keywords(vector_t *keydump, int level, FILE *fp)
 }
 #endif
 
+/* FNV-1a */
+static unsigned __attribute__ ((pure))
+keyword_str_hash(const char *str)
+{
+	unsigned hash = 2166136261U;
+
+	while (*str) {
+		hash ^= (unsigned char)*str++;
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+static keyword_t * __attribute__ ((pure))
+find_keyword(const keyword_hash_t *hash, const char *str)
+{
+	unsigned i;
+
+	for (i = keyword_str_hash(str) & hash->mask; hash->slot[i]; i = (i + 1) & hash->mask) {
+		if (!strcmp(hash->slot[i]->string, str))
+			return hash->slot[i];
+	}
+
+	return NULL;
+}
+
+/* Build the index of each level of keywords once they have all been
+ * installed. If a keyword is installed more than once at a level, the
+ * first is used, as with a search of the vector. */
+static keyword_hash_t *
+alloc_keyword_hash(const vector_t *keywords_vec)
+{
+	keyword_hash_t *hash;
+	keyword_t *keyword_vec;
+	unsigned size = 4;
+	unsigned i, j;
+
+	while (size < vector_size(keywords_vec) * 2)
+		size <<= 1;
+
+	hash = MALLOC(sizeof(*hash) + size * sizeof(hash->slot[0]));
+	hash->mask = size - 1;
+
+	for (i = 0; i < vector_size(keywords_vec); i++) {
+		keyword_vec = vector_slot(keywords_vec, i);
+
+		if (keyword_vec->sub)
+			keyword_vec->sub_hash = alloc_keyword_hash(keyword_vec->sub);
+
+		for (j = keyword_str_hash(keyword_vec->string) & hash->mask; hash->slot[j]; j = (j + 1) & hash->mask) {
+			if (!strcmp(hash->slot[j]->string, keyword_vec->string))
+				break;
+		}
+		if (!hash->slot[j])
+			hash->slot[j] = keyword_vec;
+	}
+
+	return hash;
+}
+
 static void
 free_keywords(vector_t *keywords_vec)
 {
@@ -993,6 +1223,7 @@ free_keywords(vector_t *keywords_vec)
 		keyword_vec = vector_slot(keywords_vec, i);
 		if (keyword_vec->sub)
 			free_keywords(keyword_vec->sub);
+		FREE_PTR(keyword_vec->sub_hash);
 		FREE(keyword_vec);
 	}
 	vector_free(keywords_vec);
@@ -1076,7 +1307,8 @@ alloc_strvec_quoted_escaped_common(const char *src, bool escapes)
 	char *op_buf;
 	const char *ofs, *ofs1;
 	char op_char;
-	unsigned i;
+	char *str;
+	unsigned i, num = 0;
 
 	if (!src) {
 		if (!buf_extern)
@@ -1084,19 +1316,19 @@ alloc_strvec_quoted_escaped_common(const char *src, bool escapes)
 		src = buf_extern;
 	}
 
-	/* Create a vector and alloc each command piece */
-	strvec = vector_alloc();
-	op_buf = MALLOC(MAXBUF);
+	/* The words are built up in op_buf, each terminated by a nul. Quotes
+	 * and escapes only shrink the words, and each nul replaces a separator,
+	 * so the words cannot be longer than the source. */
+	op_buf = MALLOC(strlen(src) + 1);
 
 	ofs = src;
+	ofs_op = op_buf;
 	while (*ofs) {
 		/* Find the next 'word' */
 		ofs += strspn(ofs, WHITE_SPACE);
 		if (!*ofs)
 			break;
 
-		ofs_op = op_buf;
-
 		while (*ofs) {
 			ofs1 = strpbrk(ofs, cur_quote == '"' ? "\"\\" : cur_quote == '\'' ? "'\\" : WHITE_SPACE_STR "'\"\\");
 
@@ -1208,22 +1440,32 @@ alloc_strvec_quoted_escaped_common(const char *src, bool escapes)
 			break;
 		}
 
-		/* Alloc & set the slot */
-		vector_alloc_slot(strvec);
-		vector_set_slot(strvec, STRNDUP(op_buf, ofs_op - op_buf));
+		*ofs_op++ = '\0';
+		num++;
 	}
 
-	FREE(op_buf);
-
-	if (!vector_size(strvec)) {
-		free_strvec(strvec);
+	if (!num) {
+		FREE(op_buf);
 		return NULL;
 	}
 
+	/* Create a vector in the strvec arena and set each command piece */
+	strvec = strvec_arena_alloc(sizeof(*strvec) + num * sizeof(*strvec->slot) + (size_t)(ofs_op - op_buf));
+	strvec->slot = PTR_CAST(void *, strvec + 1);
+	strvec->active = strvec->allocated = strvec->capacity = num;
+
+	str = PTR_CAST(char, strvec->slot + num);
+	memcpy(str, op_buf, (size_t)(ofs_op - op_buf));
+	for (i = 0; i < num; i++) {
+		strvec->slot[i] = str;
+		str += strlen(str) + 1;
+	}
+
+	FREE(op_buf);
+
 	return strvec;
 
 err_exit:
-	free_strvec(strvec);
 	FREE(op_buf);
 	return NULL;
 }
@@ -1240,72 +1482,98 @@ alloc_strvec_quoted(const char *src)
 	return alloc_strvec_quoted_escaped_common(src, false);
 }
 
+/* Returns the start of the next token of a line, and sets *cp to after
+ * the token, or returns NULL if there are no more tokens. */
+static const char *
+next_strvec_token(const char **cp, size_t *len, bool *unmatched_quote)
+{
+	const char *start;
+
+	*cp += strspn(*cp, WHITE_SPACE);
+	if (!**cp)
+		return NULL;
+
+	start = *cp;
+
+	/* Save a quoted string without the ""s as a single string */
+	if (*start == '"') {
+		start++;
+		if (!(*cp = strchr(start, '"'))) {
+			*unmatched_quote = true;
+			return NULL;
+		}
+		*len = (size_t)(*cp - start);
+		(*cp)++;
+	} else {
+		*cp += strcspn(start, WHITE_SPACE_STR "\"");
+		*len = (size_t)(*cp - start);
+	}
+
+	return start;
+}
+
+/* The strvec, its slots and strings are allocated as one block from the
+ * strvec arena, and are released when the parser finishes the line. */
 vector_t *
 alloc_strvec_r(const char *string, const vector_t *keywords_vec)
 {
-	const char *cp, *start;
-	size_t str_len;
+	const char *cp, *start, *first = NULL;
+	size_t len, first_len = 0, str_size = 0;
 	vector_t *strvec;
-	unsigned i;
+	char *str;
+	unsigned i, num = 0;
+	bool unmatched_quote = false;
 	bool allow_mismatched_quotes;
 	keyword_t *keyword_vec;
-	const char *keyword;
 
 	if (!string)
 		return NULL;
 
-	/* Create a vector and alloc each command piece */
-	strvec = vector_alloc();
-
+	/* Count the tokens and the space needed for them */
 	cp = string;
-	while (true) {
-		cp += strspn(cp, WHITE_SPACE);
-		if (!*cp)
-			break;
-
-		start = cp;
-
-		/* Save a quoted string without the ""s as a single string */
-		if (*start == '"') {
-			start++;
-			if (!(cp = strchr(start, '"'))) {
-				allow_mismatched_quotes = false;
-				if (vector_size(strvec) > 1 && keywords_vec) {
-					keyword = strvec_slot(strvec, 0);
+	while ((start = next_strvec_token(&cp, &len, &unmatched_quote))) {
+		if (!num++) {
+			first = start;
+			first_len = len;
+		}
+		str_size += len + 1;
+	}
 
-					/* Check to see if the second string will be reprocessed */
-					for (i = 0; i < vector_size(keywords_vec); i++) {
-						keyword_vec = vector_slot(keywords_vec, i);
+	if (unmatched_quote) {
+		allow_mismatched_quotes = false;
+		if (num > 1 && keywords_vec) {
+			/* Check to see if the second string will be reprocessed */
+			for (i = 0; i < vector_size(keywords_vec); i++) {
+				keyword_vec = vector_slot(keywords_vec, i);
 
-						if (!strcmp(keyword_vec->string, keyword)) {
-							allow_mismatched_quotes = keyword_vec->allow_mismatched_quotes;
-							break;
-						}
-					}
+				if (!strncmp(keyword_vec->string, first, first_len) && !keyword_vec->string[first_len]) {
+					allow_mismatched_quotes = keyword_vec->allow_mismatched_quotes;
+					break;
 				}
-				if (!allow_mismatched_quotes
-#ifndef _ONE_PROCESS_DEBUG_
-				     && prog_type != PROG_TYPE_PARENT
-#endif
-								     )
-					report_config_error(CONFIG_UNMATCHED_QUOTE, "Unmatched quote: '%s'", string);
-				break;
 			}
-			str_len = (size_t)(cp - start);
-			cp++;
-		} else {
-			cp += strcspn(start, WHITE_SPACE_STR "\"");
-			str_len = (size_t)(cp - start);
 		}
-
-		/* Alloc & set the slot */
-		vector_alloc_slot(strvec);
-		vector_set_slot(strvec, STRNDUP(start, str_len));
+		if (!allow_mismatched_quotes
+#ifndef _ONE_PROCESS_DEBUG_
+		     && prog_type != PROG_TYPE_PARENT
+#endif
+						     )
+			report_config_error(CONFIG_UNMATCHED_QUOTE, "Unmatched quote: '%s'", string);
 	}
 
-	if (!vector_size(strvec)) {
-		free_strvec(strvec);
+	if (!num)
 		return NULL;
+
+	strvec = strvec_arena_alloc(sizeof(*strvec) + num * sizeof(*strvec->slot) + str_size);
+	strvec->slot = PTR_CAST(void *, strvec + 1);
+	strvec->active = strvec->allocated = strvec->capacity = num;
+
+	str = PTR_CAST(char, strvec->slot + num);
+	for (cp = string, i = 0; i < num; i++) {
+		start = next_strvec_token(&cp, &len, &unmatched_quote);
+		memcpy(str, start, len);
+		str[len] = '\0';
+		strvec->slot[i] = str;
+		str += len + 1;
 	}
 
 	return strvec;
@@ -1698,6 +1966,100 @@ dump_definitions(void)
 }
 #endif
 
+static uint64_t __attribute__ ((pure))
+conf_hash(uint64_t hash, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+
+	while (len--) {
+		hash ^= *p++;
+		hash *= CONF_HASH_PRIME;
+	}
+
+	return hash;
+}
+
+static conf_source_t *
+add_conf_source(const char *dir, const char *pattern, uint64_t hash)
+{
+	conf_source_t *source;
+
+	PMALLOC(source);
+	INIT_LIST_HEAD(&source->e_list);
+	source->dir = STRDUP(dir);
+	source->pattern = STRDUP(pattern);
+	source->hash = hash;
+	list_add_tail(&source->e_list, &conf_sources);
+
+	return source;
+}
+
+void
+free_config_sources(void)
+{
+	conf_source_t *source, *source_tmp;
+
+	list_for_each_entry_safe(source, source_tmp, &conf_sources, e_list) {
+		list_del_init(&source->e_list);
+		FREE_CONST(source->dir);
+		FREE_CONST(source->pattern);
+		FREE(source);
+	}
+
+	conf_sources_complete = false;
+}
+
+/* The records are written at the end of the copy as "#=<hash> <dir length> <dir><pattern>",
+ * followed by "#=" if all the globs were recorded */
+static void
+write_conf_sources(void)
+{
+	conf_source_t *source;
+
+	if (!conf_sources_complete)
+		return;
+
+	list_for_each_entry(source, &conf_sources, e_list) {
+		if (strchr(source->dir, '\n') || strchr(source->pattern, '\n'))
+			return;
+	}
+
+	list_for_each_entry(source, &conf_sources, e_list)
+		fprintf(conf_copy, "#=%" PRIx64 " %zu %s%s\n", source->hash, strlen(source->dir), source->dir, source->pattern);
+	fprintf(conf_copy, "#=\n");
+}
+
+static void
+read_conf_source_rec(const char *rec)
+{
+	uint64_t hash;
+	size_t dir_len;
+	char *dir, *end;
+
+#ifndef _ONE_PROCESS_DEBUG_
+	/* Only the parent reloads, the other processes skip the records */
+	if (prog_type != PROG_TYPE_PARENT)
+#endif
+		return;
+
+	if (rec[0] == '\n') {
+		conf_sources_complete = true;
+		return;
+	}
+
+	hash = strtoull(rec, &end, 16);
+	if (*end != ' ')
+		return;
+	dir_len = strtoul(end + 1, &end, 10);
+	if (*end++ != ' ' || strlen(end) <= dir_len + 1)
+		return;
+
+	dir = STRNDUP(end, dir_len);
+	end[strlen(end) - 1] = '\0';
+	add_conf_source(dir, end + dir_len, hash);
+	FREE(dir);
+}
+
 #if HAVE_DECL_GLOB_ALTDIRFUNC
 static DIR *
 gl_opendir(const char *name)
@@ -1820,10 +2182,18 @@ open_and_check_glob(glob_t *globbuf, const char *conf_file, include_t include_ty
 }
 
 static bool
-check_glob_file(const char *file_name)
+is_conf_file(const char *file_name)
 {
 	struct stat stb;
 
+	return !stat(file_name, &stb) &&
+	       S_ISREG(stb.st_mode) &&
+	       !(stb.st_mode & (S_IXUSR | S_IXGRP | S_IXOTH));
+}
+
+static bool
+check_glob_file(const char *file_name)
+{
 	if (file_name[0] && file_name[strlen(file_name)-1] == '/') {
 		/* This is a directory - so skip */
 		file_config_error(INCLUDE_R, "Configuration file '%s' is a directory - skipping"
@@ -1832,9 +2202,7 @@ check_glob_file(const char *file_name)
 	}
 
 	/* Make sure what we have opened is a regular file, and not for example a directory or executable */
-	if (stat(file_name, &stb) ||
-	    !S_ISREG(stb.st_mode) ||
-	    (stb.st_mode & (S_IXUSR | S_IXGRP | S_IXOTH))) {
+	if (!is_conf_file(file_name)) {
 		file_config_error(INCLUDE_R, "Configuration file '%s' is not a regular non-executable file - skipping", file_name);
 		return false;
 	}
@@ -2422,6 +2790,9 @@ open_conf_file(include_file_t *file)
 	while (file->glob_next < file->globbuf.gl_pathc) {
 		i = file->glob_next++;
 
+		if (file->source)
+			file->source->hash = conf_hash(file->source->hash, file->globbuf.gl_pathv[i], strlen(file->globbuf.gl_pathv[i]) + 1);
+
 		if (!check_glob_file(file->globbuf.gl_pathv[i]))
 			continue;
 
@@ -2438,9 +2809,12 @@ open_conf_file(include_file_t *file)
 		/* Allow tracking of file names/numbers */
 		if (write_conf_copy)
 			fprintf(conf_copy, "# %s\n", file->globbuf.gl_pathv[i]);
+		if (write_conf_snapshot)
+			write_snapshot_rec(SNAPSHOT_OPEN, 0, file->globbuf.gl_pathv[i]);
 
 		file->stream = stream;
 		file->num_matches++;
+		file->content_hash = CONF_HASH_OFFSET;
 
 		/* We only want to report the file name if there is more than one file used */
 		if (!list_is_last(&file->e_list, &include_stack) || file->globbuf.gl_pathc > 1)
@@ -2477,6 +2851,15 @@ open_glob_file(const char *conf_file, include_t include_type)
 	file->sav_include_check = include_check;
 	list_head_add(&file->e_list, &include_stack);
 
+	if (record_conf_sources) {
+		char dir[PATH_MAX];
+
+		if (getcwd(dir, sizeof(dir)))
+			file->source = add_conf_source(dir, conf_file, CONF_HASH_OFFSET);
+		else
+			record_conf_sources = false;
+	}
+
 	if (!open_and_check_glob(&file->globbuf, conf_file, include_type)) {
 		list_head_del(&file->e_list);
 		FREE(file);
@@ -2506,10 +2889,15 @@ end_file(include_file_t *file)
 	if (file->stream != conf_copy)
 		fclose(file->stream);
 
+	if (file->source)
+		file->source->hash = conf_hash(file->source->hash, &file->content_hash, sizeof(file->content_hash));
+
 	if (write_conf_copy) {
 		/* Indicate a file is being closed */
 		fprintf(conf_copy, "!\n");
 	}
+	if (write_conf_snapshot)
+		write_snapshot_rec(SNAPSHOT_CLOSE, 0, NULL);
 
 // WHY??
 //	free_seq_list(&seq_list);
@@ -2621,6 +3009,189 @@ check_include(const char *buf)
 	return true;
 }
 
+/* Track an include file opened when the configuration was copied */
+static include_file_t *
+push_copy_file(FILE *stream, const char *file_name)
+{
+	include_file_t *file;
+
+	PMALLOC(file);
+	INIT_LIST_HEAD(&file->e_list);
+
+	file->stream = stream;
+	file->globbuf.gl_offs = 0;
+	file->num_matches = 1;
+	file->file_name = STRDUP(file_name);
+	file->current_file_name = file->file_name;
+	list_head_add(&file->e_list, &include_stack);
+	if (write_conf_snapshot)
+		write_snapshot_rec(SNAPSHOT_OPEN, 0, file_name);
+	if (strchr(file->current_file_name, '/')) {
+		/* If the filename contains a directory element, change to that directory. */
+		file->curdir_fd = open(".", O_RDONLY | O_DIRECTORY | O_PATH | O_CLOEXEC);
+
+		char *confpath = STRDUP(file_name);
+		dirname(confpath);
+		if (chdir(confpath) < 0)
+			log_message(LOG_INFO, "chdir(%s) error (%s)", confpath, strerror(errno));
+		FREE(confpath);
+	} else
+		file->curdir_fd = -1;
+
+	return file;
+}
+
+static void
+pop_copy_file(void)
+{
+	include_file_t *file = list_first_entry(&include_stack, include_file_t, e_list);
+
+	if (write_conf_snapshot)
+		write_snapshot_rec(SNAPSHOT_CLOSE, 0, NULL);
+
+	if (file->curdir_fd != -1) {
+		if (fchdir(file->curdir_fd))
+			log_message(LOG_INFO, "Failed to restore previous directory after include");
+		close(file->curdir_fd);
+	}
+	FREE_CONST_PTR(file->current_file_name);
+
+	list_del_init(&file->e_list);
+	FREE(file);
+}
+
+static void
+check_block_depth(const char *buf)
+{
+	/* Check that we haven't got too many '}'s */
+	if (!strcmp(buf, BOB))
+		block_depth++;
+	else if (!strcmp(buf, EOB)) {
+		if (block_depth-- < 1) {
+			report_config_error(CONFIG_UNEXPECTED_EOB, "Extra '}' found");
+			block_depth = 0;
+		}
+	}
+}
+
+static void
+start_conf_snapshot(void)
+{
+	conf_snapshot_hdr_t hdr = { .magic = CONF_SNAPSHOT_MAGIC, .version = CONF_SNAPSHOT_VERSION };
+
+	if (!conf_snapshot)
+		conf_snapshot = open_config_copy("/keepalived/configuration_snapshot", "conf_snapshot");
+	else {
+		if (ftruncate(fileno(conf_snapshot), 0))
+			log_message(LOG_INFO, "Failed to truncate config snapshot file (%d) - %m", errno);
+
+		rewind(conf_snapshot);
+	}
+
+	if (!conf_snapshot)
+		return;
+
+	fwrite(&hdr, sizeof(hdr), 1, conf_snapshot);
+	write_conf_snapshot = true;
+	conf_snapshot_complete = false;
+}
+
+static bool
+map_conf_snapshot(void)
+{
+	struct stat statbuf;
+	const conf_snapshot_hdr_t *hdr;
+	const conf_snapshot_rec_t *end;
+	void *map;
+
+	if (!conf_snapshot ||
+	    fstat(fileno(conf_snapshot), &statbuf) ||
+	    (size_t)statbuf.st_size < sizeof(*hdr) + sizeof(*end) + SNAPSHOT_TEXT_SIZE(0))
+		return false;
+
+	map = mmap(NULL, (size_t)statbuf.st_size, PROT_READ, MAP_PRIVATE, fileno(conf_snapshot), 0);
+	if (map == MAP_FAILED) {
+		log_message(LOG_INFO, "Unable to map configuration snapshot (%d) - %m", errno);
+		return false;
+	}
+
+	snapshot_map = map;
+	snapshot_size = (size_t)statbuf.st_size;
+	snapshot_end = snapshot_map + snapshot_size - sizeof(*end) - SNAPSHOT_TEXT_SIZE(0);
+
+	/* The snapshot must have been completely written */
+	hdr = PTR_CAST_CONST(conf_snapshot_hdr_t, snapshot_map);
+	end = PTR_CAST_CONST(conf_snapshot_rec_t, snapshot_end);
+	if (hdr->magic != CONF_SNAPSHOT_MAGIC ||
+	    hdr->version != CONF_SNAPSHOT_VERSION ||
+	    end->type != SNAPSHOT_END) {
+		munmap(map, snapshot_size);
+		snapshot_map = NULL;
+		return false;
+	}
+
+	snapshot_pos = snapshot_map + sizeof(*hdr);
+
+	return true;
+}
+
+static void
+unmap_conf_snapshot(void)
+{
+	/* Restore the directory if the configuration wasn't read to the end */
+	while (!list_empty(&include_stack))
+		pop_copy_file();
+
+	munmap(no_const_char_p(snapshot_map), snapshot_size);
+	snapshot_map = snapshot_pos = snapshot_end = NULL;
+}
+
+static bool
+read_snapshot_line(char *buf, size_t size)
+{
+	const conf_snapshot_rec_t *rec;
+	include_file_t *file;
+
+	while (snapshot_pos < snapshot_end) {
+		rec = PTR_CAST_CONST(conf_snapshot_rec_t, snapshot_pos);
+		snapshot_pos += sizeof(*rec) + SNAPSHOT_TEXT_SIZE(rec->len);
+
+		switch (rec->type) {
+		case SNAPSHOT_LINE:
+			file = list_first_entry(&include_stack, include_file_t, e_list);
+			file->current_line_no = rec->line_no;
+
+			if (rec->len >= size) {
+				report_config_error(CONFIG_GENERAL_ERROR, "line too long - ignoring");
+				break;
+			}
+
+			memcpy(buf, rec->text, rec->len + 1U);
+			check_block_depth(buf);
+
+			return true;
+		case SNAPSHOT_OPEN:
+			push_copy_file(NULL, rec->text);
+			break;
+		case SNAPSHOT_CLOSE:
+			pop_copy_file();
+			break;
+		case SNAPSHOT_ERROR:
+#ifndef _ONE_PROCESS_DEBUG_
+			if (prog_type == PROG_TYPE_PARENT)
+#endif
+				report_config_error(CONFIG_FILE_NOT_FOUND, "%s", rec->text);
+			break;
+		default:
+			break;
+		}
+	}
+
+	buf[0] = '\0';
+
+	return false;
+}
+
 static bool
 read_line(char *buf, size_t size)
 {
@@ -2642,6 +3213,9 @@ read_line(char *buf, size_t size)
 	param_t *param;
 	include_file_t *file;
 
+	if (snapshot_map)
+		return read_snapshot_line(buf, size);
+
 	config_id_len = config_id ? strlen(config_id) : 0;
 	do {
 		if (line_residue) {
@@ -2735,54 +3309,36 @@ read_line(char *buf, size_t size)
 					break;
 				}
 
+				if (file->source)
+					file->content_hash = conf_hash(file->content_hash, buf, strlen(buf));
+
 				if (read_conf_copy) {
 					if (buf[0] == '#') {
+						if (buf[1] == '=') {
+							read_conf_source_rec(buf + 2);
+							buf[0] = '\0';
+							continue;
+						}
+
 						if (buf[1] == '!') {
+							buf[strlen(buf) - 1] = '\0';
 #ifndef _ONE_PROCESS_DEBUG_
 							if (prog_type == PROG_TYPE_PARENT)
 #endif
-								report_config_error(CONFIG_FILE_NOT_FOUND, "%.*s", (int)strlen(buf + 3) - 1, buf + 3);
+								report_config_error(CONFIG_FILE_NOT_FOUND, "%s", buf + 3);
+							if (write_conf_snapshot)
+								write_snapshot_rec(SNAPSHOT_ERROR, 0, buf + 3);
 							buf[0] = '\0';
 							continue;
 						}
 
-						FILE *fps = file->stream;
-
-						PMALLOC(file);
-						INIT_LIST_HEAD(&file->e_list);
-
-						file->stream = fps;
-						file->globbuf.gl_offs = 0;
-						file->num_matches = 1;
 						buf[strlen(buf) - 1] = '\0';
-						file->file_name = STRDUP(buf + 2);
-						file->current_file_name = file->file_name;
-						list_head_add(&file->e_list, &include_stack);
-						if (strchr(file->current_file_name, '/')) {
-							/* If the filename contains a directory element, change to that directory. */
-							file->curdir_fd = open(".", O_RDONLY | O_DIRECTORY | O_PATH | O_CLOEXEC);
-
-							char *confpath = STRDUP(buf + 2);
-							dirname(confpath);
-							if (chdir(confpath) < 0)
-								log_message(LOG_INFO, "chdir(%s) error (%s)", confpath, strerror(errno));
-							FREE(confpath);
-						} else
-							file->curdir_fd = -1;
+						file = push_copy_file(file->stream, buf + 2);
 
 						buf[0] = '\0';
 						continue;
 					} else if (buf[0] == '!') {
-						if (file->curdir_fd != -1) {
-							if (fchdir(file->curdir_fd))
-								log_message(LOG_INFO, "Failed to restore previous directory after include");
-							close(file->curdir_fd);
-						}
-						file = list_first_entry(&include_stack, include_file_t, e_list);
-						FREE_CONST_PTR(file->current_file_name);
-
-						list_del_init(&file->e_list);
-						FREE(file);
+						pop_copy_file();
 						file = list_first_entry(&include_stack, include_file_t, e_list);
 
 						buf[0] = '\0';
@@ -2993,14 +3549,16 @@ read_line(char *buf, size_t size)
 			len--;
 		buf[len] = '\0';
 
-		/* Check that we haven't got too many '}'s */
-		if (!strcmp(buf, BOB))
-			block_depth++;
-		else if (!strcmp(buf, EOB)) {
-			if (block_depth-- < 1) {
-				report_config_error(CONFIG_UNEXPECTED_EOB, "Extra '}' found");
-				block_depth = 0;
-			}
+		check_block_depth(buf);
+	}
+
+	if (write_conf_snapshot) {
+		if (buf[0]) {
+			file = list_empty(&include_stack) ? NULL : list_first_entry(&include_stack, include_file_t, e_list);
+			write_snapshot_rec(SNAPSHOT_LINE, file ? file->current_line_no : 0, buf);
+		} else if (eof && !conf_snapshot_complete) {
+			write_snapshot_rec(SNAPSHOT_END, 0, NULL);
+			conf_snapshot_complete = true;
 		}
 	}
 
@@ -3025,6 +3583,7 @@ alloc_value_block(void (*alloc_func) (const vector_t *), const vector_t *strvec)
 	vector_t *first_vec = NULL;
 	bool need_bob = true;
 	bool had_eob = false;
+	strvec_arena_mark_t mark = strvec_arena_mark();
 
 	if (vector_active(strvec) > 1) {
 		if (!strcmp(strvec_slot(strvec, 1), BOB)) {
@@ -3046,6 +3605,8 @@ alloc_value_block(void (*alloc_func) (const vector_t *), const vector_t *strvec)
 
 	buf = (char *)MALLOC(MAXBUF);
 	while (first_vec || read_line(buf, MAXBUF)) {
+		strvec_arena_release(mark);
+
 		if (first_vec)
 			vec = first_vec;
 		else if (!(vec = alloc_strvec(buf, NULL)))
@@ -3093,11 +3654,12 @@ alloc_value_block(void (*alloc_func) (const vector_t *), const vector_t *strvec)
 			break;
 	}
 
+	strvec_arena_release(mark);
 	FREE(buf);
 }
 
 static bool
-process_stream(vector_t *keywords_vec, int need_bob)
+process_stream(vector_t *keywords_vec, const keyword_hash_t *hash, int need_bob)
 {
 	unsigned int i;
 	keyword_t *keyword_vec;
@@ -3109,9 +3671,13 @@ process_stream(vector_t *keywords_vec, int need_bob)
 	int bob_needed = 0;
 	bool ret_err = false;
 	bool ret;
+	strvec_arena_mark_t mark = strvec_arena_mark();
 
 	buf = MALLOC(MAXBUF);
 	while (read_line(buf, MAXBUF)) {
+		/* Release the previous line's strvecs, and any of nested blocks */
+		strvec_arena_release(mark);
+
 		strvec = alloc_strvec(buf, keywords_vec);
 
 		if (!strvec)
@@ -3176,72 +3742,67 @@ process_stream(vector_t *keywords_vec, int need_bob)
 			break;
 		}
 
-		for (i = 0; i < vector_size(keywords_vec); i++) {
-			keyword_vec = vector_slot(keywords_vec, i);
-
-			if (!strcmp(keyword_vec->string, str)) {
-				if (!keyword_vec->active) {
-					if (!strcmp(vector_slot(strvec, vector_size(strvec)-1), BOB))
-						skip_sublevel = 1;
-					else
-						skip_sublevel = -1;
-
-					/* Sometimes a process wants to know if another process
-					 * has any of a type of configuration. For example, there
-					 * is no point starting the VRRP process of there are no
-					 * vrrp instances, and so the parent process would be
-					 * interested in that. */
-					if (keyword_vec->handler)
-						(*keyword_vec->handler)(NULL);
-				}
-
-				/* There is an inconsistency here. 'static_ipaddress' for example
-				 * does not have sub levels, but needs a '{' */
-				if (keyword_vec->sub) {
-					/* Remove a trailing '{' */
-					char *bob = vector_slot(strvec, vector_size(strvec)-1) ;
-					if (!strcmp(bob, BOB)) {
-						vector_unset(strvec, vector_size(strvec)-1);
-						FREE(bob);
-						bob_needed = 0;
-					}
-					else
-						bob_needed = 1;
-				}
+		if ((keyword_vec = find_keyword(hash, str))) {
+			if (!keyword_vec->active) {
+				if (!strcmp(vector_slot(strvec, vector_size(strvec)-1), BOB))
+					skip_sublevel = 1;
+				else
+					skip_sublevel = -1;
+
+				/* Sometimes a process wants to know if another process
+				 * has any of a type of configuration. For example, there
+				 * is no point starting the VRRP process of there are no
+				 * vrrp instances, and so the parent process would be
+				 * interested in that. */
+				if (keyword_vec->handler)
+					(*keyword_vec->handler)(NULL);
+			}
 
-				if (keyword_vec->active && keyword_vec->handler && (!keyword_vec->ptr || *keyword_vec->ptr)) {
-					buf_extern = buf;	/* In case the raw line wants to be accessed */
-					(*keyword_vec->handler) (strvec);
+			/* There is an inconsistency here. 'static_ipaddress' for example
+			 * does not have sub levels, but needs a '{' */
+			if (keyword_vec->sub) {
+				/* Remove a trailing '{' */
+				const char *bob = vector_slot(strvec, vector_size(strvec)-1) ;
+				if (!strcmp(bob, BOB)) {
+					vector_unset(strvec, vector_size(strvec)-1);
+					bob_needed = 0;
 				}
+				else
+					bob_needed = 1;
+			}
 
-				if (keyword_vec->sub) {
-					kw_level++;
-					ret = process_stream(keyword_vec->sub, bob_needed);
-					kw_level--;
-
-					/* We mustn't run any close handler if the block was skipped */
-					if (!ret &&
-					    keyword_vec->active) {
-						if (keyword_vec->sub_close_handler &&
-						    (!keyword_vec->sub_close_ptr || *keyword_vec->sub_close_ptr))
-							(*keyword_vec->sub_close_handler)();
-
-						/* We have finished the block, so the *keyword_vec->sub_close_ptr item is no longer current */
-						if (keyword_vec->sub_close_ptr)
-							*keyword_vec->sub_close_ptr = NULL;
-					}
+			if (keyword_vec->active && keyword_vec->handler && (!keyword_vec->ptr || *keyword_vec->ptr)) {
+				buf_extern = buf;	/* In case the raw line wants to be accessed */
+				(*keyword_vec->handler) (strvec);
+			}
 
+			if (keyword_vec->sub) {
+				kw_level++;
+				ret = process_stream(keyword_vec->sub, keyword_vec->sub_hash, bob_needed);
+				kw_level--;
+
+				/* We mustn't run any close handler if the block was skipped */
+				if (!ret &&
+				    keyword_vec->active) {
+					if (keyword_vec->sub_close_handler &&
+					    (!keyword_vec->sub_close_ptr || *keyword_vec->sub_close_ptr))
+						(*keyword_vec->sub_close_handler)();
+
+					/* We have finished the block, so the *keyword_vec->sub_close_ptr item is no longer current */
+					if (keyword_vec->sub_close_ptr)
+						*keyword_vec->sub_close_ptr = NULL;
 				}
-				break;
+
 			}
 		}
-
-		if (i >= vector_size(keywords_vec))
+		else
 			report_config_error(CONFIG_UNKNOWN_KEYWORD, "Unknown keyword '%s'", str);
 
 		free_strvec(strvec);
 	}
 
+	strvec_arena_release(mark);
+
 	current_keywords = prev_keywords;
 	FREE(buf);
 	return ret_err;
@@ -3252,7 +3813,6 @@ void
 init_data(const char *conf_file, const vector_t * (*init_keywords) (void), bool copy_config)
 {
 	bool file_opened = false;
-	int fd;
 #ifndef _ONE_PROCESS_DEBUG_
 	static unsigned conf_num = 0;
 #endif
@@ -3270,6 +3830,7 @@ init_data(const char *conf_file, const vector_t * (*init_keywords) (void), bool
 	keywords = vector_alloc();
 
 	(*init_keywords) ();
+	keywords_hash = alloc_keyword_hash(keywords);
 
 	/* Add out standard definitions */
 	set_std_definitions();
@@ -3284,51 +3845,26 @@ init_data(const char *conf_file, const vector_t * (*init_keywords) (void), bool
 	current_keywords = keywords;
 
 	if (copy_config) {
-		if (!conf_copy) {
-#if defined HAVE_MEMFD_CREATE || defined USE_MEMFD_CREATE_SYSCALL
-			fd = memfd_create("/keepalived/consolidated_configuration", MFD_CLOEXEC);
-
-			/* SELinux can allow memfd_create() to succeed, but reads and writes fail.
-			 * Perversely the open does not log an SELinux error if keepalived has no
-			 * permissions for "tmpfs", but if it has read and write permissions but
-			 * not open permission, then the open fails. */
-			if (fd != -1) {
-				char read_byte;		/* coverity[suspicious_sizeof] is generated if this is an int */
-
-				if (read(fd, &read_byte, 1) == -1) {
-					if (errno == EACCES)
-						log_message(LOG_INFO, "SELinux permissions for memfd (tmpfs) appear to be missing for keepalived");
-					else
-						log_message(LOG_INFO, "read from memfd failed with errno %d - %m", errno);
-					close(fd);
-					fd = open_tmpfile(RUNSTATEDIR, O_RDWR | O_EXCL | O_CLOEXEC, S_IRUSR | S_IWUSR);
-				}
-			}
-#endif
-#ifndef HAVE_MEMFD_CREATE
-#ifdef USE_MEMFD_CREATE_SYSCALL
-			if (fd == -1 && errno == ENOSYS)
-#endif
-				fd = open_tmpfile(RUNSTATEDIR, O_RDWR | O_EXCL | O_CLOEXEC, S_IRUSR | S_IWUSR);
-#endif
-			if (fd == -1)
-				log_message(LOG_INFO, "conf_copy open error %d - %m", errno);
-			else {
-				conf_copy = fdopen(fd, "w+");
-				if (!conf_copy)
-					log_message(LOG_INFO, "fdopen of conf_copy fd error %d - %m", errno);
-			}
-		} else {
+		if (!conf_copy)
+			conf_copy = open_config_copy("/keepalived/consolidated_configuration", "conf_copy");
+		else {
 			if (ftruncate(fileno(conf_copy), 0))
 				log_message(LOG_INFO, "Failed to truncate config copy file (%d) - %m", errno);
 
 			rewind(conf_copy);
 		}
 
-		if (conf_copy)
+		if (conf_copy) {
 			write_conf_copy = true;
+			start_conf_snapshot();
+		}
 	}
 
+	/* The process reading the configuration files records them, and the
+	 * parent otherwise gets the records from the copy */
+	free_config_sources();
+	record_conf_sources = write_conf_copy;
+
 	if (!copy_config && conf_copy) {
 		include_file_t *file;
 
@@ -3350,6 +3886,16 @@ init_data(const char *conf_file, const vector_t * (*init_keywords) (void), bool
 
 		read_conf_copy = true;
 		file_opened = true;
+
+#ifndef _ONE_PROCESS_DEBUG_
+		/* If reload_check_config is set, the parent reads the copy written
+		 * by the config test process, and the snapshot is of the previous
+		 * configuration, so it writes a new one as it reads the copy */
+		if (prog_type == PROG_TYPE_PARENT)
+			start_conf_snapshot();
+		else
+#endif
+			map_conf_snapshot();
 	} else if (open_glob_file(conf_file, INCLUDE_R | INCLUDE_M | INCLUDE_W)) {
 		/* Opened the first file */
 		file_opened = true;
@@ -3360,9 +3906,17 @@ init_data(const char *conf_file, const vector_t * (*init_keywords) (void), bool
 
 	if (file_opened) {
 		register_null_strvec_handler(null_strvec);
-		process_stream(current_keywords, 0);
+		process_stream(current_keywords, keywords_hash, 0);
 		unregister_null_strvec_handler();
 
+		if (record_conf_sources) {
+			conf_sources_complete = true;
+			record_conf_sources = false;
+		}
+
+		if (snapshot_map)
+			unmap_conf_snapshot();
+
 /* Is this right - the seq_list should be empty ???? */
 		free_seq_list(&seq_list);
 
@@ -3372,7 +3926,20 @@ init_data(const char *conf_file, const vector_t * (*init_keywords) (void), bool
 						      , block_depth, EOB, BOB);
 	}
 
+	if (write_conf_snapshot) {
+		/* If the snapshot is incomplete the other processes will read conf_copy */
+		if (fflush(conf_snapshot) || ferror(conf_snapshot)) {
+			log_message(LOG_INFO, "Error writing config snapshot - %m");
+			if (ftruncate(fileno(conf_snapshot), 0))
+				log_message(LOG_INFO, "Failed to truncate config snapshot file (%d) - %m", errno);
+			clearerr(conf_snapshot);
+		}
+		write_conf_snapshot = false;
+		rewind(conf_snapshot);
+	}
+
 	if (conf_copy && write_conf_copy) {
+		write_conf_sources();
 		fflush(conf_copy);
 		write_conf_copy = false;
 
@@ -3403,6 +3970,8 @@ init_data(const char *conf_file, const vector_t * (*init_keywords) (void), bool
 	endpwent();
 
 	free_keywords(keywords);
+	FREE(keywords_hash);
+	strvec_arena_free();
 	free_parser_data();
 }
 
@@ -3426,6 +3995,69 @@ set_config_fd(int fd)
 		log_message(LOG_INFO, "Unable to open config copy file (%d) - %m", errno);
 }
 
+/* Repeat the globs recorded when the configuration was last read, and check
+ * that they match the same files with the same contents */
+bool
+config_files_unchanged(void)
+{
+	conf_source_t *source;
+	glob_t globbuf;
+	uint64_t hash, content_hash;
+	char buf[MAXBUF];
+	FILE *fp;
+	int curdir_fd;
+	size_t i;
+	bool unchanged = true;
+
+	if (!conf_sources_complete)
+		return false;
+
+	if ((curdir_fd = open(".", O_RDONLY | O_DIRECTORY | O_PATH | O_CLOEXEC)) == -1)
+		return false;
+
+	list_for_each_entry(source, &conf_sources, e_list) {
+		if (chdir(source->dir)) {
+			unchanged = false;
+			break;
+		}
+
+		hash = CONF_HASH_OFFSET;
+		globbuf.gl_offs = 0;
+		if (!glob(source->pattern, GLOB_MARK
+#if HAVE_DECL_GLOB_BRACE
+					 | GLOB_BRACE
+#endif
+						     , NULL, &globbuf)) {
+			for (i = 0; i < globbuf.gl_pathc; i++) {
+				hash = conf_hash(hash, globbuf.gl_pathv[i], strlen(globbuf.gl_pathv[i]) + 1);
+
+				if (!is_conf_file(globbuf.gl_pathv[i]) ||
+				    !(fp = fopen(globbuf.gl_pathv[i], "re")))
+					continue;
+
+				content_hash = CONF_HASH_OFFSET;
+				while (fgets(buf, sizeof(buf), fp))
+					content_hash = conf_hash(content_hash, buf, strlen(buf));
+				fclose(fp);
+
+				hash = conf_hash(hash, &content_hash, sizeof(content_hash));
+			}
+			globfree(&globbuf);
+		}
+
+		if (hash != source->hash) {
+			unchanged = false;
+			break;
+		}
+	}
+
+	if (fchdir(curdir_fd))
+		log_message(LOG_INFO, "Failed to restore directory after checking config files");
+	close(curdir_fd);
+
+	return unchanged;
+}
+
 void include_check_set(const vector_t *strvec)
 {
 	const char *word;
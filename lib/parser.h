@@ -77,10 +77,12 @@ typedef enum {
 /* keyword definition */
 typedef void **vpp_t;
 #define	VPP (vpp_t)
+typedef struct _keyword_hash keyword_hash_t;
 typedef struct _keyword {
 	const char *string;
 	void (*handler) (const vector_t *);
 	vector_t *sub;
+	keyword_hash_t *sub_hash;	/* index of sub, built when all keywords are installed */
 	void (*sub_close_handler) (void);
 	bool active;
 	bool allow_mismatched_quotes;
@@ -158,6 +160,8 @@ extern void skip_block(bool);
 extern void init_data(const char *, const vector_t * (*init_keywords) (void), bool);
 extern int get_config_fd(void);
 extern void set_config_fd(int);
+extern bool config_files_unchanged(void);
+extern void free_config_sources(void);
 void include_check_set(const vector_t *);
 bool had_config_file_error(void) __attribute__((pure));
 void separate_config_file(void);
@@ -0,0 +1,715 @@
+/*
+ * Soft:        Keepalived is a failover program for the LVS project
+ *              <www.linuxvirtualserver.org>. It monitor & manipulate
+ *              a loadbalanced server pool using multi-layer checks.
+ *
+ * Part:        Local query sockets. A process listens on a unix stream
+ *              socket, or a loopback TCP port, and writes a snapshot of
+ *              its state to each client from the scheduler loop, so that
+ *              it can be polled without signals or dump files.
+ *
+ * Author:      Alexandre Cassen, <acassen@linux-vs.org>
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *              See the GNU General Public License for more details.
+ *
+ *              This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU General Public License
+ *              as published by the Free Software Foundation; either version
+ *              2 of the License, or (at your option) any later version.
+ *
+ * Copyright (C) 2026 Alexandre Cassen, <acassen@gmail.com>
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fnmatch.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+
+#include "query_socket.h"
+#include "align.h"
+#include "list_head.h"
+#include "logger.h"
+#include "memory.h"
+#include "scheduler.h"
+#include "utils.h"
+
+/* A client that does not send its request, or take the output, in
+ * time is disconnected */
+#define QUERY_CLIENT_TIMEOUT	(5 * TIMER_HZ)
+#define QUERY_MAX_REQUEST	256
+
+/* HTTP request headers are read and discarded, up to this size */
+#define QUERY_HTTP_MAX_HEAD	8192
+
+/* The HTTP response header is written into this space ahead of the
+ * body, so that the response can be sent from a single buffer */
+#define QUERY_HTTP_HEAD_ROOM	192
+#define QUERY_HTTP_CONTENT_TYPE	"application/openmetrics-text; version=1.0.0; charset=utf-8"
+
+#define QUERY_HASH_OFFSET	0xcbf29ce484222325ULL
+#define QUERY_HASH_PRIME	0x100000001b3ULL
+
+struct _query_socket {
+	int			fd;
+	const char		*name;		/* for logging */
+	const char		*path;		/* unix socket path, or NULL */
+	query_func_t		func;
+	query_mode_t		mode;
+	query_buf_t		out;		/* QUERY_HTTP output, reused */
+	thread_ref_t		thread;
+	list_head_t		clients;	/* query_client_t */
+};
+
+typedef struct _query_client {
+	query_socket_t		*qs;
+	int			fd;
+	thread_ref_t		thread;
+	char			req[QUERY_MAX_REQUEST];
+	size_t			req_len;
+	size_t			head_len;	/* HTTP request bytes read */
+	unsigned		http_status;	/* 0 until the request line is read */
+	bool			http_head;	/* HEAD request */
+	bool			http_headers;	/* headers follow the request line */
+	query_buf_t		out;
+	size_t			sent;
+	list_head_t		e_list;
+} query_client_t;
+
+/* Sequence numbers given to lines of objects when a change is seen */
+static uint64_t query_seq;
+
+static void query_client_write_thread(thread_ref_t);
+static void query_client_read_thread(thread_ref_t);
+
+static void
+query_reserve(query_buf_t *b, size_t n)
+{
+	size_t size;
+
+	if (b->len + n <= b->size)
+		return;
+
+	for (size = b->size ? b->size * 2 : 4096; size < b->len + n; size *= 2);
+	b->buf = REALLOC(b->buf, size);
+	b->size = size;
+}
+
+void
+query_write(query_buf_t *b, const char *data, size_t len)
+{
+	query_reserve(b, len + 1);
+	memcpy(b->buf + b->len, data, len);
+	b->len += len;
+}
+
+void
+query_printf(query_buf_t *b, const char *fmt, ...)
+{
+	va_list args;
+	int n;
+
+	if (!b->size)
+		query_reserve(b, 1);
+
+	va_start(args, fmt);
+	n = vsnprintf(b->buf + b->len, b->size - b->len, fmt, args);
+	va_end(args);
+
+	if (n < 0)
+		return;
+
+	if ((size_t)n >= b->size - b->len) {
+		query_reserve(b, (size_t)n + 1);
+		va_start(args, fmt);
+		vsnprintf(b->buf + b->len, b->size - b->len, fmt, args);
+		va_end(args);
+	}
+
+	b->len += (size_t)n;
+}
+
+bool
+query_match(const query_req_t *req, const char *name)
+{
+	return !req->pattern || !fnmatch(req->pattern, name, 0);
+}
+
+/* Called after an object has been written to b from offset start, one
+ * "key value" line per field, the first line naming the object. The
+ * object is kept if the request is not for changes. Otherwise only the
+ * lines whose value has changed since the cursor are kept, preceded by
+ * the first line, and the object is dropped if none has. A line is seen
+ * to have changed by comparing a hash of it with that seen last time;
+ * all the lines of an object not seen before are reported. */
+bool
+query_object_end(query_buf_t *b, size_t start, query_track_t *track, const query_req_t *req)
+{
+	query_line_t *line;
+	const char *eol;
+	uint64_t hash;
+	size_t pos, end, out, c;
+	unsigned num_lines = 0;
+	unsigned i;
+	bool changed = false;
+
+	for (pos = start; pos < b->len; pos = end) {
+		eol = memchr(b->buf + pos, '\n', b->len - pos);
+		end = eol ? (size_t)(eol - b->buf) + 1 : b->len;
+		num_lines++;
+	}
+
+	/* The fields of an object only change on a reload, when the object
+	 * is new, but if they do, treat every line as changed */
+	if (num_lines != track->num_lines) {
+		FREE_PTR(track->lines);
+		track->lines = num_lines ? MALLOC(num_lines * sizeof(*track->lines)) : NULL;
+		track->num_lines = num_lines;
+	}
+
+	for (pos = out = start, i = 0; pos < b->len; pos = end, i++) {
+		eol = memchr(b->buf + pos, '\n', b->len - pos);
+		end = eol ? (size_t)(eol - b->buf) + 1 : b->len;
+
+		hash = QUERY_HASH_OFFSET;
+		for (c = pos; c < end; c++) {
+			hash ^= (unsigned char)b->buf[c];
+			hash *= QUERY_HASH_PRIME;
+		}
+
+		line = &track->lines[i];
+		if (!line->seq || line->hash != hash) {
+			line->hash = hash;
+			line->seq = ++query_seq;
+		}
+
+		if (req->cmd == QUERY_CHANGED) {
+			if (line->seq > req->cursor)
+				changed = true;
+			else if (i)
+				continue;
+		}
+
+		/* Keep the line, moving it down over any dropped before it */
+		if (out != pos)
+			memmove(b->buf + out, b->buf + pos, end - pos);
+		out += end - pos;
+	}
+
+	if (req->cmd == QUERY_CHANGED && !changed) {
+		b->len = start;
+		return false;
+	}
+
+	b->len = out;
+	query_printf(b, "\n");
+
+	return true;
+}
+
+void
+free_query_track(query_track_t *track)
+{
+	FREE_PTR(track->lines);
+	track->num_lines = 0;
+}
+
+/* Split the next word from *line, and skip the spaces following it */
+static char *
+query_next_word(char **line)
+{
+	char *word = *line;
+	char *end = word + strcspn(word, " \t");
+
+	*line = end + strspn(end, " \t");
+	*end = '\0';
+
+	return *word ? word : NULL;
+}
+
+/* Requests are:
+ *   list [PATTERN]
+ *   get [PATTERN]
+ *   changed CURSOR [PATTERN]
+ * where PATTERN is the rest of the line. The output of get and changed
+ * ends with the cursor to use for the next changed request. */
+static void
+query_run_request(query_socket_t *qs, char *line, query_buf_t *out)
+{
+	query_req_t req = { .pattern = NULL, .cursor = 0 };
+	char *cmd, *arg, *end;
+
+	line[strcspn(line, "\r\n")] = '\0';
+	line += strspn(line, " \t");
+	cmd = query_next_word(&line);
+
+	if (!cmd) {
+		query_printf(out, "error empty request\n");
+		return;
+	}
+
+	if (!strcmp(cmd, "list"))
+		req.cmd = QUERY_LIST;
+	else if (!strcmp(cmd, "get"))
+		req.cmd = QUERY_GET;
+	else if (!strcmp(cmd, "changed")) {
+		req.cmd = QUERY_CHANGED;
+		if (!(arg = query_next_word(&line))) {
+			query_printf(out, "error changed requires a cursor\n");
+			return;
+		}
+		errno = 0;
+		req.cursor = strtoull(arg, &end, 10);
+		if (errno || *end) {
+			query_printf(out, "error invalid cursor %s\n", arg);
+			return;
+		}
+	} else {
+		query_printf(out, "error unknown request %s\n", cmd);
+		return;
+	}
+
+	/* Trailing spaces are not part of the pattern */
+	for (end = line + strlen(line); end > line && (end[-1] == ' ' || end[-1] == '\t'); end--);
+	*end = '\0';
+	if (*line)
+		req.pattern = line;
+
+	(*qs->func)(out, &req);
+
+	if (req.cmd != QUERY_LIST)
+		query_printf(out, "cursor %" PRIu64 "\n", query_seq);
+}
+
+static void
+query_client_free(query_client_t *client)
+{
+	list_del_init(&client->e_list);
+	if (client->fd != -1)
+		close(client->fd);
+	FREE_PTR(client->out.buf);
+	FREE(client);
+}
+
+/* Send as much of the output as the socket will take. Returns true
+ * when it has all been sent, or the client has gone. */
+static bool
+query_send(int fd, const char *buf, size_t len, size_t *sent)
+{
+	ssize_t ret;
+
+	while (*sent < len) {
+		ret = send(fd, buf + *sent, len - *sent, MSG_NOSIGNAL);
+		if (ret == -1) {
+			if (errno == EINTR)
+				continue;
+			if (!check_EAGAIN(errno))
+				*sent = len;
+			break;
+		}
+		*sent += (size_t)ret;
+	}
+
+	return *sent == len;
+}
+
+/* thread is the client's thread that has just run, if any */
+static void
+query_client_send(query_client_t *client, thread_ref_t thread)
+{
+	if (query_send(client->fd, client->out.buf, client->out.len, &client->sent)) {
+		if (thread) {
+			thread_close_fd(thread);
+			client->fd = -1;
+		}
+		query_client_free(client);
+		return;
+	}
+
+	client->thread = thread_add_write(master, query_client_write_thread, client, client->fd, QUERY_CLIENT_TIMEOUT, 0);
+}
+
+static void
+query_client_write_thread(thread_ref_t thread)
+{
+	query_client_t *client = THREAD_ARG(thread);
+
+	if (thread->type != THREAD_READY_WRITE_FD) {
+		thread_close_fd(thread);
+		client->fd = -1;
+		query_client_free(client);
+		return;
+	}
+
+	query_client_send(client, thread);
+}
+
+/* Keep the part of a shared output that a client could not take at once */
+static void
+query_client_keep(query_client_t *client, const char *buf, size_t len)
+{
+	client->out.len = client->out.size = len;
+	client->out.buf = MALLOC(len);
+	memcpy(client->out.buf, buf, len);
+}
+
+static const char *
+query_http_reason(unsigned status)
+{
+	switch (status) {
+	case 200:
+		return "OK";
+	case 400:
+		return "Bad Request";
+	case 404:
+		return "Not Found";
+	case 405:
+		return "Method Not Allowed";
+	case 414:
+		return "URI Too Long";
+	case 431:
+		return "Request Header Fields Too Large";
+	}
+
+	return "Error";
+}
+
+/* Requests are "METHOD TARGET [VERSION]". GET and HEAD of / or /metrics
+ * are served, and any query string is ignored. */
+static void
+query_http_request_line(query_client_t *client, char *line)
+{
+	char *method, *target;
+
+	line[strcspn(line, "\r")] = '\0';
+	line += strspn(line, " \t");
+	method = query_next_word(&line);
+	target = query_next_word(&line);
+	client->http_headers = !!query_next_word(&line);
+
+	if (!method || !target)
+		client->http_status = 400;
+	else if (strcmp(method, "GET") && !(client->http_head = !strcmp(method, "HEAD")))
+		client->http_status = 405;
+	else {
+		target[strcspn(target, "?")] = '\0';
+		client->http_status = strcmp(target, "/metrics") && strcmp(target, "/") ? 404 : 200;
+	}
+}
+
+/* Returns true once the request line and headers have been read. The
+ * headers are not used, so only enough of them is kept to find the
+ * blank line that ends them. */
+static bool
+query_http_read(query_client_t *client, bool eof)
+{
+	char *eol;
+
+	if (!client->http_status) {
+		eol = strchr(client->req, '\n');
+		if (!eol && !eof) {
+			if (client->req_len < sizeof(client->req) - 1)
+				return false;
+			client->http_status = 414;
+			return true;
+		}
+
+		if (eol)
+			*eol = '\0';
+		query_http_request_line(client, client->req);
+		if (!eol || !client->http_headers)
+			return true;
+
+		/* The newline may start the blank line ending the headers */
+		client->req_len -= (size_t)(eol - client->req);
+		memmove(client->req, eol, client->req_len + 1);
+		client->req[0] = '\n';
+	}
+
+	if (eof || strstr(client->req, "\n\n") || strstr(client->req, "\n\r\n"))
+		return true;
+
+	if (client->head_len > QUERY_HTTP_MAX_HEAD) {
+		client->http_status = 431;
+		return true;
+	}
+
+	if (client->req_len > 2) {
+		memmove(client->req, client->req + client->req_len - 2, 3);
+		client->req_len = 2;
+	}
+
+	return false;
+}
+
+/* The response is built in the socket's buffer, which is kept between
+ * requests so that its size settles, and only what the client cannot
+ * take at once is copied */
+static void
+query_http_respond(query_client_t *client, thread_ref_t thread)
+{
+	query_socket_t *qs = client->qs;
+	query_buf_t *b = &qs->out;
+	char head[QUERY_HTTP_HEAD_ROOM];
+	size_t start, sent = 0;
+	int n;
+
+	b->len = 0;
+	query_reserve(b, QUERY_HTTP_HEAD_ROOM);
+	b->len = QUERY_HTTP_HEAD_ROOM;
+
+	if (client->http_status == 200)
+		(*qs->func)(b, NULL);
+	else
+		query_printf(b, "%s\n", query_http_reason(client->http_status));
+
+	n = snprintf(head, sizeof(head), "HTTP/1.0 %u %s\r\n"
+					 "Content-Type: %s\r\n"
+					 "Content-Length: %zu\r\n"
+					 "Connection: close\r\n\r\n",
+		     client->http_status, query_http_reason(client->http_status),
+		     client->http_status == 200 ? QUERY_HTTP_CONTENT_TYPE : "text/plain",
+		     b->len - QUERY_HTTP_HEAD_ROOM);
+	start = QUERY_HTTP_HEAD_ROOM - (size_t)n;
+	memcpy(b->buf + start, head, (size_t)n);
+
+	if (client->http_head)
+		b->len = QUERY_HTTP_HEAD_ROOM;
+
+	if (!query_send(client->fd, b->buf + start, b->len - start, &sent))
+		query_client_keep(client, b->buf + start + sent, b->len - start - sent);
+
+	query_client_send(client, thread);
+}
+
+static void
+query_client_read_thread(thread_ref_t thread)
+{
+	query_client_t *client = THREAD_ARG(thread);
+	char *eol;
+	ssize_t len;
+
+	if (thread->type == THREAD_READY_READ_FD) {
+		len = read(client->fd, client->req + client->req_len, sizeof(client->req) - 1 - client->req_len);
+		if (len == -1 && (check_EAGAIN(errno) || errno == EINTR)) {
+			client->thread = thread_add_read(master, query_client_read_thread, client, client->fd, QUERY_CLIENT_TIMEOUT, 0);
+			return;
+		}
+	} else
+		len = -1;
+
+	/* A request not ended by a newline is accepted at end of file */
+	if (len < 0 || (!len && !client->req_len)) {
+		thread_close_fd(thread);
+		client->fd = -1;
+		query_client_free(client);
+		return;
+	}
+
+	if (len > 0) {
+		client->req_len += (size_t)len;
+		client->head_len += (size_t)len;
+	}
+	client->req[client->req_len] = '\0';
+
+	if (client->qs->mode == QUERY_HTTP) {
+		if (!query_http_read(client, !len)) {
+			client->thread = thread_add_read(master, query_client_read_thread, client, client->fd, QUERY_CLIENT_TIMEOUT, 0);
+			return;
+		}
+
+		thread_del_read(thread);
+		query_http_respond(client, thread);
+		return;
+	}
+
+	/* Wait for the rest of the line unless the client has stopped sending */
+	if (!(eol = strchr(client->req, '\n')) && len > 0) {
+		if (client->req_len < sizeof(client->req) - 1) {
+			client->thread = thread_add_read(master, query_client_read_thread, client, client->fd, QUERY_CLIENT_TIMEOUT, 0);
+			return;
+		}
+		query_printf(&client->out, "error request too long\n");
+	} else {
+		if (eol)
+			*eol = '\0';
+		query_run_request(client->qs, client->req, &client->out);
+	}
+
+	/* Only one request is served per connection */
+	thread_del_read(thread);
+	query_client_send(client, thread);
+}
+
+static query_client_t *
+query_client_new(query_socket_t *qs, int fd)
+{
+	query_client_t *client;
+
+	PMALLOC(client);
+	INIT_LIST_HEAD(&client->e_list);
+	client->qs = qs;
+	client->fd = fd;
+	list_add_tail(&client->e_list, &qs->clients);
+
+	return client;
+}
+
+/* For a dump socket, the connections accepted in the same wakeup share
+ * one snapshot, and only those that cannot take it all at once get a
+ * copy of the rest of it. */
+static void
+query_accept_thread(thread_ref_t thread)
+{
+	query_socket_t *qs = THREAD_ARG(thread);
+	query_client_t *client;
+	query_buf_t dump = { .buf = NULL, .len = 0, .size = 0 };
+	size_t sent;
+	int fd;
+
+	while ((fd = accept4(qs->fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+		if (qs->mode != QUERY_DUMP) {
+			client = query_client_new(qs, fd);
+			client->thread = thread_add_read(master, query_client_read_thread, client, fd, QUERY_CLIENT_TIMEOUT, 0);
+			continue;
+		}
+
+		if (!dump.buf)
+			(*qs->func)(&dump, NULL);
+
+		sent = 0;
+		if (query_send(fd, dump.buf, dump.len, &sent)) {
+			close(fd);
+			continue;
+		}
+
+		client = query_client_new(qs, fd);
+		query_client_keep(client, dump.buf + sent, dump.len - sent);
+		client->thread = thread_add_write(master, query_client_write_thread, client, fd, QUERY_CLIENT_TIMEOUT, 0);
+	}
+
+	if (!check_EAGAIN(errno) && errno != EINTR && errno != ECONNABORTED)
+		log_message(LOG_INFO, "Query socket %s accept failed - %m", qs->name);
+
+	FREE_PTR(dump.buf);
+
+	qs->thread = thread_add_read(master, query_accept_thread, qs, qs->fd, TIMER_NEVER, 0);
+}
+
+static query_socket_t *
+query_socket_new(int fd, const char *name, bool is_path, query_func_t func, query_mode_t mode)
+{
+	query_socket_t *qs;
+
+	PMALLOC(qs);
+	qs->fd = fd;
+	qs->name = STRDUP(name);
+	qs->path = is_path ? qs->name : NULL;
+	qs->func = func;
+	qs->mode = mode;
+	INIT_LIST_HEAD(&qs->clients);
+	qs->thread = thread_add_read(master, query_accept_thread, qs, fd, TIMER_NEVER, 0);
+
+	return qs;
+}
+
+query_socket_t *
+open_query_socket(const char *path, query_func_t func, query_mode_t mode)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	struct stat st;
+	int fd;
+
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		log_message(LOG_INFO, "Query socket path %s is too long", path);
+		return NULL;
+	}
+	strcpy(addr.sun_path, path);
+
+	/* Remove a stale socket left by a previous instance */
+	if (!lstat(path, &st) && S_ISSOCK(st.st_mode))
+		unlink(path);
+
+	if ((fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) == -1) {
+		log_message(LOG_INFO, "Unable to create query socket %s - %m", path);
+		return NULL;
+	}
+
+	if (bind(fd, PTR_CAST(struct sockaddr, &addr), sizeof(addr)) ||
+	    chmod(path, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP) ||
+	    listen(fd, SOMAXCONN)) {
+		log_message(LOG_INFO, "Unable to listen on query socket %s - %m", path);
+		close(fd);
+		return NULL;
+	}
+
+	return query_socket_new(fd, path, true, func, mode);
+}
+
+/* The port is only bound on the loopback address */
+query_socket_t *
+open_query_socket_port(uint16_t port, query_func_t func, query_mode_t mode)
+{
+	struct sockaddr_in addr = { .sin_family = AF_INET };
+	char name[sizeof("127.0.0.1:65535")];
+	int fd;
+	int on = 1;
+
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(port);
+	snprintf(name, sizeof(name), "127.0.0.1:%u", port);
+
+	if ((fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) == -1) {
+		log_message(LOG_INFO, "Unable to create query socket %s - %m", name);
+		return NULL;
+	}
+
+	/* Connections we have closed may still be in TIME_WAIT after a reload */
+	if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) ||
+	    bind(fd, PTR_CAST(struct sockaddr, &addr), sizeof(addr)) ||
+	    listen(fd, SOMAXCONN)) {
+		log_message(LOG_INFO, "Unable to listen on query socket %s - %m", name);
+		close(fd);
+		return NULL;
+	}
+
+	return query_socket_new(fd, name, false, func, mode);
+}
+
+/* Must be called before the threads are cleaned up on reload or exit */
+void
+close_query_socket(query_socket_t **qsp)
+{
+	query_socket_t *qs = *qsp;
+	query_client_t *client, *client_tmp;
+
+	if (!qs)
+		return;
+
+	list_for_each_entry_safe(client, client_tmp, &qs->clients, e_list) {
+		thread_cancel(client->thread);
+		query_client_free(client);
+	}
+
+	thread_cancel(qs->thread);
+	close(qs->fd);
+	if (qs->path)
+		unlink(qs->path);
+	FREE_CONST(qs->name);
+	FREE_PTR(qs->out.buf);
+	FREE(qs);
+
+	*qsp = NULL;
+}
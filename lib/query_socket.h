@@ -0,0 +1,89 @@
+/*
+ * Soft:        Keepalived is a failover program for the LVS project
+ *              <www.linuxvirtualserver.org>. It monitor & manipulate
+ *              a loadbalanced server pool using multi-layer checks.
+ *
+ * Part:        query_socket.c include file.
+ *
+ * Author:      Alexandre Cassen, <acassen@linux-vs.org>
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *              See the GNU General Public License for more details.
+ *
+ *              This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU General Public License
+ *              as published by the Free Software Foundation; either version
+ *              2 of the License, or (at your option) any later version.
+ *
+ * Copyright (C) 2026 Alexandre Cassen, <acassen@gmail.com>
+ */
+
+#ifndef _QUERY_SOCKET_H
+#define _QUERY_SOCKET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Output built for a client */
+typedef struct _query_buf {
+	char			*buf;
+	size_t			len;
+	size_t			size;
+} query_buf_t;
+
+typedef enum {
+	QUERY_DUMP,		/* output is written as soon as a client connects */
+	QUERY_REQUEST,		/* client sends one request line */
+	QUERY_HTTP,		/* client sends an HTTP GET, output is OpenMetrics text */
+} query_mode_t;
+
+typedef enum {
+	QUERY_LIST,		/* names of the matching objects */
+	QUERY_GET,		/* matching objects */
+	QUERY_CHANGED,		/* matching objects changed since cursor */
+} query_cmd_t;
+
+typedef struct _query_req {
+	query_cmd_t		cmd;
+	const char		*pattern;	/* fnmatch() pattern, NULL for all */
+	uint64_t		cursor;
+} query_req_t;
+
+/* The last value seen of a line of an object's output */
+typedef struct _query_line {
+	uint64_t		hash;
+	uint64_t		seq;		/* when the value last changed */
+} query_line_t;
+
+/* Detects which lines of an object's output have changed since a
+ * cursor. Zero initialised when the object is allocated, and released
+ * with free_query_track(). */
+typedef struct _query_track {
+	query_line_t		*lines;
+	unsigned		num_lines;
+} query_track_t;
+
+/* Builds the output for a request. The functions of QUERY_DUMP and
+ * QUERY_HTTP sockets are passed NULL. A QUERY_DUMP socket's function may
+ * replace the empty buffer with its own MALLOC'd one; a QUERY_HTTP
+ * socket's function must append to the buffer, which is kept between
+ * requests. */
+typedef void (*query_func_t)(query_buf_t *, const query_req_t *);
+
+typedef struct _query_socket query_socket_t;
+
+/* Prototypes */
+extern query_socket_t *open_query_socket(const char *, query_func_t, query_mode_t);
+extern query_socket_t *open_query_socket_port(uint16_t, query_func_t, query_mode_t);
+extern void close_query_socket(query_socket_t **);
+extern void query_write(query_buf_t *, const char *, size_t);
+extern void query_printf(query_buf_t *, const char *, ...)
+	__attribute__ ((format (printf, 2, 3)));
+extern bool query_match(const query_req_t *, const char *) __attribute__ ((pure));
+extern bool query_object_end(query_buf_t *, size_t, query_track_t *, const query_req_t *);
+extern void free_query_track(query_track_t *);
+
+#endif
@@ -33,6 +33,8 @@
 #endif
 
 #include <errno.h>
+#include <string.h>
+#include <limits.h>
 #include <sys/wait.h>
 #include <sys/timerfd.h>
 #include <sys/epoll.h>
@@ -57,6 +59,7 @@
 #include "align.h"
 #include "systemd.h"
 #include "decimal_chars.h"
+#include "metrics.h"
 
 
 #ifdef THREAD_DUMP
@@ -68,7 +71,7 @@ typedef struct _func_det {
 #endif
 
 /* global vars */
-thread_master_t *master = NULL;
+__thread thread_master_t *master = NULL;	/* master of the current thread */
 #ifndef _ONE_PROCESS_DEBUG_
 prog_type_t prog_type;		/* Parent/VRRP/Checker process */
 #endif
@@ -91,7 +94,7 @@ const char *config_opts = "not read";
 #endif
 
 /* local variables */
-static bool shutting_down;
+static __thread bool shutting_down;
 static int sav_argc;
 static char * const *sav_argv;
 #ifdef THREAD_DUMP
@@ -228,6 +231,117 @@ deregister_thread_addresses(void)
 }
 #endif
 
+static inline unsigned
+thread_hist_bucket(unsigned long val)
+{
+	unsigned bucket;
+
+	if (!val)
+		return 0;
+
+	bucket = (unsigned)(sizeof(val) * CHAR_BIT) - (unsigned)__builtin_clzl(val);
+
+	return bucket < THREAD_HIST_BUCKETS ? bucket : THREAD_HIST_BUCKETS - 1;
+}
+
+static inline int
+func_stats_cmp(const void *func, const struct rb_node *a)
+{
+	if (func < (void *)rb_entry_const(a, thread_func_stats_t, n)->func)
+		return -1;
+	if (func > (void *)rb_entry_const(a, thread_func_stats_t, n)->func)
+		return 1;
+	return 0;
+}
+
+static inline bool
+func_stats_less(struct rb_node *a, const struct rb_node *b)
+{
+RELAX_ORDERED_COMPARE_FUNCTION_POINTERS_START
+	return (rb_entry_const(a, thread_func_stats_t, n)->func < rb_entry_const(b, thread_func_stats_t, n)->func);
+RELAX_ORDERED_COMPARE_FUNCTION_POINTERS_END
+}
+
+static thread_func_stats_t *
+thread_func_stats_get(thread_master_t *m, thread_func_t func)
+{
+	thread_func_stats_t *stats;
+	rb_node_t *node;
+
+	if ((node = rb_find((void *)func, &m->func_stats, func_stats_cmp)))
+		return rb_entry(node, thread_func_stats_t, n);
+
+	PMALLOC(stats);
+	stats->func = func;
+	rb_add(&stats->n, &m->func_stats, func_stats_less);
+
+	return stats;
+}
+
+static void
+thread_func_stats_destroy(thread_master_t *m)
+{
+	thread_func_stats_t *stats, *stats_tmp;
+
+	rbtree_postorder_for_each_entry_safe(stats, stats_tmp, &m->func_stats, n)
+		FREE(stats);
+
+	m->func_stats = RB_ROOT;
+}
+
+static const char *
+thread_func_name(thread_func_t func)
+{
+#ifdef THREAD_DUMP
+	return get_function_name(func);
+#else
+	static char address[19];
+
+	snprintf(address, sizeof address, "%p", func);
+	return address;
+#endif
+}
+
+/* Format the non-empty buckets of a histogram as "<2^n:count" */
+static const char *
+thread_hist_str(const unsigned long *hist, char *buf, size_t len)
+{
+	unsigned i;
+	size_t pos = 0;
+	int ret;
+
+	buf[0] = '\0';
+	for (i = 0; i < THREAD_HIST_BUCKETS && pos < len; i++) {
+		if (!hist[i])
+			continue;
+
+		if (!i)
+			ret = snprintf(buf + pos, len - pos, " 0:%lu", hist[i]);
+		else if (i == THREAD_HIST_BUCKETS - 1)
+			ret = snprintf(buf + pos, len - pos, " >=%lu:%lu", 1UL << (i - 1), hist[i]);
+		else
+			ret = snprintf(buf + pos, len - pos, " <%lu:%lu", 1UL << i, hist[i]);
+
+		if (ret < 0)
+			break;
+		pos += (size_t)ret;
+	}
+
+	return buf;
+}
+
+static void
+thread_json_hist(json_writer_t *wr, const char *name, const unsigned long *hist)
+{
+	unsigned i;
+
+	jsonw_name(wr, name);
+	jsonw_start_array(wr);
+	for (i = 0; i < THREAD_HIST_BUCKETS; i++)
+		jsonw_uint(wr, hist[i]);
+	jsonw_end_array(wr);
+}
+
 #ifdef _VRRP_FD_DEBUG_
 void
 set_extra_threads_debug(void (*func)(void))
@@ -252,13 +366,30 @@ register_shutdown_function(void (*func)(int))
 }
 #endif
 
+/* If budgets are set, ready read and write threads go onto their own
+ * queues, unless flagged THREAD_PRIORITY, so that timers, timeouts and
+ * priority fds are always run first and a busy fd can't starve them. */
+static list_head_t *
+thread_ready_queue(thread_master_t *m, const thread_t *thread, int type)
+{
+	if (type == THREAD_READY_READ_FD || type == THREAD_READ_ERROR) {
+		if (m->read_budget && !(thread->u.f.flags & THREAD_PRIORITY))
+			return &m->ready_read;
+	} else if (type == THREAD_READY_WRITE_FD || type == THREAD_WRITE_ERROR) {
+		if (m->write_budget && !(thread->u.f.flags & THREAD_PRIORITY))
+			return &m->ready_write;
+	}
+
+	return &m->ready;
+}
+
 /* Move ready thread into ready queue */
 static void
 thread_move_ready(thread_master_t *m, rb_root_cached_t *root, thread_t *thread, int type)
 {
 	rb_erase_cached(&thread->n, root);
 	INIT_LIST_HEAD(&thread->e_list);
-	list_add_tail(&thread->e_list, &m->ready);
+	list_add_tail(&thread->e_list, thread_ready_queue(m, thread, type));
 	if (thread->type != THREAD_TIMER_SHUTDOWN)
 		thread->type = type;
 }
@@ -285,6 +416,46 @@ thread_rb_move_ready(thread_master_t *m, rb_root_cached_t *root, int type)
 	}
 }
 
+#ifdef _WITH_TIMER_WHEEL_
+static const timeval_t *
+thread_timer_sands(const list_head_t *e)
+{
+	return &container_of_const(e, thread_t, e_list)->sands;
+}
+
+/* Move expired timer threads into ready queue */
+static void
+thread_timer_move_ready(thread_master_t *m)
+{
+	thread_t *thread, *thread_tmp;
+	list_head_t expired;
+
+	INIT_LIST_HEAD(&expired);
+	if (!timer_wheel_expire(&m->timer, &time_now, &expired))
+		return;
+
+	list_for_each_entry_safe(thread, thread_tmp, &expired, e_list) {
+		if (thread->type != THREAD_TIMER_SHUTDOWN)
+			thread->type = THREAD_READY_TIMER;
+		list_move_tail(&thread->e_list, &m->ready);
+	}
+}
+
+/* Update timer value from the timing wheel */
+static void
+thread_update_timer_wheel(timer_wheel_t *w, timeval_t *timer_min)
+{
+	timeval_t expiry;
+
+	if (!timer_wheel_next_expiry(w, &expiry))
+		return;
+
+	if (!timerisset(timer_min) ||
+	    timercmp(&expiry, timer_min, <=))
+		*timer_min = expiry;
+}
+#endif
+
 /* Update timer value */
 static void
 thread_update_timer(rb_root_cached_t *root, timeval_t *timer_min)
@@ -305,20 +476,82 @@ thread_update_timer(rb_root_cached_t *root, timeval_t *timer_min)
 		*timer_min = first->sands;
 }
 
+/* Find the latest timer due no later than limit, counting the number
+ * of separate expiry times after the earliest one */
+static void
+thread_coalesce_timer(const rb_root_cached_t *root, const timeval_t *earliest, const timeval_t *limit, timeval_t *latest, unsigned *merged)
+{
+	const thread_t *thread;
+	const rb_node_t *node;
+	timeval_t prev = *earliest;
+
+	for (node = rb_first_cached(root); node; node = rb_next(node)) {
+		thread = rb_entry_const(node, thread_t, n);
+
+		if (thread->sands.tv_sec == TIMER_DISABLED ||
+		    timercmp(&thread->sands, limit, >))
+			break;
+
+		if (timercmp(&thread->sands, &prev, >)) {
+			(*merged)++;
+			prev = thread->sands;
+		}
+
+		if (timercmp(&thread->sands, latest, >))
+			*latest = thread->sands;
+	}
+}
+
 /* Compute the wait timer. Take care of timeouted fd */
 static timeval_t
 thread_set_timer(thread_master_t *m)
 {
 	timeval_t timer_wait, timer_wait_time;
 	struct itimerspec its;
+	unsigned merged = 0;
 
 	/* Prepare timer */
 	timerclear(&timer_wait_time);
+#ifdef _WITH_TIMER_WHEEL_
+	thread_update_timer_wheel(&m->timer, &timer_wait_time);
+#else
 	thread_update_timer(&m->timer, &timer_wait_time);
+#endif
 	thread_update_timer(&m->write, &timer_wait_time);
 	thread_update_timer(&m->read, &timer_wait_time);
 	thread_update_timer(&m->child, &timer_wait_time);
 
+	/* Delay the expiry to the last timer due within the coalescing window
+	 * of the earliest, so that they are all run from one wakeup */
+	if (m->timer_coalesce && timerisset(&timer_wait_time)) {
+		timeval_t limit = timer_add_long(timer_wait_time, m->timer_coalesce);
+		timeval_t latest = timer_wait_time;
+
+#ifdef _WITH_TIMER_WHEEL_
+		merged += timer_wheel_coalesce(&m->timer, &timer_wait_time, &limit, &latest);
+#else
+		thread_coalesce_timer(&m->timer, &timer_wait_time, &limit, &latest, &merged);
+#endif
+		thread_coalesce_timer(&m->write, &timer_wait_time, &limit, &latest, &merged);
+		thread_coalesce_timer(&m->read, &timer_wait_time, &limit, &latest, &merged);
+		thread_coalesce_timer(&m->child, &timer_wait_time, &limit, &latest, &merged);
+		timer_wait_time = latest;
+	}
+
+	/* Expire on a multiple of the slack, so that timers due within the
+	 * same slack interval share one wakeup */
+	if (m->timer_slack && timerisset(&timer_wait_time))
+		timer_wait_time = timer_round_up(timer_wait_time, m->timer_slack);
+
+	/* If the earliest timer hasn't changed, timer_fd is already set for it.
+	 * thread_timerfd_handler() clears timer_fd_sands when timer_fd expires,
+	 * since a timer that was due may not have been removed from its queue
+	 * if time_now was read just before it. */
+	if (timercmp(&timer_wait_time, &m->timer_fd_sands, ==))
+		return timer_wait_time;
+	m->timer_fd_sands = timer_wait_time;
+	m->timer_fd_merged = merged;
+
 	if (timerisset(&timer_wait_time)) {
 		/* Re-read the current time to get the maximum accuracy */
 		set_time_now();
@@ -360,6 +593,21 @@ thread_set_timer(thread_master_t *m)
 	return timer_wait_time;
 }
 
+/* Move all expired timer and timeout threads into the ready queue */
+static void
+thread_move_expired(thread_master_t *m)
+{
+	/* Read, Write, Timer, Child thread. */
+	thread_rb_move_ready(m, &m->read, THREAD_READ_TIMEOUT);
+	thread_rb_move_ready(m, &m->write, THREAD_WRITE_TIMEOUT);
+#ifdef _WITH_TIMER_WHEEL_
+	thread_timer_move_ready(m);
+#else
+	thread_rb_move_ready(m, &m->timer, THREAD_READY_TIMER);
+#endif
+	thread_rb_move_ready(m, &m->child, THREAD_CHILD_TIMEOUT);
+}
+
 static void
 thread_timerfd_handler(thread_ref_t thread)
 {
@@ -371,14 +619,15 @@ thread_timerfd_handler(thread_ref_t thread)
 	if (len < 0)
 		log_message(LOG_ERR, "scheduler: Error reading on timerfd fd:%d (%m)", m->timer_fd);
 
-	/* Read, Write, Timer, Child thread. */
-	thread_rb_move_ready(m, &m->read, THREAD_READ_TIMEOUT);
-	thread_rb_move_ready(m, &m->write, THREAD_WRITE_TIMEOUT);
-	thread_rb_move_ready(m, &m->timer, THREAD_READY_TIMER);
-	thread_rb_move_ready(m, &m->child, THREAD_CHILD_TIMEOUT);
+	/* timer_fd is now disarmed, so it must be set again */
+	m->timer_fd_sands.tv_sec = -1;
+
+	m->timer_wakeups++;
+	m->timer_wakeups_saved += m->timer_fd_merged;
+	thread_move_expired(m);
 
 	/* Register next timerfd thread */
-	m->timer_thread = thread_add_read(m, thread_timerfd_handler, NULL, m->timer_fd, TIMER_NEVER, 0);
+	m->timer_thread = thread_add_read(m, thread_timerfd_handler, NULL, m->timer_fd, TIMER_NEVER, THREAD_PRIORITY);
 }
 
 /* Child PID cmp helper */
@@ -643,18 +892,30 @@ thread_events_resize(thread_master_t *m, int delta)
 	return 0;
 }
 
-static inline int
-thread_event_cmp(const void *key, const rb_node_t *a)
+/* Make sure the io_events table can be indexed by fd */
+static void
+thread_io_events_grow(thread_master_t *m, unsigned min_size)
 {
-	int fd = *PTR_CAST_CONST(int, key);
+	unsigned new_size;
+
+	if (min_size <= m->io_events_size)
+		return;
 
-	return fd - rb_entry_const(a, thread_event_t, n)->fd;
+	new_size = m->io_events_size ? m->io_events_size : THREAD_IO_EVENTS_MIN;
+	while (new_size < min_size)
+		new_size *= 2;
+
+	m->io_events = REALLOC(m->io_events, new_size * sizeof(*m->io_events));
+	memset(m->io_events + m->io_events_size, 0, (new_size - m->io_events_size) * sizeof(*m->io_events));
+	m->io_events_size = new_size;
 }
 
-static inline bool
-thread_event_less(rb_node_t *a, const rb_node_t *b)
+/* Size the io_events table for the number of fds the process expects
+ * to use, to avoid growing it in steps as fds are opened */
+void
+thread_set_max_fds(thread_master_t *m, unsigned max_fds)
 {
-	return rb_entry(a, thread_event_t, n)->fd < rb_entry_const(b, thread_event_t, n)->fd;
+	thread_io_events_grow(m, max_fds);
 }
 
 static thread_event_t *
@@ -662,56 +923,238 @@ thread_event_new(thread_master_t *m, int fd)
 {
 	thread_event_t *event;
 
-	PMALLOC(event);
-	if (!event)
+	if (fd < 0) {
+		errno = EBADF;
 		return NULL;
+	}
+
+	event = slab_alloc(&m->event_slab);
 
 	if (thread_events_resize(m, 1) < 0) {
-		FREE(event);
+		slab_free(&m->event_slab, event);
 		return NULL;
 	}
 
 	event->fd = fd;
 
-	rb_add(&event->n, &m->io_events, thread_event_less);
+	thread_io_events_grow(m, (unsigned)fd + 1);
+	m->io_events[fd] = event;
 
 	return event;
 }
 
-static thread_event_t * __attribute__ ((pure))
-thread_event_get(thread_master_t *m, int fd)
+static inline thread_event_t * __attribute__ ((pure))
+thread_event_get(const thread_master_t *m, int fd)
 {
-	rb_node_t *node;
+	if (fd < 0 || (unsigned)fd >= m->io_events_size)
+		return NULL;
 
-	node = rb_find(&fd, &m->io_events, thread_event_cmp);
+	return m->io_events[fd];
+}
 
-	if (!node)
-		return NULL;
-	return rb_entry(node, thread_event_t, n);
+static inline uint32_t
+thread_event_mask(const thread_event_t *event)
+{
+	uint32_t events = 0;
+
+	if (__test_bit(THREAD_FL_READ_BIT, &event->flags))
+		events |= EPOLLIN;
+
+	if (__test_bit(THREAD_FL_WRITE_BIT, &event->flags))
+		events |= EPOLLOUT;
+
+	return events;
 }
 
+/* Apply an epoll change. If the fd was closed and reopened without the
+ * thread being cancelled, the kernel will have dropped the old
+ * registration, or the new fd may already be registered, so retry with
+ * the other op. */
 static int
-thread_event_set(const thread_t *thread)
+thread_epoll_ctl(thread_master_t *m, thread_event_t *event, int op)
 {
-	thread_event_t *event = thread->event;
-	thread_master_t *m = thread->master;
-	struct epoll_event ev = { .events = 0, .data.ptr = event };
+	struct epoll_event ev = { .events = thread_event_mask(event), .data.ptr = event };
+
+	m->epoll_ctl_calls++;
+	if (!epoll_ctl(m->epoll_fd, op, event->fd, &ev))
+		return 0;
+
+	if ((op == EPOLL_CTL_MOD && errno == ENOENT) ||
+	    (op == EPOLL_CTL_ADD && errno == EEXIST)) {
+		op = op == EPOLL_CTL_MOD ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+		m->epoll_ctl_calls++;
+		if (!epoll_ctl(m->epoll_fd, op, event->fd, &ev))
+			return 0;
+	}
+
+	log_message(LOG_INFO, "scheduler: Error %d performing control on EPOLL instance for fd %d (%m)", errno, event->fd);
+
+	return -1;
+}
+
+/* A queued epoll change could not be applied, so the threads waiting on
+ * the fd might never run. Make them ready as errors, as if epoll had
+ * reported an error on the fd, so that their owners see the failure. */
+static void
+thread_epoll_change_failed(thread_master_t *m, thread_event_t *event, int op)
+{
+	/* The fd is not registered, so don't try to delete it */
+	if (op == EPOLL_CTL_ADD)
+		__clear_bit(THREAD_FL_EPOLL_BIT, &event->flags);
+
+	if (event->read) {
+		thread_move_ready(m, &m->read, event->read, THREAD_READ_ERROR);
+		event->read = NULL;
+	}
+	if (event->write) {
+		thread_move_ready(m, &m->write, event->write, THREAD_WRITE_ERROR);
+		event->write = NULL;
+	}
+}
+
+#ifdef _WITH_IO_URING_
+static void
+thread_uring_init(thread_master_t *m)
+{
+	if (!uring_init(&m->uring, THREAD_URING_ENTRIES)) {
+		if (__test_bit(LOG_DETAIL_BIT, &debug))
+			log_message(LOG_INFO, "scheduler: io_uring not available (%m) - using epoll_ctl");
+		return;
+	}
+
+	if (!uring_op_supported(&m->uring, IORING_OP_EPOLL_CTL)) {
+		if (__test_bit(LOG_DETAIL_BIT, &debug))
+			log_message(LOG_INFO, "scheduler: io_uring does not support epoll_ctl - using epoll_ctl");
+		uring_exit(&m->uring);
+		return;
+	}
+
+	m->uring_epoll_events = MALLOC(m->uring.sq_entries * sizeof(*m->uring_epoll_events));
+	m->use_uring = true;
+}
+
+static void
+thread_uring_cqe(void *arg, const struct io_uring_cqe *cqe)
+{
+	thread_master_t *m = arg;
+	int fd = (int)(cqe->user_data & 0xffffffff);
+	int op = (int)(cqe->user_data >> 32);
+	thread_event_t *event;
+
+	if (cqe->res >= 0 || !(event = thread_event_get(m, fd)))
+		return;
+
+	/* See thread_epoll_ctl() */
+	if ((op == EPOLL_CTL_MOD && cqe->res == -ENOENT) ||
+	    (op == EPOLL_CTL_ADD && cqe->res == -EEXIST)) {
+		op = op == EPOLL_CTL_MOD ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+		if (!thread_epoll_ctl(m, event, op))
+			return;
+	} else
+		log_message(LOG_INFO, "scheduler: Error %d performing control on EPOLL instance for fd %d (%s)", -cqe->res, fd, strerror(-cqe->res));
+
+	thread_epoll_change_failed(m, event, op);
+}
+
+static void
+thread_uring_submit(thread_master_t *m)
+{
+	unsigned queued = m->uring.to_submit;
+
+	if (!queued)
+		return;
+
+	if (uring_submit_and_wait(&m->uring) < 0)
+		log_message(LOG_INFO, "scheduler: Error submitting to io_uring (%m)");
+
+	m->uring_submits++;
+	m->uring_epoll_ops += queued - m->uring.to_submit;
+
+	uring_reap(&m->uring, thread_uring_cqe, m);
+}
+
+/* Submit all the queued epoll changes with one system call. The epoll_event
+ * structures are copied when the sqes are submitted, so can be reused. */
+static void
+thread_uring_flush_epoll_changes(thread_master_t *m)
+{
+	thread_event_t *event, *event_tmp;
+	struct io_uring_sqe *sqe;
+	struct epoll_event *ev;
 	int op;
 
-	if (__test_bit(THREAD_FL_READ_BIT, &event->flags))
-		ev.events |= EPOLLIN;
+	list_for_each_entry_safe(event, event_tmp, &m->epoll_changes, e_list) {
+		if (!(sqe = uring_get_sqe(&m->uring))) {
+			thread_uring_submit(m);
+			if (!(sqe = uring_get_sqe(&m->uring)))
+				break;
+		}
 
-	if (__test_bit(THREAD_FL_WRITE_BIT, &event->flags))
-		ev.events |= EPOLLOUT;
+		op = __test_bit(THREAD_FL_EPOLL_ADD_BIT, &event->flags) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
 
-	if (__test_bit(THREAD_FL_EPOLL_BIT, &event->flags))
-		op = EPOLL_CTL_MOD;
-	else
-		op = EPOLL_CTL_ADD;
+		ev = &m->uring_epoll_events[m->uring.to_submit - 1];
+		ev->events = thread_event_mask(event);
+		ev->data.ptr = event;
 
-	if (epoll_ctl(m->epoll_fd, op, event->fd, &ev) < 0) {
-		log_message(LOG_INFO, "scheduler: Error %d performing control on EPOLL instance for fd %d (%m)", errno, event->fd);
-		return -1;
+		sqe->opcode = IORING_OP_EPOLL_CTL;
+		sqe->fd = m->epoll_fd;
+		sqe->len = (unsigned)op;
+		sqe->off = (unsigned)event->fd;
+		sqe->addr = (uintptr_t)ev;
+		sqe->user_data = (uint64_t)op << 32 | (unsigned)event->fd;
+
+		list_del_init(&event->e_list);
+		__clear_bit(THREAD_FL_EPOLL_CHANGE_BIT, &event->flags);
+		__clear_bit(THREAD_FL_EPOLL_ADD_BIT, &event->flags);
+	}
+
+	thread_uring_submit(m);
+}
+#endif
+
+/* Apply all the epoll changes queued since the last epoll_wait(). An fd
+ * that has had read and write threads added and removed several times
+ * only needs one epoll_ctl(), and none if its interest ends up removed. */
+static void
+thread_flush_epoll_changes(thread_master_t *m)
+{
+	thread_event_t *event, *event_tmp;
+	int op;
+
+#ifdef _WITH_IO_URING_
+	if (m->use_uring) {
+		thread_uring_flush_epoll_changes(m);
+		return;
+	}
+#endif
+
+	list_for_each_entry_safe(event, event_tmp, &m->epoll_changes, e_list) {
+		op = __test_bit(THREAD_FL_EPOLL_ADD_BIT, &event->flags) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+
+		list_del_init(&event->e_list);
+		__clear_bit(THREAD_FL_EPOLL_CHANGE_BIT, &event->flags);
+		__clear_bit(THREAD_FL_EPOLL_ADD_BIT, &event->flags);
+
+		if (thread_epoll_ctl(m, event, op))
+			thread_epoll_change_failed(m, event, op);
+	}
+}
+
+/* Queue the change to be applied before the next epoll_wait(). This
+ * cannot fail; if the change is rejected when it is applied, the threads
+ * on the fd are run with type THREAD_READ_ERROR or THREAD_WRITE_ERROR. */
+static int
+thread_event_set(const thread_t *thread)
+{
+	thread_event_t *event = thread->event;
+	thread_master_t *m = thread->master;
+
+	m->epoll_requests++;
+
+	if (!__test_and_set_bit(THREAD_FL_EPOLL_CHANGE_BIT, &event->flags)) {
+		if (!__test_bit(THREAD_FL_EPOLL_BIT, &event->flags))
+			__set_bit(THREAD_FL_EPOLL_ADD_BIT, &event->flags);
+		list_add_tail(&event->e_list, &m->epoll_changes);
 	}
 
 	__set_bit(THREAD_FL_EPOLL_BIT, &event->flags);
@@ -730,17 +1173,34 @@ thread_event_cancel(const thread_t *thread_cp)
 		return -1;
 	}
 
-	/* Ignore error if it was an SNMP fd, since we don't know
-	 * if they have been closed */
-	if (m->epoll_fd != -1 &&
-	    epoll_ctl(m->epoll_fd, EPOLL_CTL_DEL, event->fd, NULL) < 0)
-		log_message(LOG_INFO, "scheduler: Error performing epoll_ctl DEL op for fd:%d (%m)", event->fd);
+	m->epoll_requests++;
+
+	if (__test_bit(THREAD_FL_EPOLL_CHANGE_BIT, &event->flags)) {
+		list_del_init(&event->e_list);
+
+		/* If the add hasn't been applied, there is nothing to delete */
+		if (__test_bit(THREAD_FL_EPOLL_ADD_BIT, &event->flags))
+			__clear_bit(THREAD_FL_EPOLL_BIT, &event->flags);
+	}
+
+	/* The delete is not queued, since the caller is likely to close
+	 * the fd straight away, and if the fd has been dup()ed the
+	 * registration would then outlive the event. Ignore the error if
+	 * the fd has already been closed, for example an SNMP fd, since we
+	 * don't know if they have been closed. */
+	if (m->epoll_fd != -1 && __test_bit(THREAD_FL_EPOLL_BIT, &event->flags)) {
+		m->epoll_ctl_calls++;
+		if (epoll_ctl(m->epoll_fd, EPOLL_CTL_DEL, event->fd, NULL) < 0 &&
+		    errno != EBADF && errno != ENOENT)
+			log_message(LOG_INFO, "scheduler: Error performing epoll_ctl DEL op for fd:%d (%m)", event->fd);
+	}
 
-	rb_erase(&event->n, &m->io_events);
+	m->io_events[event->fd] = NULL;
 	if (event == m->current_event)
 		m->current_event = NULL;
 	thread_events_resize(m, -1);
-	FREE(thread->event);
+	slab_free(&m->event_slab, thread->event);
+	thread->event = NULL;
 	return 0;
 }
 
@@ -775,9 +1235,8 @@ thread_event_del(const thread_t *thread_cp, unsigned flag)
 	return 0;
 }
 
-/* Make thread master. */
-thread_master_t *
-thread_make_master(void)
+static thread_master_t *
+thread_new_master(bool with_signals)
 {
 	thread_master_t *new;
 
@@ -792,17 +1251,29 @@ thread_make_master(void)
 
 	new->read = RB_ROOT_CACHED;
 	new->write = RB_ROOT_CACHED;
+#ifdef _WITH_TIMER_WHEEL_
+	timer_wheel_init(&new->timer, thread_timer_sands);
+#else
 	new->timer = RB_ROOT_CACHED;
+#endif
 	new->child = RB_ROOT_CACHED;
-	new->io_events = RB_ROOT;
+	thread_io_events_grow(new, THREAD_IO_EVENTS_MIN);
 	new->child_pid = RB_ROOT;
+	new->func_stats = RB_ROOT;
+	slab_cache_init(&new->thread_slab, "thread", sizeof(thread_t), SLAB_DEFAULT_HIGH_WATER);
+	slab_cache_init(&new->event_slab, "event", sizeof(thread_event_t), SLAB_DEFAULT_HIGH_WATER);
 	INIT_LIST_HEAD(&new->event);
 #ifdef USE_SIGNAL_THREADS
 	INIT_LIST_HEAD(&new->signal);
 #endif
 	INIT_LIST_HEAD(&new->ready);
+	INIT_LIST_HEAD(&new->ready_read);
+	INIT_LIST_HEAD(&new->ready_write);
 	INIT_LIST_HEAD(&new->unuse);
-
+	INIT_LIST_HEAD(&new->epoll_changes);
+#ifdef _WITH_IO_URING_
+	thread_uring_init(new);
+#endif
 
 	/* Register timerfd thread */
 	new->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
@@ -811,16 +1282,34 @@ thread_make_master(void)
 		FREE(new);
 		return NULL;
 	}
+	new->timer_fd_sands.tv_sec = -1;	/* Force timer_fd to be set */
+	new->start_time = timer_now();
 
-	new->signal_fd = signal_handler_init();
+	new->signal_fd = with_signals ? signal_handler_init() : -1;
 
-	new->timer_thread = thread_add_read(new, thread_timerfd_handler, NULL, new->timer_fd, TIMER_NEVER, 0);
+	new->timer_thread = thread_add_read(new, thread_timerfd_handler, NULL, new->timer_fd, TIMER_NEVER, THREAD_PRIORITY);
 
-	add_signal_read_thread(new);
+	if (with_signals)
+		add_signal_read_thread(new);
 
 	return new;
 }
 
+/* Make thread master. */
+thread_master_t *
+thread_make_master(void)
+{
+	return thread_new_master(true);
+}
+
+/* Make a thread master to be run by a pthread other than the main
+ * one. Signals are only handled by the main thread's master. */
+thread_master_t *
+thread_make_worker_master(void)
+{
+	return thread_new_master(false);
+}
+
 #ifdef THREAD_DUMP
 static const char *
 timer_delay(timeval_t sands)
@@ -844,7 +1333,7 @@ timer_delay(timeval_t sands)
 }
 
 /* Dump rbtree */
-static inline void
+static void
 write_thread_entry(FILE *fp, unsigned index, const thread_t *thread)
 {
 	conf_write(fp, "#%.2u Thread:%p type %s, event %p, val/fd/pid %d, fd_flags %x, timer: %s, func %s(), id %lu"
@@ -868,6 +1357,23 @@ thread_rb_dump(const rb_root_cached_t *root, const char *tree, FILE *fp)
 	conf_write(fp, "----[ End rb_dump ]----");
 }
 
+#ifdef _WITH_TIMER_WHEEL_
+static void
+thread_wheel_dump(const timer_wheel_t *w, const char *wheel, FILE *fp)
+{
+	thread_t *thread;
+	unsigned lvl, idx;
+	unsigned i = 1;
+
+	conf_write(fp, "----[ Begin wheel_dump %s ]----", wheel);
+
+	timer_wheel_for_each_entry(thread, w, lvl, idx, e_list)
+		write_thread_entry(fp, i++, thread);
+
+	conf_write(fp, "----[ End wheel_dump ]----");
+}
+#endif
+
 static void
 thread_list_dump(const list_head_t *l, const char *list_type, FILE *fp)
 {
@@ -883,17 +1389,21 @@ thread_list_dump(const list_head_t *l, const char *list_type, FILE *fp)
 }
 
 static void
-event_rb_dump(const rb_root_t *root, const char *tree, FILE *fp)
+event_table_dump(const thread_master_t *m, const char *table, FILE *fp)
 {
-	thread_event_t *event;
+	const thread_event_t *event;
+	unsigned fd;
 	int i = 1;
 
-	conf_write(fp, "----[ Begin rb_dump %s ]----", tree);
-	rb_for_each_entry(event, root, n)
+	conf_write(fp, "----[ Begin table_dump %s (size %u) ]----", table, m->io_events_size);
+	for (fd = 0; fd < m->io_events_size; fd++) {
+		if (!(event = m->io_events[fd]))
+			continue;
 		conf_write(fp, "#%.2d event %p fd %d, flags: 0x%lx, read %p, write %p"
 			     , i++, event, event->fd, event->flags
 			     , event->read, event->write);
-	conf_write(fp, "----[ End rb_dump ]----");
+	}
+	conf_write(fp, "----[ End table_dump ]----");
 }
 
 void
@@ -902,17 +1412,204 @@ dump_thread_data(const thread_master_t *m, FILE *fp)
 	thread_rb_dump(&m->read, "read", fp);
 	thread_rb_dump(&m->write, "write", fp);
 	thread_rb_dump(&m->child, "child", fp);
+#ifdef _WITH_TIMER_WHEEL_
+	thread_wheel_dump(&m->timer, "timer", fp);
+#else
 	thread_rb_dump(&m->timer, "timer", fp);
+#endif
 	thread_list_dump(&m->event, "event", fp);
 	thread_list_dump(&m->ready, "ready", fp);
+	thread_list_dump(&m->ready_read, "ready_read", fp);
+	thread_list_dump(&m->ready_write, "ready_write", fp);
 #ifdef USE_SIGNAL_THREADS
 	thread_list_dump(&m->signal, "signal", fp);
 #endif
 	thread_list_dump(&m->unuse, "unuse", fp);
-	event_rb_dump(&m->io_events, "io_events", fp);
+	event_table_dump(m, "io_events", fp);
+	slab_cache_dump(&m->thread_slab, fp);
+	slab_cache_dump(&m->event_slab, fp);
 }
 #endif
 
+void
+dump_scheduler_data(const thread_master_t *m, FILE *fp)
+{
+	const thread_func_stats_t *stats;
+	unsigned long epoll_ops;
+	unsigned long uptime;
+	char buf[THREAD_HIST_BUCKETS * 24];
+
+	conf_write(fp, "------< Scheduler >------");
+	if (m->read_budget)
+		conf_write(fp, " Read budget = %u", m->read_budget);
+	else
+		conf_write(fp, " Read budget = unlimited");
+	if (m->write_budget)
+		conf_write(fp, " Write budget = %u", m->write_budget);
+	else
+		conf_write(fp, " Write budget = unlimited");
+	conf_write(fp, " Threads deferred = %lu", m->deferred);
+	conf_write(fp, " Budget polls = %lu", m->budget_polls);
+	conf_write(fp, " Timer slack = %lu usecs, timer wakeups = %lu", m->timer_slack, m->timer_wakeups);
+	set_time_now();
+	uptime = timer_long(time_now) - timer_long(m->start_time);
+	conf_write(fp, " Timer coalescing window = %lu usecs, wakeups saved = %lu (%.2f/sec)",
+			m->timer_coalesce, m->timer_wakeups_saved,
+			uptime ? (double)m->timer_wakeups_saved * TIMER_HZ / uptime : 0);
+	epoll_ops = m->epoll_ctl_calls;
+#ifdef _WITH_IO_URING_
+	epoll_ops += m->uring_epoll_ops;
+#endif
+	conf_write(fp, " epoll changes requested = %lu, epoll_ctl calls = %lu, saved = %ld",
+			m->epoll_requests, m->epoll_ctl_calls, (long)(m->epoll_requests - epoll_ops));
+#ifdef _WITH_IO_URING_
+	if (m->use_uring)
+		conf_write(fp, " io_uring submits = %lu, epoll changes = %lu", m->uring_submits, m->uring_epoll_ops);
+	else
+		conf_write(fp, " io_uring not in use");
+#endif
+	slab_cache_dump(&m->thread_slab, fp);
+	slab_cache_dump(&m->event_slab, fp);
+
+	conf_write(fp, " epoll wakeups = %lu, ready events = %lu", m->epoll_wakeups, m->epoll_ready);
+	conf_write(fp, "   events per wakeup:%s", thread_hist_str(m->epoll_ready_hist, buf, sizeof(buf)));
+
+	conf_write(fp, " Thread functions (times in usecs):");
+	rb_for_each_entry_const(stats, &m->func_stats, n) {
+		conf_write(fp, "   %s: calls %lu, run total %lu, max %lu", thread_func_name(stats->func),
+				stats->calls, stats->run_total, stats->run_max);
+		conf_write(fp, "     run:%s", thread_hist_str(stats->run_hist, buf, sizeof(buf)));
+		if (stats->timer_calls) {
+			conf_write(fp, "     timer calls %lu, late max %lu", stats->timer_calls, stats->late_max);
+			conf_write(fp, "     late:%s", thread_hist_str(stats->late_hist, buf, sizeof(buf)));
+		}
+	}
+}
+
+void
+dump_scheduler_json(const thread_master_t *m, json_writer_t *wr)
+{
+	const thread_func_stats_t *stats;
+
+	jsonw_start_object(wr);
+	jsonw_uint_field(wr, "epoll_wakeups", m->epoll_wakeups);
+	jsonw_uint_field(wr, "epoll_ready_events", m->epoll_ready);
+	thread_json_hist(wr, "epoll_ready_hist", m->epoll_ready_hist);
+	jsonw_uint_field(wr, "timer_wakeups", m->timer_wakeups);
+	jsonw_uint_field(wr, "timer_wakeups_saved", m->timer_wakeups_saved);
+
+	jsonw_name(wr, "functions");
+	jsonw_start_array(wr);
+	rb_for_each_entry_const(stats, &m->func_stats, n) {
+		jsonw_start_object(wr);
+		jsonw_string_field(wr, "name", thread_func_name(stats->func));
+		jsonw_uint_field(wr, "calls", stats->calls);
+		jsonw_uint_field(wr, "run_usecs_total", stats->run_total);
+		jsonw_uint_field(wr, "run_usecs_max", stats->run_max);
+		thread_json_hist(wr, "run_usecs_hist", stats->run_hist);
+		jsonw_uint_field(wr, "timer_calls", stats->timer_calls);
+		jsonw_uint_field(wr, "late_usecs_max", stats->late_max);
+		thread_json_hist(wr, "late_usecs_hist", stats->late_hist);
+		jsonw_end_object(wr);
+	}
+	jsonw_end_array(wr);
+	jsonw_end_object(wr);
+}
+
+/* A histogram bucket n counts values of [2^(n-1), 2^n), so the
+ * cumulative count up to it is of values <= 2^n - 1. Times are in
+ * usecs. sum is NULL if the total of the values is not kept. */
+static void
+thread_metrics_hist(query_buf_t *b, const char *name, const char *func,
+		    const unsigned long *hist, bool usecs, const unsigned long *sum)
+{
+	char sample[64];
+	char le[24];
+	const char *labels[] = { "function", func, "le", le, NULL };
+	const char * const *func_labels = func ? labels : NULL;
+	unsigned long count = 0;
+	unsigned long upper;
+	unsigned i;
+
+	snprintf(sample, sizeof(sample), "%s_bucket", name);
+	for (i = 0; i < THREAD_HIST_BUCKETS; i++) {
+		count += hist[i];
+		upper = (1UL << i) - 1;
+		if (i == THREAD_HIST_BUCKETS - 1)
+			strcpy(le, "+Inf");
+		else if (usecs)
+			snprintf(le, sizeof(le), "%lu.%06lu", upper / TIMER_HZ, upper % TIMER_HZ);
+		else
+			snprintf(le, sizeof(le), "%lu.0", upper);
+		metrics_uint(b, sample, func ? labels : labels + 2, count);
+	}
+
+	if (!sum)
+		return;
+
+	if (func)
+		labels[2] = NULL;
+	snprintf(sample, sizeof(sample), "%s_count", name);
+	metrics_uint(b, sample, func_labels, count);
+	snprintf(sample, sizeof(sample), "%s_sum", name);
+	if (usecs)
+		metrics_usecs(b, sample, func_labels, *sum);
+	else
+		metrics_uint(b, sample, func_labels, *sum);
+}
+
+void
+dump_scheduler_metrics(const thread_master_t *m, query_buf_t *b)
+{
+	const thread_func_stats_t *stats;
+	const char *labels[] = { "function", NULL, NULL };
+
+	metrics_family(b, "keepalived_scheduler_threads", METRICS_GAUGE, "Threads allocated");
+	metrics_uint(b, "keepalived_scheduler_threads", NULL, m->alloc);
+	metrics_family(b, "keepalived_scheduler_epoll_wakeups", METRICS_COUNTER, "Returns from epoll_wait");
+	metrics_uint(b, "keepalived_scheduler_epoll_wakeups_total", NULL, m->epoll_wakeups);
+	metrics_family(b, "keepalived_scheduler_epoll_ready_events", METRICS_HISTOGRAM, "Events returned per epoll_wait");
+	thread_metrics_hist(b, "keepalived_scheduler_epoll_ready_events", NULL, m->epoll_ready_hist, false, &m->epoll_ready);
+	metrics_family(b, "keepalived_scheduler_epoll_changes_requested", METRICS_COUNTER, "Changes to the epoll set requested");
+	metrics_uint(b, "keepalived_scheduler_epoll_changes_requested_total", NULL, m->epoll_requests);
+	metrics_family(b, "keepalived_scheduler_epoll_ctl_calls", METRICS_COUNTER, "Calls of epoll_ctl");
+	metrics_uint(b, "keepalived_scheduler_epoll_ctl_calls_total", NULL, m->epoll_ctl_calls);
+#ifdef _WITH_IO_URING_
+	metrics_family(b, "keepalived_scheduler_io_uring_submits", METRICS_COUNTER, "io_uring submissions");
+	metrics_uint(b, "keepalived_scheduler_io_uring_submits_total", NULL, m->uring_submits);
+#endif
+	metrics_family(b, "keepalived_scheduler_timer_wakeups", METRICS_COUNTER, "Expiries of the timer fd");
+	metrics_uint(b, "keepalived_scheduler_timer_wakeups_total", NULL, m->timer_wakeups);
+	metrics_family(b, "keepalived_scheduler_timer_wakeups_saved", METRICS_COUNTER, "Timer fd expiries saved by coalescing");
+	metrics_uint(b, "keepalived_scheduler_timer_wakeups_saved_total", NULL, m->timer_wakeups_saved);
+	metrics_family(b, "keepalived_scheduler_threads_deferred", METRICS_COUNTER, "Ready threads deferred by the read and write budgets");
+	metrics_uint(b, "keepalived_scheduler_threads_deferred_total", NULL, m->deferred);
+
+	metrics_family(b, "keepalived_scheduler_thread_calls", METRICS_COUNTER, "Calls of a thread function");
+	rb_for_each_entry_const(stats, &m->func_stats, n) {
+		labels[1] = thread_func_name(stats->func);
+		metrics_uint(b, "keepalived_scheduler_thread_calls_total", labels, stats->calls);
+	}
+
+	metrics_family(b, "keepalived_scheduler_thread_run_seconds", METRICS_HISTOGRAM, "Run time of a thread function");
+	rb_for_each_entry_const(stats, &m->func_stats, n)
+		thread_metrics_hist(b, "keepalived_scheduler_thread_run_seconds", thread_func_name(stats->func),
+				    stats->run_hist, true, &stats->run_total);
+
+	metrics_family(b, "keepalived_scheduler_thread_run_max_seconds", METRICS_GAUGE, "Longest run time of a thread function");
+	rb_for_each_entry_const(stats, &m->func_stats, n) {
+		labels[1] = thread_func_name(stats->func);
+		metrics_usecs(b, "keepalived_scheduler_thread_run_max_seconds", labels, stats->run_max);
+	}
+
+	metrics_family(b, "keepalived_scheduler_thread_late_seconds", METRICS_HISTOGRAM, "Lateness of the timer calls of a thread function");
+	rb_for_each_entry_const(stats, &m->func_stats, n) {
+		if (stats->timer_calls)
+			thread_metrics_hist(b, "keepalived_scheduler_thread_late_seconds", thread_func_name(stats->func),
+					    stats->late_hist, true, NULL);
+	}
+}
+
 /* declare thread_timer_less() for rbtree compares */
 RB_TIMER_LESS(thread, n);
 
@@ -927,7 +1624,7 @@ thread_clean_unuse(thread_master_t * m)
 		list_del_init(&thread->e_list);
 
 		/* free the thread */
-		FREE(thread);
+		slab_free(&m->thread_slab, thread);
 		m->alloc--;
 	}
 
@@ -1017,6 +1714,21 @@ thread_destroy_rb(thread_master_t *m, rb_root_cached_t *root)
 	*root = RB_ROOT_CACHED;
 }
 
+#ifdef _WITH_TIMER_WHEEL_
+static void
+thread_destroy_wheel(thread_master_t *m, timer_wheel_t *w)
+{
+	thread_t *thread, *thread_tmp;
+	unsigned lvl, idx;
+
+	/* Timer threads have no events or fds to release */
+	timer_wheel_for_each_entry_safe(thread, thread_tmp, w, lvl, idx, e_list)
+		thread_add_unuse(m, thread);
+
+	timer_wheel_init(w, thread_timer_sands);
+}
+#endif
+
 /* Cleanup master */
 void
 thread_cleanup_master(thread_master_t * m, bool keep_children)
@@ -1025,7 +1737,11 @@ thread_cleanup_master(thread_master_t * m, bool keep_children)
 	m->current_event = NULL;
 	thread_destroy_rb(m, &m->read);
 	thread_destroy_rb(m, &m->write);
+#ifdef _WITH_TIMER_WHEEL_
+	thread_destroy_wheel(m, &m->timer);
+#else
 	thread_destroy_rb(m, &m->timer);
+#endif
 	if (!keep_children)
 		thread_destroy_rb(m, &m->child);
 	thread_destroy_list(m, &m->event, false);
@@ -1033,6 +1749,8 @@ thread_cleanup_master(thread_master_t * m, bool keep_children)
 	thread_destroy_list(m, &m->signal, false);
 #endif
 	thread_destroy_list(m, &m->ready, keep_children);
+	thread_destroy_list(m, &m->ready_read, false);
+	thread_destroy_list(m, &m->ready_write, false);
 
 	/* This is an optimisation to avoid having to call
 	 * rb_erase() for each thread that is removed from
@@ -1078,6 +1796,18 @@ thread_destroy_master(thread_master_t * m)
 
 	thread_cleanup_master(m, false);
 
+#ifdef _WITH_IO_URING_
+	if (m->use_uring) {
+		uring_exit(&m->uring);
+		FREE(m->uring_epoll_events);
+	}
+#endif
+
+	slab_cache_destroy(&m->thread_slab);
+	slab_cache_destroy(&m->event_slab);
+	thread_func_stats_destroy(m);
+	FREE(m->io_events);
+
 	FREE(m);
 }
 
@@ -1111,7 +1841,7 @@ thread_new(thread_master_t *m)
 	/* If one thread is already allocated return it */
 	new = thread_trim_head(&m->unuse);
 	if (!new) {
-		PMALLOC(new);
+		new = slab_alloc(&m->thread_slab);
 		m->alloc++;
 	}
 
@@ -1344,8 +2074,12 @@ thread_add_timer_uval_sands(thread_master_t *m, thread_func_t func, void *arg, u
 
 	thread->sands = *sands;
 
+#ifdef _WITH_TIMER_WHEEL_
+	timer_wheel_add(&m->timer, &thread->e_list);
+#else
 	/* Sort by timeval. */
 	rb_add_cached(&thread->n, &m->timer, thread_timer_less);
+#endif
 
 	return thread;
 }
@@ -1380,6 +2114,20 @@ thread_add_timer_sands(thread_master_t *m, thread_func_t func, void *arg, const
 	return thread_add_timer_uval_sands(m, func, arg, 0, sands);
 }
 
+/* Add a timer for the period after the one due at *deadline, and update
+ * *deadline. Unlike thread_add_timer(), the time taken to run the previous
+ * period doesn't delay the next one, so periodic work doesn't drift. */
+thread_ref_t
+thread_add_timer_periodic(thread_master_t *m, thread_func_t func, void *arg, timeval_t *deadline, unsigned long interval, timer_catchup_t catchup)
+{
+	assert(m != NULL);
+
+	set_time_now();
+	*deadline = timer_next_periodic(*deadline, interval, catchup);
+
+	return thread_add_timer_uval_sands(m, func, arg, 0, deadline);
+}
+
 void
 thread_update_arg2(thread_ref_t thread_cp, const thread_arg2 *u)
 {
@@ -1407,7 +2155,11 @@ timer_thread_update_timeout(thread_ref_t thread_cp, unsigned long timer)
 
 	thread->sands = sands;
 
+#ifdef _WITH_TIMER_WHEEL_
+	timer_wheel_move(&thread->master->timer, &thread->e_list);
+#else
 	rb_move_cached(&thread->n, &thread->master->timer, thread_timer_less);
+#endif
 }
 
 thread_ref_t
@@ -1604,7 +2356,11 @@ thread_cancel(thread_ref_t thread_cp)
 		rb_erase_cached(&thread->n, &m->write);
 		break;
 	case THREAD_TIMER:
+#ifdef _WITH_TIMER_WHEEL_
+		timer_wheel_del(&m->timer, &thread->e_list);
+#else
 		rb_erase_cached(&thread->n, &m->timer);
+#endif
 		break;
 	case THREAD_CHILD:
 		/* Does this need to kill the child, or is that the
@@ -1884,6 +2640,83 @@ snmp_epoll_clear(thread_master_t *m)
 }
 #endif
 
+/* Set the maximum number of bulk read and write threads to run for each
+ * call of epoll_wait(), 0 meaning unlimited. Threads flagged THREAD_PRIORITY,
+ * timers and timeouts are not counted and are always run first. */
+void
+thread_set_budgets(thread_master_t *m, unsigned read_budget, unsigned write_budget)
+{
+	m->read_budget = read_budget;
+	m->write_budget = write_budget;
+
+	/* Anything queued on a queue no longer used must not be lost */
+	if (!read_budget)
+		list_splice_init(&m->ready_read, m->ready.prev);
+	if (!write_budget)
+		list_splice_init(&m->ready_write, m->ready.prev);
+}
+
+/* Set how many free thread and thread_event structures are kept for reuse */
+void
+thread_set_slab_high_water(thread_master_t *m, unsigned high_water)
+{
+	slab_cache_set_high_water(&m->thread_slab, high_water);
+	slab_cache_set_high_water(&m->event_slab, high_water);
+}
+
+/* Allow timer_fd expiry to be delayed by up to slack usecs, so that
+ * timers expiring close together are run from a single wakeup */
+void
+thread_set_timer_slack(thread_master_t *m, unsigned long slack)
+{
+	m->timer_slack = slack;
+}
+
+/* Allow timers due within window usecs of the earliest timer to be run
+ * together with it. The caller must make sure that delaying a timer by
+ * this long is safe. */
+void
+thread_set_timer_coalesce(thread_master_t *m, unsigned long window)
+{
+	m->timer_coalesce = window;
+}
+
+/* Return a bulk queue if it has threads and has not used up its budget */
+static list_head_t *
+thread_bulk_queue(thread_master_t *m)
+{
+	if (!list_empty(&m->ready_read) && m->read_run < m->read_budget) {
+		m->read_run++;
+		return &m->ready_read;
+	}
+
+	if (!list_empty(&m->ready_write) && m->write_run < m->write_budget) {
+		m->write_run++;
+		return &m->ready_write;
+	}
+
+	return NULL;
+}
+
+/* Count and flag the threads on a bulk queue that are being deferred
+ * for the first time. Threads are only added at the tail, so the ones
+ * already counted are before any that are not. */
+static unsigned long
+thread_count_deferred(list_head_t *queue)
+{
+	thread_t *thread;
+	unsigned long count = 0;
+
+	list_for_each_entry_reverse(thread, queue, e_list) {
+		if (thread->u.f.flags & THREAD_DEFERRED)
+			break;
+		thread->u.f.flags |= THREAD_DEFERRED;
+		count++;
+	}
+
+	return count;
+}
+
 /* Fetch next ready thread. */
 static list_head_t *
 thread_fetch_next_queue(thread_master_t *m)
@@ -1896,6 +2729,8 @@ thread_fetch_next_queue(thread_master_t *m)
 	int i;
 	timeval_t earliest_timer;
 	unsigned timeout;
+	bool bulk_deferred;
+	list_head_t *queue;
 
 	assert(m != NULL);
 
@@ -1907,7 +2742,21 @@ thread_fetch_next_queue(thread_master_t *m)
 	if (!list_empty(&m->ready))
 		return &m->ready;
 
+	/* Then bulk read/write threads, while they are within budget */
+	if ((queue = thread_bulk_queue(m)))
+		return queue;
+
 	do {
+		/* If bulk threads have used up their budget, we poll without
+		 * waiting, so that any fds and timers that have become ready
+		 * get run before the remaining bulk threads. */
+		bulk_deferred = !list_empty(&m->ready_read) || !list_empty(&m->ready_write);
+		if (bulk_deferred) {
+			m->deferred += thread_count_deferred(&m->ready_read) +
+				       thread_count_deferred(&m->ready_write);
+			m->budget_polls++;
+		}
+
 		/* Calculate and set wait timer. Take care of timeouted fd.  */
 		earliest_timer = thread_set_timer(m);
 
@@ -1926,8 +2775,14 @@ thread_fetch_next_queue(thread_master_t *m)
 			log_message(LOG_INFO, "calling epoll_wait");
 #endif
 
+		if (!list_empty(&m->epoll_changes))
+			thread_flush_epoll_changes(m);
+
+		/* Write any queued log messages before waiting */
+		flush_log_queue();
+
 		/* Call epoll function. */
-		ret = epoll_wait(m->epoll_fd, m->epoll_events, m->epoll_count, -1);
+		ret = epoll_wait(m->epoll_fd, m->epoll_events, m->epoll_count, bulk_deferred ? 0 : -1);
 
 #ifdef _EPOLL_DEBUG_
 		if (do_epoll_debug) {
@@ -1977,6 +2832,10 @@ thread_fetch_next_queue(thread_master_t *m)
 		} else
 			last_epoll_errno = 0;
 
+		m->epoll_wakeups++;
+		m->epoll_ready += (unsigned)ret;
+		m->epoll_ready_hist[thread_hist_bucket((unsigned)ret)]++;
+
 		/* Check to see if we are long overdue. This can happen on a very heavily loaded system */
 		if (min_auto_priority_delay && timerisset(&earliest_timer)) {
 			/* Re-read the current time to get the maximum accuracy */
@@ -2064,22 +2923,68 @@ thread_fetch_next_queue(thread_master_t *m)
 		/* Update current time */
 		set_time_now();
 
+		/* Start a new budget period */
+		m->read_run = m->write_run = 0;
+
+		/* The timerfd won't have been read yet if timers expired
+		 * while the bulk threads were running */
+		if (bulk_deferred)
+			thread_move_expired(m);
+
 		/* If there is a ready thread, return it. */
 		if (!list_empty(&m->ready))
 			return &m->ready;
+
+		if ((queue = thread_bulk_queue(m)))
+			return queue;
 	} while (true);
 }
 
 /* Call thread ! */
-static inline void
+static void
 thread_call(thread_t * thread)
 {
+	thread_func_stats_t *stats = thread_func_stats_get(thread->master, thread->func);
+	thread_func_t func = thread->func;
+	timeval_t start, end, diff;
+	unsigned long usecs;
+
 #ifdef _EPOLL_DEBUG_
 	if (do_epoll_debug)
 		log_message(LOG_INFO, "Calling thread function %s(), type %s, val/fd/pid %d, status %d id %lu", get_function_name(thread->func), get_thread_type_str(thread->type), thread->u.val, thread->u.c.status, thread->id);
 #endif
 
-	(*thread->func) (thread);
+	start = timer_now();
+
+	/* How late is the thread being run for its timer or timeout? */
+	if ((thread->type == THREAD_READY_TIMER ||
+	     thread->type == THREAD_TIMER_SHUTDOWN ||
+	     thread->type == THREAD_READ_TIMEOUT ||
+	     thread->type == THREAD_WRITE_TIMEOUT ||
+	     thread->type == THREAD_CHILD_TIMEOUT) &&
+	    thread->sands.tv_sec != TIMER_DISABLED) {
+		usecs = 0;
+		if (timercmp(&start, &thread->sands, >)) {
+			timersub(&start, &thread->sands, &diff);
+			usecs = timer_long(diff);
+		}
+		stats->timer_calls++;
+		stats->late_hist[thread_hist_bucket(usecs)]++;
+		if (usecs > stats->late_max)
+			stats->late_max = usecs;
+	}
+
+	(*func) (thread);
+
+	/* The thread may have been freed, so only use func and stats */
+	end = timer_now();
+	timersub(&end, &start, &diff);
+	usecs = timer_long(diff);
+	stats->calls++;
+	stats->run_total += usecs;
+	stats->run_hist[thread_hist_bucket(usecs)]++;
+	if (usecs > stats->run_max)
+		stats->run_max = usecs;
 }
 
 int
@@ -2252,7 +3157,7 @@ thread_add_base_threads(thread_master_t *m,
 #endif
 								     bool with_snmp)
 {
-	m->timer_thread = thread_add_read(m, thread_timerfd_handler, NULL, m->timer_fd, TIMER_NEVER, 0);
+	m->timer_thread = thread_add_read(m, thread_timerfd_handler, NULL, m->timer_fd, TIMER_NEVER, THREAD_PRIORITY);
 	add_signal_read_thread(m);
 #ifdef _WITH_SNMP_
 	if (with_snmp)
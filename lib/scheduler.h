@@ -31,20 +31,27 @@
 #ifdef _WITH_SNMP_
 #include <sys/select.h>
 #endif
-#ifdef THREAD_DUMP
 #include <stdio.h>
-#endif
 
 #include "timer.h"
 #include "list_head.h"
 #include "rbtree_ka.h"
+#include "slab.h"
+#include "json_writer.h"
+#include "query_socket.h"
+#ifdef _WITH_TIMER_WHEEL_
+#include "timer_wheel.h"
+#endif
+#ifdef _WITH_IO_URING_
+#include "uring.h"
+#endif
 
 /* Thread types. */
 typedef enum {
 	THREAD_READ,		/* thread_master.read rb tree */
 	THREAD_WRITE,		/* thread_master.write rb tree */
-	THREAD_TIMER,		/* thread_master.timer rb tree */
-	THREAD_TIMER_SHUTDOWN,	/* thread_master.timer rb tree */
+	THREAD_TIMER,		/* thread_master.timer rb tree or timing wheel */
+	THREAD_TIMER_SHUTDOWN,	/* thread_master.timer rb tree or timing wheel */
 	THREAD_CHILD,		/* thread_master.child rb tree */
 #define THREAD_MAX_WAITING THREAD_CHILD
 	THREAD_UNUSED,		/* thread_master.unuse list_head */
@@ -75,15 +82,30 @@ enum thread_flags {
 	THREAD_FL_EPOLL_BIT,		/* fd is registered with epoll */
 	THREAD_FL_EPOLL_READ_BIT,	/* read is registered */
 	THREAD_FL_EPOLL_WRITE_BIT,	/* write is registered */
+	THREAD_FL_EPOLL_CHANGE_BIT,	/* epoll change is queued */
+	THREAD_FL_EPOLL_ADD_BIT,	/* queued epoll change is an add */
 };
 
 /* epoll def */
 #define THREAD_EPOLL_REALLOC_THRESH	64
+#define THREAD_IO_EVENTS_MIN		64
+
+/* Scheduler statistics */
+#define THREAD_HIST_BUCKETS		24	/* up to 2^22 usecs, i.e. ~4 seconds */
+#ifdef _WITH_IO_URING_
+#define THREAD_URING_ENTRIES		256
+#endif
 
 /* Thread flags for thread destruction */
 #define THREAD_DESTROY_CLOSE_FD	0x01
 #define THREAD_DESTROY_FREE_ARG	0x02
 
+/* Thread flag for read/write threads that are not subject to the scheduler budgets */
+#define THREAD_PRIORITY		0x04
+
+/* Set by the scheduler on a ready read/write thread once it has been deferred by a budget */
+#define THREAD_DEFERRED		0x08
+
 typedef struct _thread thread_t;
 typedef const thread_t * thread_ref_t;
 typedef void (*thread_func_t)(thread_ref_t);
@@ -120,27 +142,47 @@ struct _thread {
 	rb_node_t rb_data;		/* PID or fd/vrid */
 };
 
+/* Run time and lateness of the calls of a thread function. The
+ * histograms are log2 of usecs, bucket n counting values in
+ * [2^(n-1), 2^n), and the last bucket everything larger. */
+typedef struct _thread_func_stats {
+	thread_func_t		func;
+	unsigned long		calls;
+	unsigned long		run_total;		/* usecs */
+	unsigned long		run_max;
+	unsigned long		run_hist[THREAD_HIST_BUCKETS];
+	unsigned long		timer_calls;		/* calls for a timer or timeout */
+	unsigned long		late_max;
+	unsigned long		late_hist[THREAD_HIST_BUCKETS];
+	rb_node_t		n;
+} thread_func_stats_t;
+
 /* Thread Event */
 typedef struct _thread_event {
 	thread_t		*read;
 	thread_t		*write;
 	unsigned long		flags;
 	int			fd;
-
-	rb_node_t		n;
+	list_head_t		e_list;		/* on master epoll_changes */
 } thread_event_t;
 
 /* Master of the threads. */
 typedef struct _thread_master {
 	rb_root_cached_t	read;
 	rb_root_cached_t	write;
+#ifdef _WITH_TIMER_WHEEL_
+	timer_wheel_t		timer;
+#else
 	rb_root_cached_t	timer;
+#endif
 	rb_root_cached_t	child;
 	list_head_t		event;
 #ifdef USE_SIGNAL_THREADS
 	list_head_t		signal;
 #endif
 	list_head_t		ready;
+	list_head_t		ready_read;	/* bulk read threads, if read_budget set */
+	list_head_t		ready_write;	/* bulk write threads, if write_budget set */
 	list_head_t		unuse;
 
 	thread_t		*current_thread;
@@ -149,20 +191,51 @@ typedef struct _thread_master {
 	rb_root_t		child_pid;
 
 	/* epoll related */
-	rb_root_t		io_events;
+	thread_event_t		**io_events;	/* indexed by fd */
+	unsigned		io_events_size;
 	struct epoll_event	*epoll_events;
 	thread_event_t		*current_event;
 	unsigned int		epoll_size;
 	unsigned int		epoll_count;
 	int			epoll_fd;
+	list_head_t		epoll_changes;	/* events with a queued epoll change */
+	unsigned long		epoll_requests;	/* epoll changes requested */
+	unsigned long		epoll_ctl_calls;
+#ifdef _WITH_IO_URING_
+	uring_t			uring;
+	bool			use_uring;
+	struct epoll_event	*uring_epoll_events;
+	unsigned long		uring_submits;
+	unsigned long		uring_epoll_ops;
+#endif
+	unsigned long		epoll_wakeups;
+	unsigned long		epoll_ready;	/* total events returned */
+	unsigned long		epoll_ready_hist[THREAD_HIST_BUCKETS];	/* events per wakeup */
+
+	/* callback statistics, by thread_func_t */
+	rb_root_t		func_stats;
 
 	/* timer related */
 	int			timer_fd;
+	timeval_t		timer_fd_sands;	/* time timer_fd is set to expire */
+	unsigned long		timer_slack;	/* usecs timer_fd expiry can be delayed */
+	unsigned long		timer_wakeups;
+	unsigned long		timer_coalesce;	/* usecs window for running timers together */
+	unsigned		timer_fd_merged;	/* expiry times merged into timer_fd_sands */
+	unsigned long		timer_wakeups_saved;
 	thread_ref_t		timer_thread;
 
 	/* signal related */
 	int			signal_fd;
 
+	/* fairness related - max bulk read/write threads run per epoll_wait */
+	unsigned		read_budget;
+	unsigned		write_budget;
+	unsigned		read_run;
+	unsigned		write_run;
+	unsigned long		deferred;
+	unsigned long		budget_polls;
+
 #ifdef _WITH_SNMP_
 	/* snmp related */
 	thread_ref_t		snmp_timer_thread;
@@ -170,7 +243,12 @@ typedef struct _thread_master {
 	fd_set			snmp_fdset;
 #endif
 
+	/* thread and thread_event allocation */
+	slab_cache_t		thread_slab;
+	slab_cache_t		event_slab;
+
 	/* Local data */
+	timeval_t		start_time;
 	unsigned long		alloc;
 	unsigned long		id;
 	bool			shutdown_timer_running;
@@ -223,7 +301,7 @@ enum chk_exit_code {
 #define DEFAULT_CHILD_FINDER ((void *)1)
 
 /* global vars exported */
-extern thread_master_t *master;
+extern __thread thread_master_t *master;
 #ifndef _ONE_PROCESS_DEBUG_
 extern prog_type_t prog_type;		/* Parent/VRRP/Checker process */
 #endif
@@ -252,12 +330,16 @@ extern void log_child_died(const char *, pid_t);
 extern int report_child_status(int, pid_t, const char *);
 #endif
 extern thread_master_t *thread_make_master(void);
+extern thread_master_t *thread_make_worker_master(void);
 extern thread_ref_t thread_add_terminate_event(thread_master_t *);
 extern thread_ref_t thread_add_parent_terminate_event(thread_master_t *, int);
 extern thread_ref_t thread_add_start_terminate_event(thread_master_t *, thread_func_t);
 #ifdef THREAD_DUMP
 extern void dump_thread_data(const thread_master_t *, FILE *);
 #endif
+extern void dump_scheduler_data(const thread_master_t *, FILE *);
+extern void dump_scheduler_json(const thread_master_t *, json_writer_t *);
+extern void dump_scheduler_metrics(const thread_master_t *, query_buf_t *);
 extern void thread_cleanup_master(thread_master_t *, bool);
 extern void thread_destroy_master(thread_master_t *);
 extern thread_ref_t thread_add_read_sands(thread_master_t *, thread_func_t, void *, int, const timeval_t *, unsigned);
@@ -270,6 +352,7 @@ extern void thread_close_fd(thread_ref_t);
 extern thread_ref_t thread_add_timer_uval(thread_master_t *, thread_func_t, void *, unsigned, unsigned long);
 extern thread_ref_t thread_add_timer(thread_master_t *, thread_func_t, void *, unsigned long);
 extern thread_ref_t thread_add_timer_sands(thread_master_t *, thread_func_t, void *, const timeval_t *);
+extern thread_ref_t thread_add_timer_periodic(thread_master_t *, thread_func_t, void *, timeval_t *, unsigned long, timer_catchup_t);
 extern void thread_update_arg2(thread_ref_t, const thread_arg2 *);
 extern void timer_thread_update_timeout(thread_ref_t, unsigned long);
 extern thread_ref_t thread_add_timer_shutdown(thread_master_t *, thread_func_t, void *, unsigned long);
@@ -283,6 +366,11 @@ extern void snmp_timeout_thread(thread_ref_t);
 extern void snmp_epoll_info(thread_master_t *);
 extern void snmp_epoll_clear(thread_master_t *);
 #endif
+extern void thread_set_budgets(thread_master_t *, unsigned, unsigned);
+extern void thread_set_slab_high_water(thread_master_t *, unsigned);
+extern void thread_set_timer_slack(thread_master_t *, unsigned long);
+extern void thread_set_timer_coalesce(thread_master_t *, unsigned long);
+extern void thread_set_max_fds(thread_master_t *, unsigned);
 extern int process_threads(thread_master_t *);
 extern void thread_child_handler(void *, int);
 extern void thread_add_base_threads(thread_master_t *, bool);
@@ -0,0 +1,187 @@
+/*
+ * Soft:        Keepalived is a failover program for the LVS project
+ *              <www.linuxvirtualserver.org>. It monitor & manipulate
+ *              a loadbalanced server pool using multi-layer checks.
+ *
+ * Part:        Fixed size object cache, used by the scheduler for
+ *              thread and thread event structures.
+ *
+ * Author:      Alexandre Cassen, <acassen@linux-vs.org>
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *              See the GNU General Public License for more details.
+ *
+ *              This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU General Public License
+ *              as published by the Free Software Foundation; either version
+ *              2 of the License, or (at your option) any later version.
+ *
+ * Copyright (C) 2026 Alexandre Cassen, <acassen@gmail.com>
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#include "slab.h"
+#include "logger.h"
+#include "scheduler.h"
+#include "assert_debug.h"
+
+#define SLAB_ROUND(x)	(((x) + SLAB_CACHE_LINE - 1) & ~((size_t)SLAB_CACHE_LINE - 1))
+
+static inline slab_t *
+slab_of(const void *obj)
+{
+	return (slab_t *)((uintptr_t)obj & ~(uintptr_t)(SLAB_SIZE - 1));
+}
+
+void
+slab_cache_init(slab_cache_t *c, const char *name, size_t size, unsigned high_water)
+{
+	memset(c, 0, sizeof(*c));
+
+	c->name = name;
+	c->obj_size = SLAB_ROUND(size);
+	c->obj_offset = SLAB_ROUND(sizeof(slab_t));
+	c->objs_per_slab = (unsigned)((SLAB_SIZE - c->obj_offset) / c->obj_size);
+	c->high_water = high_water;
+	INIT_LIST_HEAD(&c->partial);
+	INIT_LIST_HEAD(&c->full);
+
+	assert(c->objs_per_slab);
+}
+
+static void
+slab_release(slab_cache_t *c, slab_t *slab)
+{
+	list_del_init(&slab->e_list);
+
+	/* The slabs are not allocated with MALLOC since they need to be aligned */
+	free(slab);
+
+	c->slabs--;
+	c->slab_frees++;
+}
+
+/* Release empty slabs while there are more than high_water free objects */
+static void
+slab_cache_trim(slab_cache_t *c)
+{
+	slab_t *slab, *slab_tmp;
+
+	list_for_each_entry_safe(slab, slab_tmp, &c->partial, e_list) {
+		if (slab->in_use)
+			continue;
+		if ((c->slabs - 1) * c->objs_per_slab - c->in_use < c->high_water)
+			break;
+		slab_release(c, slab);
+	}
+}
+
+void
+slab_cache_set_high_water(slab_cache_t *c, unsigned high_water)
+{
+	c->high_water = high_water;
+	slab_cache_trim(c);
+}
+
+void
+slab_cache_destroy(slab_cache_t *c)
+{
+	slab_t *slab, *slab_tmp;
+
+	list_for_each_entry_safe(slab, slab_tmp, &c->partial, e_list)
+		slab_release(c, slab);
+	list_for_each_entry_safe(slab, slab_tmp, &c->full, e_list)
+		slab_release(c, slab);
+
+	c->in_use = 0;
+}
+
+static void
+slab_grow(slab_cache_t *c)
+{
+	slab_t *slab;
+	char *obj;
+	void *mem;
+	unsigned i;
+	int ret;
+
+	if ((ret = posix_memalign(&mem, SLAB_SIZE, SLAB_SIZE))) {
+		log_message(LOG_INFO, "Keepalived slab %s allocation error - %s", c->name, strerror(ret));
+		exit(KEEPALIVED_EXIT_NO_MEMORY);
+	}
+
+	slab = mem;
+	slab->in_use = 0;
+	slab->free = NULL;
+
+	/* Chain the objects in address order */
+	obj = (char *)mem + c->obj_offset + (c->objs_per_slab - 1) * c->obj_size;
+	for (i = 0; i < c->objs_per_slab; i++, obj -= c->obj_size) {
+		*(void **)(void *)obj = slab->free;
+		slab->free = obj;
+	}
+
+	list_add_tail(&slab->e_list, &c->partial);
+	c->slabs++;
+	c->slab_allocs++;
+}
+
+void *
+slab_alloc(slab_cache_t *c)
+{
+	slab_t *slab;
+	void *obj;
+
+	if (list_empty(&c->partial))
+		slab_grow(c);
+
+	slab = list_first_entry(&c->partial, slab_t, e_list);
+	obj = slab->free;
+	slab->free = *(void **)obj;
+
+	if (++slab->in_use == c->objs_per_slab)
+		list_move_tail(&slab->e_list, &c->full);
+
+	if (++c->in_use > c->peak_in_use)
+		c->peak_in_use = c->in_use;
+
+	memset(obj, 0, c->obj_size);
+
+	return obj;
+}
+
+void
+slab_free(slab_cache_t *c, void *obj)
+{
+	slab_t *slab = slab_of(obj);
+
+	*(void **)obj = slab->free;
+	slab->free = obj;
+
+	/* Allocate from the busiest slabs first, so that others can empty */
+	if (slab->in_use-- == c->objs_per_slab)
+		list_move(&slab->e_list, &c->partial);
+
+	c->in_use--;
+
+	if (!slab->in_use &&
+	    (c->slabs - 1) * c->objs_per_slab - c->in_use >= c->high_water)
+		slab_release(c, slab);
+}
+
+void
+slab_cache_dump(const slab_cache_t *c, FILE *fp)
+{
+	conf_write(fp, " %s slab: %u in use, peak %u, %u free, %u slabs of %u x %zu bytes, high water %u, %lu slab allocs, %lu slab frees"
+		     , c->name, c->in_use, c->peak_in_use, c->slabs * c->objs_per_slab - c->in_use
+		     , c->slabs, c->objs_per_slab, c->obj_size, c->high_water
+		     , c->slab_allocs, c->slab_frees);
+}
@@ -0,0 +1,73 @@
+/*
+ * Soft:        Keepalived is a failover program for the LVS project
+ *              <www.linuxvirtualserver.org>. It monitor & manipulate
+ *              a loadbalanced server pool using multi-layer checks.
+ *
+ * Part:        slab.c include file.
+ *
+ * Author:      Alexandre Cassen, <acassen@linux-vs.org>
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *              See the GNU General Public License for more details.
+ *
+ *              This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU General Public License
+ *              as published by the Free Software Foundation; either version
+ *              2 of the License, or (at your option) any later version.
+ *
+ * Copyright (C) 2026 Alexandre Cassen, <acassen@gmail.com>
+ */
+
+#ifndef _SLAB_H
+#define _SLAB_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "list_head.h"
+
+/* Fixed size object cache.
+ *
+ * Objects are carved out of SLAB_SIZE blocks which are aligned on
+ * SLAB_SIZE, so the block an object belongs to is found by masking its
+ * address. Each object is rounded up to a multiple of SLAB_CACHE_LINE
+ * so that objects never share a cache line. Blocks that become empty
+ * are only released once there are more than high_water free objects. */
+#define SLAB_SIZE		4096
+#define SLAB_CACHE_LINE		64
+#define SLAB_DEFAULT_HIGH_WATER	256
+
+typedef struct _slab {
+	list_head_t		e_list;		/* on the cache partial or full list */
+	void			*free;		/* first free object */
+	unsigned		in_use;
+} slab_t;
+
+typedef struct _slab_cache {
+	const char		*name;
+	size_t			obj_size;
+	size_t			obj_offset;	/* offset of first object in a slab */
+	unsigned		objs_per_slab;
+	unsigned		high_water;	/* free objects kept before releasing slabs */
+	list_head_t		partial;	/* slabs with free objects */
+	list_head_t		full;
+
+	/* statistics */
+	unsigned		slabs;
+	unsigned		in_use;
+	unsigned		peak_in_use;
+	unsigned long		slab_allocs;
+	unsigned long		slab_frees;
+} slab_cache_t;
+
+/* Prototypes */
+extern void slab_cache_init(slab_cache_t *, const char *, size_t, unsigned);
+extern void slab_cache_set_high_water(slab_cache_t *, unsigned);
+extern void slab_cache_destroy(slab_cache_t *);
+extern void *slab_alloc(slab_cache_t *) __attribute__ ((malloc));
+extern void slab_free(slab_cache_t *, void *);
+extern void slab_cache_dump(const slab_cache_t *, FILE *);
+
+#endif
@@ -33,8 +33,8 @@
 #include "logger.h"
 #endif
 
-/* time_now holds current time */
-timeval_t time_now;
+/* time_now holds current time. Each thread running a scheduler has its own. */
+__thread timeval_t time_now;
 #ifdef _TIMER_CHECK_
 static timeval_t last_time;
 bool do_timer_check;
@@ -75,6 +75,50 @@ timer_sub_long(timeval_t a, unsigned long b)
 	return a;
 }
 
+/* Return the deadline of the period after the one due at deadline.
+ * If deadline isn't set, the first period starts now. time_now must
+ * be up to date. */
+timeval_t
+timer_next_periodic(timeval_t deadline, unsigned long interval, timer_catchup_t catchup)
+{
+	timeval_t next, behind;
+	unsigned long missed;
+
+	if (!timerisset(&deadline) ||
+	    deadline.tv_sec == TIMER_DISABLED ||
+	    catchup == TIMER_CATCHUP_RESYNC ||
+	    !interval || interval == TIMER_NEVER)
+		return timer_add_long(time_now, interval);
+
+	next = timer_add_long(deadline, interval);
+
+	if (!timercmp(&next, &time_now, >)) {
+		/* Move on to the first period that hasn't already started */
+		timersub(&time_now, &next, &behind);
+		missed = timer_long(behind) / interval + 1;
+		next = timer_add_long(next, missed * interval);
+	}
+
+	return next;
+}
+
+/* Round a time up to a multiple of granularity usecs. This is used to
+ * make timers that expire close together expire at the same time. */
+timeval_t
+timer_round_up(timeval_t a, unsigned long granularity)
+{
+	unsigned long usecs, rem;
+
+	if (granularity <= 1 || a.tv_sec == TIMER_DISABLED)
+		return a;
+
+	usecs = timer_long(a);
+	if (!(rem = usecs % granularity))
+		return a;
+
+	return timer_add_long(a, granularity - rem);
+}
+
 static void
 set_mono_offset(struct timespec *ts)
 {
@@ -30,8 +30,14 @@
 
 typedef struct timeval timeval_t;
 
+/* What a periodic timer does if one or more periods have been missed */
+typedef enum {
+	TIMER_CATCHUP_SKIP,	/* skip missed periods, keeping the original phase */
+	TIMER_CATCHUP_RESYNC,	/* start a new period from now */
+} timer_catchup_t;
+
 /* Global vars */
-extern timeval_t time_now;
+extern __thread timeval_t time_now;
 
 #ifdef _TIMER_CHECK_
 extern bool do_timer_check;
@@ -149,5 +155,7 @@ extern timeval_t set_time_now(void);
 #endif
 extern timeval_t timer_add_long(timeval_t, unsigned long) __attribute__((const));
 extern timeval_t timer_sub_long(timeval_t, unsigned long) __attribute__((const));
+extern timeval_t timer_next_periodic(timeval_t, unsigned long, timer_catchup_t) __attribute__((pure));
+extern timeval_t timer_round_up(timeval_t, unsigned long) __attribute__((const));
 
 #endif
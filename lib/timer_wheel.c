@@ -0,0 +1,325 @@
+/*
+ * Soft:        Keepalived is a failover program for the LVS project
+ *              <www.linuxvirtualserver.org>. It monitor & manipulate
+ *              a loadbalanced server pool using multi-layer checks.
+ *
+ * Part:        Hierarchical timing wheel, used as an alternative to the
+ *              timer rbtree of the scheduler when there are very large
+ *              numbers of timers.
+ *
+ * Author:      Alexandre Cassen, <acassen@linux-vs.org>
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *              See the GNU General Public License for more details.
+ *
+ *              This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU General Public License
+ *              as published by the Free Software Foundation; either version
+ *              2 of the License, or (at your option) any later version.
+ *
+ * Copyright (C) 2026 Alexandre Cassen, <acassen@gmail.com>
+ */
+
+#include "config.h"
+
+#include "timer_wheel.h"
+
+static inline uint64_t
+timer_wheel_tick(const timeval_t *sands)
+{
+	return ((uint64_t)sands->tv_sec * TIMER_HZ + (uint64_t)sands->tv_usec) / TIMER_WHEEL_TICK;
+}
+
+static void
+timer_wheel_insert(timer_wheel_t *w, list_head_t *e, uint64_t expires)
+{
+	uint64_t delta;
+	unsigned lvl, idx;
+
+	/* Anything overdue goes in the slot being run now */
+	if (expires < w->clk)
+		expires = w->clk;
+	delta = expires - w->clk;
+
+	for (lvl = 0; lvl < TIMER_WHEEL_LEVELS - 1; lvl++) {
+		if (delta < (uint64_t)TIMER_WHEEL_SLOTS << (lvl * TIMER_WHEEL_BITS))
+			break;
+	}
+
+	/* Beyond the range of the wheel, park it in the furthest slot. It
+	 * will be placed according to its real sands when it is cascaded. */
+	if (delta >= (uint64_t)TIMER_WHEEL_SLOTS << (lvl * TIMER_WHEEL_BITS))
+		expires = w->clk + ((uint64_t)TIMER_WHEEL_SLOTS << (lvl * TIMER_WHEEL_BITS)) - 1;
+
+	idx = (expires >> (lvl * TIMER_WHEEL_BITS)) & TIMER_WHEEL_MASK;
+	list_add_tail(e, &w->slot[lvl][idx]);
+	w->pending[lvl] |= 1ULL << idx;
+}
+
+void
+timer_wheel_init(timer_wheel_t *w, timer_wheel_sands_t sands)
+{
+	unsigned lvl, idx;
+
+	for (lvl = 0; lvl < TIMER_WHEEL_LEVELS; lvl++) {
+		for (idx = 0; idx < TIMER_WHEEL_SLOTS; idx++)
+			INIT_LIST_HEAD(&w->slot[lvl][idx]);
+		w->pending[lvl] = 0;
+	}
+	INIT_LIST_HEAD(&w->disabled);
+	w->clk = timer_wheel_tick(&time_now);
+	w->count = 0;
+	w->sands = sands;
+}
+
+void
+timer_wheel_add(timer_wheel_t *w, list_head_t *e)
+{
+	const timeval_t *sands = w->sands(e);
+	uint64_t now_tick;
+
+	/* If the wheel is empty, there is nothing to cascade, so we can
+	 * bring the clock up to date and keep the entry in a low level.
+	 * Disabled entries are counted too, since timer_wheel_del() cannot
+	 * tell whether the entry it is passed was disabled. */
+	if (!w->count++) {
+		now_tick = timer_wheel_tick(&time_now);
+		if (now_tick > w->clk)
+			w->clk = now_tick;
+	}
+
+	if (sands->tv_sec == TIMER_DISABLED) {
+		list_add_tail(e, &w->disabled);
+		return;
+	}
+
+	timer_wheel_insert(w, e, timer_wheel_tick(sands));
+}
+
+void
+timer_wheel_del(timer_wheel_t *w, list_head_t *e)
+{
+	/* A stale pending bit is cleared when the slot is next looked at */
+	list_del_init(e);
+	w->count--;
+}
+
+/* The sands of the entry have been updated */
+void
+timer_wheel_move(timer_wheel_t *w, list_head_t *e)
+{
+	timer_wheel_del(w, e);
+	timer_wheel_add(w, e);
+}
+
+/* Find the first tick at which a slot needs to be run (level 0) or
+ * cascaded (higher levels). */
+static bool
+timer_wheel_next_tick(timer_wheel_t *w, uint64_t *tick, unsigned *level, unsigned *slot)
+{
+	unsigned lvl, shift, idx, start, j;
+	uint64_t pending, t;
+	bool found = false;
+
+	for (lvl = 0; lvl < TIMER_WHEEL_LEVELS; lvl++) {
+		shift = lvl * TIMER_WHEEL_BITS;
+		idx = (w->clk >> shift) & TIMER_WHEEL_MASK;
+
+		/* The current slot of a higher level has already been cascaded,
+		 * so anything in it is for the next time round */
+		start = lvl ? idx + 1 : idx;
+
+		while ((pending = w->pending[lvl])) {
+			if (start < TIMER_WHEEL_SLOTS && (pending & (~0ULL << start))) {
+				j = (unsigned)__builtin_ctzll(pending & (~0ULL << start));
+				t = ((w->clk >> shift) - idx + j) << shift;
+			} else {
+				j = (unsigned)__builtin_ctzll(pending);
+				t = ((w->clk >> shift) - idx + TIMER_WHEEL_SLOTS + j) << shift;
+			}
+
+			if (list_empty(&w->slot[lvl][j])) {
+				w->pending[lvl] &= ~(1ULL << j);
+				continue;
+			}
+
+			if (!found || t < *tick) {
+				*tick = t;
+				*level = lvl;
+				*slot = j;
+				found = true;
+			}
+			break;
+		}
+	}
+
+	return found;
+}
+
+/* Returns the time the wheel next needs to be run. This is the exact
+ * sands of the earliest entry if it is in level 0, otherwise it is the
+ * time the entries in a higher level need cascading. Returns false if
+ * there is nothing to wait for. */
+bool
+timer_wheel_next_expiry(timer_wheel_t *w, timeval_t *expiry)
+{
+	const timeval_t *sands;
+	list_head_t *e;
+	uint64_t tick, usecs;
+	unsigned lvl, slot;
+
+	if (!timer_wheel_next_tick(w, &tick, &lvl, &slot))
+		return false;
+
+	if (!lvl) {
+		/* timer_wheel_next_tick() doesn't return empty slots */
+		*expiry = *w->sands(w->slot[0][slot].next);
+		list_for_each(e, &w->slot[0][slot]) {
+			sands = w->sands(e);
+			if (timercmp(sands, expiry, <))
+				*expiry = *sands;
+		}
+
+		return true;
+	}
+
+	usecs = tick * TIMER_WHEEL_TICK;
+	expiry->tv_sec = (time_t)(usecs / TIMER_HZ);
+	expiry->tv_usec = (suseconds_t)(usecs % TIMER_HZ);
+
+	return true;
+}
+
+/* Set latest to the latest sands of the entries due no later than limit,
+ * and return how many separate expiry times after earliest they have.
+ * Only the slots that start no later than limit are looked at. Entries
+ * within a slot are not sorted, so equal sands are only recognised if
+ * they are next to each other. */
+unsigned
+timer_wheel_coalesce(timer_wheel_t *w, const timeval_t *earliest, const timeval_t *limit, timeval_t *latest)
+{
+	uint64_t limit_tick = timer_wheel_tick(limit);
+	const timeval_t *sands;
+	timeval_t prev = *earliest;
+	list_head_t *e;
+	unsigned lvl, shift, idx, j, k;
+	unsigned merged = 0;
+
+	for (lvl = 0; lvl < TIMER_WHEEL_LEVELS; lvl++) {
+		if (!w->pending[lvl])
+			continue;
+
+		shift = lvl * TIMER_WHEEL_BITS;
+		idx = (w->clk >> shift) & TIMER_WHEEL_MASK;
+
+		/* As in timer_wheel_next_tick(), the current slot of a higher
+		 * level is for the next time round */
+		for (k = lvl ? 1 : 0; k < TIMER_WHEEL_SLOTS; k++) {
+			if (((w->clk >> shift) + k) << shift > limit_tick)
+				break;
+
+			j = (idx + k) & TIMER_WHEEL_MASK;
+			if (!(w->pending[lvl] & (1ULL << j)))
+				continue;
+
+			list_for_each(e, &w->slot[lvl][j]) {
+				sands = w->sands(e);
+				if (timercmp(sands, limit, >))
+					continue;
+
+				if (timercmp(sands, &prev, !=) && timercmp(sands, earliest, >)) {
+					merged++;
+					prev = *sands;
+				}
+
+				if (timercmp(sands, latest, >))
+					*latest = *sands;
+			}
+		}
+	}
+
+	return merged;
+}
+
+/* Move the entries in the slot of the higher levels that the clock has
+ * just reached down the wheel */
+static void
+timer_wheel_cascade(timer_wheel_t *w)
+{
+	list_head_t list, *e, *e_tmp;
+	unsigned lvl, idx;
+
+	for (lvl = 1; lvl < TIMER_WHEEL_LEVELS; lvl++) {
+		idx = (w->clk >> (lvl * TIMER_WHEEL_BITS)) & TIMER_WHEEL_MASK;
+
+		if (w->pending[lvl] & (1ULL << idx)) {
+			w->pending[lvl] &= ~(1ULL << idx);
+			INIT_LIST_HEAD(&list);
+			list_splice_init(&w->slot[lvl][idx], &list);
+			list_for_each_safe(e, e_tmp, &list)
+				timer_wheel_insert(w, e, timer_wheel_tick(w->sands(e)));
+		}
+
+		if (idx)
+			break;
+	}
+}
+
+/* Slots are run in tick order, so only entries expiring in the same
+ * tick need to be stepped over to keep the expired list sorted */
+static void
+timer_wheel_add_expired(timer_wheel_t *w, list_head_t *e, list_head_t *expired)
+{
+	const timeval_t *sands = w->sands(e);
+	list_head_t *pos;
+
+	for (pos = expired->prev; pos != expired; pos = pos->prev) {
+		if (!timercmp(w->sands(pos), sands, >))
+			break;
+	}
+
+	list_head_add(e, pos);
+}
+
+/* Run the wheel up to now, appending all entries whose sands are not
+ * after now to expired, in sands order. Returns the number expired. */
+unsigned
+timer_wheel_expire(timer_wheel_t *w, const timeval_t *now, list_head_t *expired)
+{
+	uint64_t now_tick = timer_wheel_tick(now);
+	uint64_t next;
+	list_head_t *e, *e_tmp, *slot;
+	unsigned lvl, idx;
+	unsigned num_expired = 0;
+
+	while (true) {
+		slot = &w->slot[0][w->clk & TIMER_WHEEL_MASK];
+		list_for_each_safe(e, e_tmp, slot) {
+			if (timercmp(w->sands(e), now, >))
+				continue;
+
+			list_del_init(e);
+			timer_wheel_add_expired(w, e, expired);
+			w->count--;
+			num_expired++;
+		}
+
+		if (w->clk >= now_tick)
+			break;
+
+		/* Skip straight to the next slot with anything to do. Any
+		 * boundaries crossed on the way only have empty slots. */
+		if (!timer_wheel_next_tick(w, &next, &lvl, &idx) || next > now_tick)
+			next = now_tick;
+		else if (next <= w->clk)
+			next = w->clk + 1;
+
+		w->clk = next;
+		if (!(w->clk & TIMER_WHEEL_MASK))
+			timer_wheel_cascade(w);
+	}
+
+	return num_expired;
+}
@@ -0,0 +1,79 @@
+/*
+ * Soft:        Keepalived is a failover program for the LVS project
+ *              <www.linuxvirtualserver.org>. It monitor & manipulate
+ *              a loadbalanced server pool using multi-layer checks.
+ *
+ * Part:        timer_wheel.c include file.
+ *
+ * Author:      Alexandre Cassen, <acassen@linux-vs.org>
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *              See the GNU General Public License for more details.
+ *
+ *              This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU General Public License
+ *              as published by the Free Software Foundation; either version
+ *              2 of the License, or (at your option) any later version.
+ *
+ * Copyright (C) 2026 Alexandre Cassen, <acassen@gmail.com>
+ */
+
+#ifndef _TIMER_WHEEL_H
+#define _TIMER_WHEEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "timer.h"
+#include "list_head.h"
+
+/* Hierarchical timing wheel.
+ *
+ * Each level has TIMER_WHEEL_SLOTS slots, a slot at level n covering
+ * TIMER_WHEEL_SLOTS^n ticks. Entries are hashed into a slot by their
+ * expiry tick, and entries in higher levels are cascaded down as the
+ * wheel clock reaches the start of their slot, so that add and delete
+ * are O(1). Entries are only reported as expired once their exact
+ * sands have passed, so the tick size affects the work per slot and
+ * not the accuracy of the timers. */
+#define TIMER_WHEEL_TICK	1000		/* usecs per level 0 slot */
+#define TIMER_WHEEL_BITS	6
+#define TIMER_WHEEL_SLOTS	(1U << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK	(TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_LEVELS	6		/* 1ms to ~2.2 years */
+
+typedef const timeval_t *(*timer_wheel_sands_t)(const list_head_t *);
+
+typedef struct _timer_wheel {
+	list_head_t		slot[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+	uint64_t		pending[TIMER_WHEEL_LEVELS];	/* bitmap of possibly non-empty slots */
+	list_head_t		disabled;			/* entries with TIMER_DISABLED sands */
+	uint64_t		clk;				/* tick the wheel has been run up to */
+	unsigned		count;				/* entries, including disabled ones */
+	timer_wheel_sands_t	sands;				/* get the sands of an entry */
+} timer_wheel_t;
+
+/* Iterate over every entry in the wheel, including disabled ones. The
+ * entries are not in expiry order. */
+#define timer_wheel_for_each_entry(pos, w, lvl, idx, member)			\
+	for (lvl = 0; lvl <= TIMER_WHEEL_LEVELS; lvl++)				\
+		for (idx = 0; idx < (lvl < TIMER_WHEEL_LEVELS ? TIMER_WHEEL_SLOTS : 1); idx++) \
+			list_for_each_entry(pos, lvl < TIMER_WHEEL_LEVELS ? &(w)->slot[lvl][idx] : &(w)->disabled, member)
+
+#define timer_wheel_for_each_entry_safe(pos, n, w, lvl, idx, member)		\
+	for (lvl = 0; lvl <= TIMER_WHEEL_LEVELS; lvl++)				\
+		for (idx = 0; idx < (lvl < TIMER_WHEEL_LEVELS ? TIMER_WHEEL_SLOTS : 1); idx++) \
+			list_for_each_entry_safe(pos, n, lvl < TIMER_WHEEL_LEVELS ? &(w)->slot[lvl][idx] : &(w)->disabled, member)
+
+/* Prototypes */
+extern void timer_wheel_init(timer_wheel_t *, timer_wheel_sands_t);
+extern void timer_wheel_add(timer_wheel_t *, list_head_t *);
+extern void timer_wheel_del(timer_wheel_t *, list_head_t *);
+extern void timer_wheel_move(timer_wheel_t *, list_head_t *);
+extern bool timer_wheel_next_expiry(timer_wheel_t *, timeval_t *);
+extern unsigned timer_wheel_coalesce(timer_wheel_t *, const timeval_t *, const timeval_t *, timeval_t *);
+extern unsigned timer_wheel_expire(timer_wheel_t *, const timeval_t *, list_head_t *);
+
+#endif
@@ -0,0 +1,217 @@
+/*
+ * Soft:        Keepalived is a failover program for the LVS project
+ *              <www.linuxvirtualserver.org>. It monitor & manipulate
+ *              a loadbalanced server pool using multi-layer checks.
+ *
+ * Part:        Minimal io_uring support, used by the scheduler to batch
+ *              epoll_ctl() operations.
+ *
+ * Author:      Alexandre Cassen, <acassen@linux-vs.org>
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *              See the GNU General Public License for more details.
+ *
+ *              This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU General Public License
+ *              as published by the Free Software Foundation; either version
+ *              2 of the License, or (at your option) any later version.
+ *
+ * Copyright (C) 2026 Alexandre Cassen, <acassen@gmail.com>
+ */
+
+#include "config.h"
+
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "uring.h"
+#include "memory.h"
+
+#define URING_PROBE_OPS		256
+
+static inline int
+sys_io_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+	return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static inline int
+sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+	return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static inline int
+sys_io_uring_register(int fd, unsigned opcode, void *arg, unsigned nr_args)
+{
+	return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+/* Returns false, with errno set, if io_uring is not available */
+bool
+uring_init(uring_t *r, unsigned entries)
+{
+	struct io_uring_params p;
+	char *sq, *cq;
+	int sav_errno;
+
+	memset(r, 0, sizeof(*r));
+	memset(&p, 0, sizeof(p));
+
+	if ((r->fd = sys_io_uring_setup(entries, &p)) < 0)
+		return false;
+
+	r->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	r->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+
+	/* Since Linux 5.4 both rings are in a single mapping */
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		if (r->cq_ring_size > r->sq_ring_size)
+			r->sq_ring_size = r->cq_ring_size;
+		r->cq_ring_size = r->sq_ring_size;
+	}
+
+	r->sq_ring = mmap(NULL, r->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+	if (r->sq_ring == MAP_FAILED)
+		goto err;
+
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		r->cq_ring = r->sq_ring;
+	else {
+		r->cq_ring = mmap(NULL, r->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING);
+		if (r->cq_ring == MAP_FAILED) {
+			r->cq_ring = NULL;
+			goto err;
+		}
+	}
+
+	r->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+	r->sqes = mmap(NULL, r->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+	if (r->sqes == MAP_FAILED) {
+		r->sqes = NULL;
+		goto err;
+	}
+
+	sq = r->sq_ring;
+	r->sq_head = (unsigned *)(void *)(sq + p.sq_off.head);
+	r->sq_tail = (unsigned *)(void *)(sq + p.sq_off.tail);
+	r->sq_mask = (unsigned *)(void *)(sq + p.sq_off.ring_mask);
+	r->sq_array = (unsigned *)(void *)(sq + p.sq_off.array);
+	r->sq_entries = p.sq_entries;
+
+	cq = r->cq_ring;
+	r->cq_head = (unsigned *)(void *)(cq + p.cq_off.head);
+	r->cq_tail = (unsigned *)(void *)(cq + p.cq_off.tail);
+	r->cq_mask = (unsigned *)(void *)(cq + p.cq_off.ring_mask);
+	r->cqes = (struct io_uring_cqe *)(void *)(cq + p.cq_off.cqes);
+
+	return true;
+
+err:
+	sav_errno = errno;
+	uring_exit(r);
+	errno = sav_errno;
+
+	return false;
+}
+
+bool
+uring_op_supported(const uring_t *r, unsigned op)
+{
+	struct io_uring_probe *probe;
+	bool supported = false;
+
+	probe = MALLOC(sizeof(*probe) + URING_PROBE_OPS * sizeof(struct io_uring_probe_op));
+
+	/* IORING_REGISTER_PROBE is since Linux 5.6, as is IORING_OP_EPOLL_CTL */
+	if (!sys_io_uring_register(r->fd, IORING_REGISTER_PROBE, probe, URING_PROBE_OPS))
+		supported = op <= probe->last_op &&
+			    (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+
+	FREE(probe);
+
+	return supported;
+}
+
+/* Returns NULL if the submission queue is full */
+struct io_uring_sqe *
+uring_get_sqe(uring_t *r)
+{
+	struct io_uring_sqe *sqe;
+	unsigned tail = *r->sq_tail;
+	unsigned idx;
+
+	if (tail - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE) >= r->sq_entries)
+		return NULL;
+
+	idx = tail & *r->sq_mask;
+	sqe = &r->sqes[idx];
+	memset(sqe, 0, sizeof(*sqe));
+	r->sq_array[idx] = idx;
+
+	/* The caller fills in the sqe before it is submitted */
+	__atomic_store_n(r->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	r->to_submit++;
+
+	return sqe;
+}
+
+/* Submit the queued sqes and wait for them all to complete. Returns the
+ * number submitted or -1 with errno set. */
+int
+uring_submit_and_wait(uring_t *r)
+{
+	int ret;
+
+	if (!r->to_submit)
+		return 0;
+
+	do {
+		ret = sys_io_uring_enter(r->fd, r->to_submit, r->to_submit, IORING_ENTER_GETEVENTS);
+	} while (ret < 0 && errno == EINTR);
+
+	if (ret > 0)
+		r->to_submit -= (unsigned)ret;
+
+	return ret;
+}
+
+/* Call func for each completion, returning the number of completions */
+unsigned
+uring_reap(uring_t *r, uring_cqe_func_t func, void *arg)
+{
+	unsigned head = *r->cq_head;
+	unsigned tail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+	unsigned count = 0;
+
+	while (head != tail) {
+		func(arg, &r->cqes[head & *r->cq_mask]);
+		head++;
+		count++;
+	}
+
+	__atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+
+	return count;
+}
+
+void
+uring_exit(uring_t *r)
+{
+	if (r->sqes)
+		munmap(r->sqes, r->sqes_size);
+	if (r->cq_ring && r->cq_ring != r->sq_ring)
+		munmap(r->cq_ring, r->cq_ring_size);
+	if (r->sq_ring && r->sq_ring != MAP_FAILED)
+		munmap(r->sq_ring, r->sq_ring_size);
+	if (r->fd >= 0)
+		close(r->fd);
+
+	memset(r, 0, sizeof(*r));
+	r->fd = -1;
+}
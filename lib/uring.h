@@ -0,0 +1,68 @@
+/*
+ * Soft:        Keepalived is a failover program for the LVS project
+ *              <www.linuxvirtualserver.org>. It monitor & manipulate
+ *              a loadbalanced server pool using multi-layer checks.
+ *
+ * Part:        uring.c include file.
+ *
+ * Author:      Alexandre Cassen, <acassen@linux-vs.org>
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *              See the GNU General Public License for more details.
+ *
+ *              This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU General Public License
+ *              as published by the Free Software Foundation; either version
+ *              2 of the License, or (at your option) any later version.
+ *
+ * Copyright (C) 2026 Alexandre Cassen, <acassen@gmail.com>
+ */
+
+#ifndef _URING_H
+#define _URING_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <linux/io_uring.h>
+
+/* A minimal io_uring, using the raw syscalls so that liburing is not needed.
+ * Only one thread submits and reaps, so only the ring indices shared with
+ * the kernel need memory ordering. */
+typedef struct _uring {
+	int			fd;
+	unsigned		sq_entries;
+	unsigned		to_submit;
+
+	/* Submission queue */
+	unsigned		*sq_head;
+	unsigned		*sq_tail;
+	unsigned		*sq_mask;
+	unsigned		*sq_array;
+	struct io_uring_sqe	*sqes;
+
+	/* Completion queue */
+	unsigned		*cq_head;
+	unsigned		*cq_tail;
+	unsigned		*cq_mask;
+	struct io_uring_cqe	*cqes;
+
+	void			*sq_ring;
+	size_t			sq_ring_size;
+	void			*cq_ring;
+	size_t			cq_ring_size;
+	size_t			sqes_size;
+} uring_t;
+
+typedef void (*uring_cqe_func_t)(void *, const struct io_uring_cqe *);
+
+/* Prototypes */
+extern bool uring_init(uring_t *, unsigned);
+extern bool uring_op_supported(const uring_t *, unsigned);
+extern struct io_uring_sqe *uring_get_sqe(uring_t *);
+extern int uring_submit_and_wait(uring_t *);
+extern unsigned uring_reap(uring_t *, uring_cqe_func_t, void *);
+extern void uring_exit(uring_t *);
+
+#endif
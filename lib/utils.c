@@ -412,7 +412,7 @@ run_perf(const char *process, const char *network_namespace, const char *instanc
 
 			snprintf(buf, sizeof buf, "%d", getppid());
 			execlp("perf", "perf", "record", "-p", buf, "-q", "-g", "--call-graph", "fp", NULL);
-			exit(0);
+			_exit(0);
 		}
 
 		/* Parent */
@@ -824,7 +824,7 @@ inet_sockaddrtos2(const sockaddr_t *addr, char *addr_str)
 const char *
 inet_sockaddrtos(const sockaddr_t *addr)
 {
-	static char addr_str[INET6_ADDRSTRLEN];
+	static __thread char addr_str[INET6_ADDRSTRLEN];
 	inet_sockaddrtos2(addr, addr_str);
 	return addr_str;
 }
@@ -859,7 +859,7 @@ const char *
 inet_sockaddrtopair(const sockaddr_t *addr)
 {
 	char addr_str[INET6_ADDRSTRLEN];
-	static char ret[sizeof(addr_str) + 8];	/* '[' + addr_str + ']' + ':' + 'nnnnn' */
+	static __thread char ret[sizeof(addr_str) + 8];	/* '[' + addr_str + ']' + ':' + 'nnnnn' */
 
 	inet_sockaddrtos2(addr, addr_str);
 	snprintf(ret, sizeof(ret), "[%s]:%d"
@@ -887,7 +887,7 @@ inet_sockaddrtotrio_r(const sockaddr_t *addr, uint16_t proto, char *buf)
 const char *
 inet_sockaddrtotrio(const sockaddr_t *addr, uint16_t proto)
 {
-	static char ret[SOCKADDRTRIO_STR_LEN];
+	static __thread char ret[SOCKADDRTRIO_STR_LEN];
 
 	inet_sockaddrtotrio_r(addr, proto, ret);
 
@@ -1428,13 +1428,17 @@ keepalived_modprobe(const char *mod_name)
 	if (log_file_name)
 		flush_log_file();
 #endif
+	flush_log_queue();
 
 	do {
 		if (!(child = fork())) {
 			args.args = argv;
 			/* coverity[tainted_string] */
 			execv(argv[0], args.execve_args);
-			exit(1);
+
+			/* Don't run the atexit handlers of the parent, in
+			 * particular flushing its log queue a second time */
+			_exit(1);
 		}
 
 		rc = waitpid(child, &status, 0);
@@ -27,6 +27,22 @@
 #include "vector.h"
 #include "memory.h"
 
+/* The strvecs of the configuration lines being parsed are allocated from
+ * an arena, which the parser releases back to a mark at the end of each
+ * line or block, rather than a vector and each of its strings being
+ * MALLOCed and FREEd per line. */
+#define STRVEC_ARENA_BLOCK_SIZE	16384
+
+typedef struct _strvec_arena_block {
+	struct _strvec_arena_block *next;
+	size_t			size;
+	size_t			used;
+	char			data[] __attribute__ ((aligned(sizeof(void *))));
+} strvec_arena_block_t;
+
+static strvec_arena_block_t *arena_head;
+static strvec_arena_block_t *arena_cur;
+
 /* Function to call if attempt to read beyond end of strvec */
 static null_strvec_handler_t null_strvec_handler;
 
@@ -93,15 +109,18 @@ vector_init(unsigned int size)
 }
 #endif
 
-/* allocated one slot */
+/* allocated one slot, growing the slots geometrically */
 void
 vector_alloc_slot_r(vector_t *v)
 {
-	v->allocated += VECTOR_DEFAULT_SIZE;
-	if (v->slot)
-		v->slot = REALLOC(v->slot, sizeof(void *) * v->allocated);
-	else
-		v->slot = MALLOC(sizeof(void *) * v->allocated);
+	if (v->allocated == v->capacity) {
+		v->capacity = v->capacity ? v->capacity * 2 : VECTOR_DEFAULT_SIZE;
+		if (v->slot)
+			v->slot = REALLOC(v->slot, sizeof(void *) * v->capacity);
+		else
+			v->slot = MALLOC(sizeof(void *) * v->capacity);
+	}
+	v->allocated++;
 }
 
 /* Copy / dup a vector */
@@ -113,6 +132,7 @@ vector_copy_r(const vector_t *v)
 
 	new->active = v->active;
 	new->allocated = v->allocated;
+	new->capacity = v->allocated;
 
 	size = sizeof(void *) * (v->allocated);
 	new->slot = MALLOC(size);
@@ -129,7 +149,7 @@ vector_insert_slot(vector_t *v, unsigned int index, void *value)
 	unsigned int i;
 
 	vector_alloc_slot(v);
-	for (i = (v->allocated / VECTOR_DEFAULT_SIZE) - 2; i >= index; i--)
+	for (i = v->allocated - 2; i >= index; i--)
 		v->slot[i + 1] = v->slot[i];
 	v->slot[index] = value;
 	if (v->active >= index + 1)
@@ -311,6 +331,7 @@ vector_compact_r(const vector_t *v)
 		new = vector_alloc();
 		new->active = size;
 		new->allocated = size;
+		new->capacity = size;
 
 		new->slot = MALLOC(sizeof(void *) * size);
 
@@ -360,7 +381,7 @@ free_strvec(const vector_t *strvec)
 	unsigned int i;
 	char *str;
 
-	if (!strvec)
+	if (!strvec || strvec_in_arena(strvec))
 		return;
 
 	for (i = 0; i < vector_size(strvec); i++) {
@@ -375,15 +396,113 @@ free_strvec(const vector_t *strvec)
 vector_t *
 strvec_remove_slot(vector_t *strvec, unsigned slot)
 {
+	unsigned i, j;
+
 	if (slot > strvec->allocated || !strvec->slot[slot])
 		return strvec;
 
+	if (strvec_in_arena(strvec)) {
+		/* Compact in place, the memory is released with the arena */
+		strvec->slot[slot] = NULL;
+		for (i = 0, j = 0; i < strvec->allocated; i++) {
+			if (strvec->slot[i])
+				strvec->slot[j++] = strvec->slot[i];
+		}
+		if (!j)
+			return NULL;
+		strvec->active = strvec->allocated = j;
+
+		return strvec;
+	}
+
 	FREE(strvec->slot[slot]);
 	vector_unset(strvec, slot);
 
 	return vector_compact_r(strvec);
 }
 
+/* Allocate memory from the strvec arena. It is only freed by
+ * strvec_arena_release() or strvec_arena_free(). */
+void *
+strvec_arena_alloc(size_t size)
+{
+	strvec_arena_block_t *block;
+	void *p;
+
+	size = (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+
+	if (!arena_cur && arena_head) {
+		arena_cur = arena_head;
+		arena_cur->used = 0;
+	}
+
+	if (!arena_cur || arena_cur->used + size > arena_cur->size) {
+		if (arena_cur && arena_cur->next && arena_cur->next->size >= size)
+			block = arena_cur->next;
+		else {
+			block = MALLOC(sizeof(*block) + (size > STRVEC_ARENA_BLOCK_SIZE ? size : STRVEC_ARENA_BLOCK_SIZE));
+			block->size = size > STRVEC_ARENA_BLOCK_SIZE ? size : STRVEC_ARENA_BLOCK_SIZE;
+			if (arena_cur) {
+				block->next = arena_cur->next;
+				arena_cur->next = block;
+			} else
+				arena_head = block;
+		}
+		block->used = 0;
+		arena_cur = block;
+	}
+
+	p = arena_cur->data + arena_cur->used;
+	arena_cur->used += size;
+
+	return p;
+}
+
+strvec_arena_mark_t
+strvec_arena_mark(void)
+{
+	strvec_arena_mark_t mark = { .block = arena_cur, .used = arena_cur ? arena_cur->used : 0 };
+
+	return mark;
+}
+
+/* Release everything allocated from the arena since the mark was taken.
+ * The blocks are kept for reuse. */
+void
+strvec_arena_release(strvec_arena_mark_t mark)
+{
+	arena_cur = mark.block;
+	if (arena_cur)
+		arena_cur->used = mark.used;
+}
+
+bool
+strvec_in_arena(const vector_t *strvec)
+{
+	const strvec_arena_block_t *block;
+	const char *p = (const char *)strvec;
+
+	for (block = arena_head; block; block = block->next) {
+		if (p >= block->data && p < block->data + block->size)
+			return true;
+	}
+
+	return false;
+}
+
+void
+strvec_arena_free(void)
+{
+	strvec_arena_block_t *block, *next;
+
+	for (block = arena_head; block; block = next) {
+		next = block->next;
+		FREE(block);
+	}
+
+	arena_head = arena_cur = NULL;
+}
+
 #ifdef _INCLUDE_UNUSED_CODE_
 /* dump vector slots */
 void
@@ -25,18 +25,26 @@
 
 #include <sys/types.h>
 #include <stdio.h>
+#include <stdbool.h>
 
 /* vector definition */
 typedef struct _vector {
 	unsigned int	active;
 	unsigned int	allocated;
+	unsigned int	capacity;	/* number of slots in slot[] */
 	void		**slot;
 } vector_t;
 
+/* Position in the strvec arena to release back to */
+typedef struct _strvec_arena_mark {
+	void		*block;
+	size_t		used;
+} strvec_arena_mark_t;
+
 typedef void (*null_strvec_handler_t)(const vector_t *, size_t);
 
 /* Some defines */
-#define VECTOR_DEFAULT_SIZE 1
+#define VECTOR_DEFAULT_SIZE 4
 
 /* Some useful macros */
 #define vector_size(V)   ((V)->allocated)
@@ -84,5 +92,10 @@ extern void vector_dump(FILE *, const vector_t *);
 extern char *make_strvec_str(const vector_t *, unsigned);
 extern void free_strvec(const vector_t *);
 extern vector_t *strvec_remove_slot(vector_t *, unsigned);
+extern void *strvec_arena_alloc(size_t) __attribute__ ((malloc));
+extern strvec_arena_mark_t strvec_arena_mark(void) __attribute__ ((pure));
+extern void strvec_arena_release(strvec_arena_mark_t);
+extern bool strvec_in_arena(const vector_t *) __attribute__ ((pure));
+extern void strvec_arena_free(void);
 
 #endif
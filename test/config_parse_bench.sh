@@ -0,0 +1,74 @@
+#!/bin/bash
+
+# Benchmark of configuration parsing. A configuration with many virtual
+# servers and VRRP instances is generated, and keepalived --config-test,
+# which parses the configuration as the parent, VRRP, checker and BFD
+# processes do, is timed over a number of runs.
+#
+# Usage: config_parse_bench.sh [-v num_vs] [-r rs_per_vs] [-i num_vrrp] [-I interface] [-n runs] [-k keepalived]
+
+NUM_VS=5000
+NUM_RS=4
+NUM_VRRP=1000
+INTF=eth0
+RUNS=5
+KEEPALIVED=$(dirname $0)/../bin/keepalived
+
+while getopts ":v:r:i:I:n:k:h" opt; do
+	case $opt in
+		v)	NUM_VS=$OPTARG ;;
+		r)	NUM_RS=$OPTARG ;;
+		i)	NUM_VRRP=$OPTARG ;;
+		I)	INTF=$OPTARG ;;
+		n)	RUNS=$OPTARG ;;
+		k)	KEEPALIVED=$OPTARG ;;
+		*)	echo "Usage: $0 [-v num_vs] [-r rs_per_vs] [-i num_vrrp] [-I interface] [-n runs] [-k keepalived]"
+			exit 1 ;;
+	esac
+done
+
+CONF=$(mktemp /tmp/keepalived_bench.XXXXXX)
+trap "rm -f $CONF" EXIT
+
+awk -v num_vs=$NUM_VS -v num_rs=$NUM_RS -v num_vrrp=$NUM_VRRP -v intf=$INTF '
+BEGIN {
+	print "global_defs {\n\trouter_id bench\n\tenable_script_security\n}"
+
+	for (i = 0; i < num_vrrp; i++) {
+		printf "\nvrrp_instance VI_%d {\n\tstate BACKUP\n\tinterface %s\n", i, intf
+		printf "\tvirtual_router_id %d\n\tpriority 100\n\tadvert_int 1\n\tnopreempt\n", i % 255 + 1
+		# Each block of 255 VRIDs has its own unicast peer, so VRIDs do not conflict
+		printf "\tunicast_peer {\n\t\t172.16.%d.%d\n\t}\n", int(i / 255 / 250) % 250, int(i / 255) % 250 + 1
+		printf "\tvirtual_ipaddress {\n\t\t10.%d.%d.1/32\n\t}\n}\n", int(i / 250) % 250, i % 250
+	}
+
+	for (i = 0; i < num_vs; i++) {
+		printf "\nvirtual_server 10.%d.%d.%d 80 {\n", 100 + int(i / 62500) % 100, int(i / 250) % 250, i % 250 + 1
+		printf "\tdelay_loop 10\n\tlb_algo rr\n\tlb_kind NAT\n\tprotocol TCP\n"
+		for (r = 0; r < num_rs; r++) {
+			printf "\treal_server 192.168.%d.%d 8080 {\n\t\tweight 1\n", r % 250, i % 250 + 1
+			printf "\t\tTCP_CHECK {\n\t\t\tconnect_timeout 3\n\t\t\tretry 2\n\t\t\tdelay_before_retry 2\n\t\t}\n\t}\n"
+		}
+		print "}"
+	}
+}' >$CONF
+
+echo "$(wc -l <$CONF) lines, $NUM_VRRP VRRP instances, $NUM_VS virtual servers with $NUM_RS real servers"
+
+total=0
+for ((n = 1; n <= RUNS; n++)); do
+	start=$(date +%s%N)
+	out=$($KEEPALIVED --config-test -f $CONF 2>&1)
+	rc=$?
+	end=$(date +%s%N)
+	if [[ $rc -ne 0 ]]; then
+		echo "$out" | head -20 >&2
+		echo "keepalived --config-test exited with status $rc" >&2
+		exit 1
+	fi
+	ms=$(((end - start) / 1000000))
+	total=$((total + ms))
+	echo "run $n: $ms ms"
+done
+
+echo "mean: $((total / RUNS)) ms"
@@ -0,0 +1,218 @@
+/*
+ * Microbenchmark of the scheduler timer queue, comparing the timer
+ * rbtree with the hierarchical timing wheel (--enable-timer-wheel).
+ * Both are driven with the same random timers, and the order in which
+ * the timers expire is checked to be the same.
+ * Build and run: make timer_wheel_bench && ./timer_wheel_bench [num_timers]
+ *
+ * Copyright (C) 2026 Alexandre Cassen, <acassen@gmail.com>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "timer.h"
+#include "timer_wheel.h"
+#include "rbtree_ka.h"
+
+#define DEF_TIMERS	100000
+#define MAX_DELAY	(10 * TIMER_HZ)		/* timers are 1ms to 10s */
+#define RUN_STEP	1000			/* expire every ms */
+
+typedef struct _bench_timer {
+	timeval_t sands;
+	unsigned long seq;
+	union {
+		rb_node_t n;
+		list_head_t e_list;
+	};
+} bench_timer_t;
+
+RB_TIMER_LESS(bench_timer, n);
+
+static bench_timer_t *timers;
+static unsigned long *delays, *rearm_delays;
+static unsigned long *rb_order, *wheel_order;
+static unsigned num_timers;
+static timeval_t base;
+
+static double
+elapsed_ns(const struct timespec *start)
+{
+	struct timespec end;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (double)(end.tv_sec - start->tv_sec) * 1e9 + (double)(end.tv_nsec - start->tv_nsec);
+}
+
+static void
+report(const char *backend, const char *op, double ns, unsigned ops)
+{
+	printf("%-6s %-8s %10u ops %12.0f ns %8.1f ns/op\n", backend, op, ops, ns, ns / ops);
+}
+
+static const timeval_t *
+bench_wheel_sands(const list_head_t *e)
+{
+	return &container_of_const(e, bench_timer_t, e_list)->sands;
+}
+
+static void
+reset_timers(const unsigned long *delay)
+{
+	unsigned i;
+
+	for (i = 0; i < num_timers; i++) {
+		timers[i].sands = timer_add_long(base, delay[i]);
+		timers[i].seq = i;
+	}
+}
+
+static unsigned
+bench_rbtree(void)
+{
+	rb_root_cached_t root = RB_ROOT_CACHED;
+	struct timespec start;
+	rb_node_t *node;
+	bench_timer_t *t;
+	unsigned i, fired = 0;
+	timeval_t now;
+
+	time_now = base;
+	reset_timers(delays);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < num_timers; i++)
+		rb_add_cached(&timers[i].n, &root, bench_timer_timer_less);
+	report("rbtree", "insert", elapsed_ns(&start), num_timers);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < num_timers; i++) {
+		timers[i].sands = timer_add_long(base, rearm_delays[i]);
+		rb_move_cached(&timers[i].n, &root, bench_timer_timer_less);
+	}
+	report("rbtree", "rearm", elapsed_ns(&start), num_timers);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < num_timers; i += 2)
+		rb_erase_cached(&timers[i].n, &root);
+	report("rbtree", "cancel", elapsed_ns(&start), num_timers / 2);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (now = base; fired < num_timers / 2; now = timer_add_long(now, RUN_STEP)) {
+		while ((node = rb_first_cached(&root))) {
+			t = rb_entry(node, bench_timer_t, n);
+			if (timercmp(&now, &t->sands, <))
+				break;
+			rb_erase_cached(node, &root);
+			rb_order[fired++] = t->seq;
+		}
+	}
+	report("rbtree", "expire", elapsed_ns(&start), fired);
+
+	return fired;
+}
+
+static unsigned
+bench_wheel(void)
+{
+	static timer_wheel_t wheel;
+	struct timespec start;
+	bench_timer_t *t, *t_tmp;
+	list_head_t expired;
+	unsigned i, fired = 0;
+	unsigned wakeups = 0;
+	timeval_t now, next;
+
+	time_now = base;
+	reset_timers(delays);
+	timer_wheel_init(&wheel, bench_wheel_sands);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < num_timers; i++)
+		timer_wheel_add(&wheel, &timers[i].e_list);
+	report("wheel", "insert", elapsed_ns(&start), num_timers);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < num_timers; i++) {
+		timers[i].sands = timer_add_long(base, rearm_delays[i]);
+		timer_wheel_move(&wheel, &timers[i].e_list);
+	}
+	report("wheel", "rearm", elapsed_ns(&start), num_timers);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < num_timers; i += 2)
+		timer_wheel_del(&wheel, &timers[i].e_list);
+	report("wheel", "cancel", elapsed_ns(&start), num_timers / 2);
+
+	INIT_LIST_HEAD(&expired);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (now = base; fired < num_timers / 2; now = timer_add_long(now, RUN_STEP)) {
+		/* Only run the wheel when the scheduler would have woken */
+		if (!timer_wheel_next_expiry(&wheel, &next) || timercmp(&next, &now, >))
+			continue;
+		wakeups++;
+		timer_wheel_expire(&wheel, &now, &expired);
+		list_for_each_entry_safe(t, t_tmp, &expired, e_list) {
+			list_del_init(&t->e_list);
+			wheel_order[fired++] = t->seq;
+		}
+	}
+	report("wheel", "expire", elapsed_ns(&start), fired);
+	printf("wheel  wakeups  %10u\n", wakeups);
+
+	return fired;
+}
+
+int
+main(int argc, char **argv)
+{
+	unsigned i, rb_fired, wheel_fired;
+	int fails = 0;
+
+	num_timers = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 10) : DEF_TIMERS;
+	if (num_timers < 2)
+		num_timers = 2;
+
+	timers = calloc(num_timers, sizeof(*timers));
+	delays = calloc(num_timers, sizeof(*delays));
+	rearm_delays = calloc(num_timers, sizeof(*rearm_delays));
+	rb_order = calloc(num_timers, sizeof(*rb_order));
+	wheel_order = calloc(num_timers, sizeof(*wheel_order));
+
+	srandom(1);
+	for (i = 0; i < num_timers; i++) {
+		delays[i] = (unsigned long)random() % MAX_DELAY + 1000;
+		rearm_delays[i] = (unsigned long)random() % MAX_DELAY + 1000;
+	}
+
+	base = timer_now();
+
+	rb_fired = bench_rbtree();
+	wheel_fired = bench_wheel();
+
+	if (rb_fired != wheel_fired) {
+		printf("FAIL rbtree fired %u, wheel fired %u\n", rb_fired, wheel_fired);
+		fails++;
+	} else {
+		for (i = 0; i < rb_fired; i++) {
+			/* Timers with equal sands may legitimately differ */
+			if (rb_order[i] != wheel_order[i] &&
+			    timercmp(&timers[rb_order[i]].sands, &timers[wheel_order[i]].sands, !=)) {
+				printf("FAIL expiry order differs at %u\n", i);
+				fails++;
+				break;
+			}
+		}
+	}
+
+	printf("%s\n", fails ? "FAILURES" : "expiry order matches");
+
+	free(timers);
+	free(delays);
+	free(rearm_delays);
+	free(rb_order);
+	free(wheel_order);
+
+	return fails ? EXIT_FAILURE : EXIT_SUCCESS;
+}
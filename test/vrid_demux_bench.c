@@ -0,0 +1,296 @@
+/*
+ * Microbenchmark of the demultiplexing of received adverts to VRRP
+ * instances, comparing the per socket VRID rbtree lookup with the 256
+ * entry VRID table. A burst of adverts is read from a capture file
+ * (pcap format, Ethernet, Linux cooked or raw IP), or generated with
+ * random VRIDs, and replayed against both. The instance found for each
+ * advert is checked to be the same.
+ * Build and run: make vrid_demux_bench && ./vrid_demux_bench [capture.pcap]
+ *
+ * Copyright (C) 2026 Alexandre Cassen, <acassen@gmail.com>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "container.h"
+#include "rbtree_ka.h"
+#include "utils.h"
+
+#define DEF_BURST	4096
+#define MIN_LOOKUPS	(20 * 1000 * 1000)
+#define INST_SIZE	1024		/* roughly sizeof(vrrp_t) */
+#define IPPROTO_VRRP	112
+#define IPPROTO_AH_	51
+
+typedef struct _bench_inst {
+	uint8_t vrid;
+	unsigned idx;
+	rb_node_t rb_vrid;
+	char pad[INST_SIZE];
+} bench_inst_t;
+
+static bench_inst_t *insts[512];
+static unsigned num_insts;
+static rb_root_t rb_vrid = RB_ROOT;
+static bench_inst_t *vrid_map[256];
+static uint8_t *burst;
+static unsigned burst_len;
+
+static double
+elapsed_ns(const struct timespec *start)
+{
+	struct timespec end;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (double)(end.tv_sec - start->tv_sec) * 1e9 + (double)(end.tv_nsec - start->tv_nsec);
+}
+
+static void
+report(const char *backend, double ns, unsigned long ops, unsigned long found)
+{
+	printf("%-6s %12lu lookups %10lu found %12.0f ns %6.2f ns/lookup\n", backend, ops, found, ns, ns / ops);
+}
+
+static inline int
+vrid_cmp(const void *vrid, const rb_node_t *a)
+{
+	return less_equal_greater_than(*(const uint8_t *)vrid, rb_entry_const(a, bench_inst_t, rb_vrid)->vrid);
+}
+
+static inline bool
+vrid_less(rb_node_t *a, const rb_node_t *b)
+{
+	return rb_entry(a, bench_inst_t, rb_vrid)->vrid < rb_entry_const(b, bench_inst_t, rb_vrid)->vrid;
+}
+
+static uint32_t
+get32(const uint8_t *p, bool swap)
+{
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return swap ? __builtin_bswap32(v) : v;
+}
+
+/* Returns the VRID of an advert in a captured frame, or -1 */
+static int
+frame_vrid(const uint8_t *p, uint32_t len, uint32_t linktype)
+{
+	uint32_t off, ihl;
+	unsigned proto;
+
+	if (linktype == 1) {			/* Ethernet */
+		for (off = 12; off + 2 <= len && ((p[off] << 8) | p[off + 1]) == 0x8100; off += 4);
+		off += 2;
+	} else if (linktype == 113)		/* Linux cooked */
+		off = 16;
+	else if (linktype == 276)		/* Linux cooked v2 */
+		off = 20;
+	else if (linktype == 101 || linktype == 12)	/* raw IP */
+		off = 0;
+	else
+		return -1;
+
+	if (off >= len)
+		return -1;
+
+	if (p[off] >> 4 == 4) {
+		ihl = (p[off] & 0xf) * 4U;
+		proto = p[off + 9];
+		off += ihl;
+		if (proto == IPPROTO_AH_ && off + 2 <= len) {
+			proto = p[off];
+			off += (p[off + 1] + 2U) * 4;
+		}
+	} else if (p[off] >> 4 == 6) {
+		proto = p[off + 6];
+		off += 40;
+	} else
+		return -1;
+
+	if (proto != IPPROTO_VRRP || off + 2 > len)
+		return -1;
+
+	return p[off + 1];
+}
+
+static unsigned
+read_capture(const char *name)
+{
+	uint8_t hdr[24], rec[16], frame[65536];
+	uint32_t magic, linktype, incl_len;
+	unsigned size = 0;
+	bool swap;
+	FILE *fp;
+	int vrid;
+
+	if (!(fp = fopen(name, "r"))) {
+		perror(name);
+		return 0;
+	}
+
+	if (fread(hdr, sizeof(hdr), 1, fp) != 1) {
+		fclose(fp);
+		return 0;
+	}
+
+	memcpy(&magic, hdr, sizeof(magic));
+	swap = magic == 0xd4c3b2a1 || magic == 0x4d3cb2a1;
+	if (!swap && magic != 0xa1b2c3d4 && magic != 0xa1b23c4d) {
+		printf("%s is not a pcap file\n", name);
+		fclose(fp);
+		return 0;
+	}
+	linktype = get32(hdr + 20, swap) & 0xffff;
+
+	while (fread(rec, sizeof(rec), 1, fp) == 1) {
+		incl_len = get32(rec + 8, swap);
+		if (incl_len > sizeof(frame) || fread(frame, incl_len, 1, fp) != 1)
+			break;
+		if ((vrid = frame_vrid(frame, incl_len, linktype)) < 0)
+			continue;
+
+		if (burst_len == size) {
+			size = size ? size * 2 : 1024;
+			burst = realloc(burst, size);
+		}
+		burst[burst_len++] = (uint8_t)vrid;
+	}
+
+	fclose(fp);
+
+	return burst_len;
+}
+
+/* Instances are configured on the odd VRIDs, with a second instance, as
+ * for unicast peers sharing a VRID, on every 16th */
+static void
+alloc_instances(void)
+{
+	bench_inst_t *inst;
+	unsigned vrid, n;
+
+	for (vrid = 1; vrid < 256; vrid += 2) {
+		for (n = vrid % 16 == 1 ? 2 : 1; n; n--) {
+			inst = calloc(1, sizeof(*inst));
+			inst->vrid = (uint8_t)vrid;
+			inst->idx = num_insts;
+			insts[num_insts++] = inst;
+			rb_add(&inst->rb_vrid, &rb_vrid, vrid_less);
+		}
+	}
+
+	/* As vrrp_set_fds() */
+	rb_for_each_entry(inst, &rb_vrid, rb_vrid) {
+		if (!vrid_map[inst->vrid])
+			vrid_map[inst->vrid] = inst;
+	}
+}
+
+static unsigned long
+bench_rbtree(unsigned rounds, unsigned long *found)
+{
+	struct timespec start;
+	const bench_inst_t *inst;
+	rb_node_t *node;
+	unsigned long sum = 0;
+	unsigned r, i;
+
+	*found = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (r = 0; r < rounds; r++) {
+		for (i = 0; i < burst_len; i++) {
+			if (!(node = rb_find(&burst[i], &rb_vrid, vrid_cmp)))
+				continue;
+			inst = rb_entry_const(node, bench_inst_t, rb_vrid);
+			sum += inst->vrid;
+			(*found)++;
+		}
+	}
+	report("rbtree", elapsed_ns(&start), (unsigned long)rounds * burst_len, *found);
+
+	return sum;
+}
+
+static unsigned long
+bench_table(unsigned rounds, unsigned long *found)
+{
+	struct timespec start;
+	const bench_inst_t *inst;
+	unsigned long sum = 0;
+	unsigned r, i;
+
+	*found = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (r = 0; r < rounds; r++) {
+		for (i = 0; i < burst_len; i++) {
+			if (!(inst = vrid_map[burst[i]]))
+				continue;
+			sum += inst->vrid;
+			(*found)++;
+		}
+	}
+	report("table", elapsed_ns(&start), (unsigned long)rounds * burst_len, *found);
+
+	return sum;
+}
+
+int
+main(int argc, char **argv)
+{
+	unsigned long rb_sum, table_sum, rb_found, table_found;
+	const bench_inst_t *inst;
+	rb_node_t *node;
+	unsigned rounds, i;
+	int fails = 0;
+
+	if (argc > 1) {
+		if (!read_capture(argv[1])) {
+			printf("No adverts read from %s\n", argv[1]);
+			return EXIT_FAILURE;
+		}
+	} else {
+		burst_len = DEF_BURST;
+		burst = malloc(burst_len);
+		srandom(1);
+		for (i = 0; i < burst_len; i++)
+			burst[i] = (uint8_t)(random() % 255 + 1);
+	}
+
+	alloc_instances();
+	printf("%u adverts in burst, %u instances\n", burst_len, num_insts);
+
+	/* The first instance for each VRID must be found, since the instances
+	 * with duplicate VRIDs are walked from it */
+	for (i = 0; i < burst_len; i++) {
+		node = rb_find_first(&burst[i], &rb_vrid, vrid_cmp);
+		inst = node ? rb_entry_const(node, bench_inst_t, rb_vrid) : NULL;
+		if (inst != vrid_map[burst[i]]) {
+			printf("FAIL VRID %u: rbtree found %d, table found %d\n", burst[i],
+				inst ? (int)inst->idx : -1, vrid_map[burst[i]] ? (int)vrid_map[burst[i]]->idx : -1);
+			fails++;
+			break;
+		}
+	}
+
+	rounds = (MIN_LOOKUPS + burst_len - 1) / burst_len;
+	rb_sum = bench_rbtree(rounds, &rb_found);
+	table_sum = bench_table(rounds, &table_found);
+
+	if (rb_sum != table_sum || rb_found != table_found) {
+		printf("FAIL rbtree found %lu (sum %lu), table found %lu (sum %lu)\n", rb_found, rb_sum, table_found, table_sum);
+		fails++;
+	}
+
+	printf("%s\n", fails ? "FAILURES" : "lookups match");
+
+	for (i = 0; i < num_insts; i++)
+		free(insts[i]);
+	free(burst);
+
+	return fails ? EXIT_FAILURE : EXIT_SUCCESS;
+}